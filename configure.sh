@@ -14,6 +14,9 @@ fi
 : ${BUILD_TYPE:=${BUILD_TYPE}}
 : ${BUILD_TYPE:=DEBUG}
 
+# Set spinlock profiling build mode
+: ${LOCK_PROFILING:=OFF}
+
 # Set variables
 EXECTOS_SOURCE_DIR=$(cd `dirname ${0}` && pwd)
 EXECTOS_BINARY_DIR=build-${ARCH}-xtchain
@@ -30,7 +33,7 @@ fi
 rm -f CMakeCache.txt host-tools/CMakeCache.txt
 
 # Configure project
-cmake -G Ninja -DARCH:STRING=${ARCH} -DBUILD_TYPE:STRING=${BUILD_TYPE} "${EXECTOS_SOURCE_DIR}"
+cmake -G Ninja -DARCH:STRING=${ARCH} -DBUILD_TYPE:STRING=${BUILD_TYPE} -DLOCK_PROFILING:BOOL=${LOCK_PROFILING} "${EXECTOS_SOURCE_DIR}"
 
 # Check if configuration succeeded
 if [ ${?} -ne 0 ]; then
@@ -41,4 +41,9 @@ VOID
 ArWriteControlRegister(IN USHORT ControlRegister,
                        IN UINT_PTR Value);
 
+XTCDECL
+VOID
+ArWriteModelSpecificRegister(IN ULONG Register,
+                             IN ULONGLONG Value);
+
 #endif /* __XTDK_AMD64_ARFUNCS_H */
@@ -18,6 +18,11 @@
 #define MM_PAGE_SHIFT                              12L
 #define MM_PAGE_SIZE                               4096
 
+/* Process Context Identifiers (PCID) related definitions */
+#define MM_CR3_NO_FLUSH                            0x8000000000000000ULL
+#define MM_CR3_PCID_MASK                           0xFFF
+#define MM_PCID_COUNT                              4096
+
 /* Page directory and page base addresses */
 #define MM_PTE_BASE                                0xFFFFF68000000000UI64
 #define MM_PDE_BASE                                0xFFFFF6FB40000000UI64
@@ -38,20 +43,49 @@
 #define MM_PPE_PER_PAGE                            512
 #define MM_PXE_PER_PAGE                            512
 
+/* Large (2MB) and huge (1GB) page definitions */
+#define MM_LARGE_PAGE_SHIFT                        21
+#define MM_LARGE_PAGE_SIZE                         0x200000
+#define MM_HUGE_PAGE_SHIFT                         30
+#define MM_HUGE_PAGE_SIZE                          0x40000000
+
 /* Minimum number of physical pages needed by the system */
 #define MM_MINIMUM_PHYSICAL_PAGES                  2048
 
 /* Default number of secondary colors */
 #define MM_DEFAULT_SECONDARY_COLORS                64
 
-/* Number of HAL allocation descriptors */
-#define MM_HARDWARE_ALLOCATION_DESCRIPTORS         64
+/* Maximum number of NUMA nodes */
+#define MM_MAXIMUM_NUMA_NODES                      64
+
+/* Maximum number of free pages kept on colored lists before they are returned to the buddy allocator */
+#define MM_MAXIMUM_COLORED_FREE_PAGES              4096
+
+/* Buddy allocator orders (maximum block size and block size used to refill colored lists) */
+#define MM_MAXIMUM_BUDDY_ORDER                     18
+#define MM_REFILL_BUDDY_ORDER                      6
 
 /* Kernel HAL heap initial start address */
 #define MM_HARDWARE_HEAP_START_ADDRESS             ((PVOID)(((ULONG_PTR)MM_HARDWARE_VA_START) + 1024 * 1024))
 
-/* HAL memory pool virtual address start */
+/* HAL memory pool virtual address start and size */
 #define MM_HARDWARE_VA_START                       0xFFFFFFFFFFC00000ULL
+#define MM_HARDWARE_VA_SIZE                        0x400000ULL
+
+/* HAL large page memory pool virtual address start and size */
+#define MM_HARDWARE_LARGE_VA_START                 0xFFFFFFFF00000000ULL
+#define MM_HARDWARE_LARGE_VA_SIZE                  0xC0000000ULL
+
+/* System pages pool virtual address start and size */
+#define MM_SYSTEM_VA_START                         0xFFFFF90000000000ULL
+#define MM_SYSTEM_VA_SIZE                          0x40000000ULL
+
+/* Kernel stacks pool virtual address start and size */
+#define MM_KERNEL_STACK_VA_START                   0xFFFFF90040000000ULL
+#define MM_KERNEL_STACK_VA_SIZE                    0x40000000ULL
+
+/* PFN database virtual address start */
+#define MM_PFN_DATABASE_ADDRESS                    0xFFFFFA8000000000ULL
 
 /* Maximum physical address used by HAL allocations */
 #define MM_MAXIMUM_PHYSICAL_ADDRESS                0x00000000FFFFFFFF
@@ -240,7 +274,8 @@ typedef struct _MMPFN
         ULONG_PTR EntireFrame;
         struct
         {
-            ULONG_PTR PteFrame:58;
+            ULONG_PTR PteFrame:52;
+            ULONG_PTR NodeNumber:6;
             ULONG_PTR InPageError:1;
             ULONG_PTR VerifierAllocation:1;
             ULONG_PTR AweAllocation:1;
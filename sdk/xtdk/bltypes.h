@@ -27,6 +27,15 @@
 #define XTBL_DEBUGPORT_SCREEN                                       1
 #define XTBL_DEBUGPORT_SERIAL                                       2
 
+/* Initial number of memory mappings the page mapping structure has room for */
+#define XTBL_MEMORY_MAP_INITIAL_SIZE                                128
+
+/* XTLDR memory mapping attributes */
+#define XTBL_MAPPING_GLOBAL                                         0x01
+#define XTBL_MAPPING_LARGE_PAGES                                    0x02
+#define XTBL_MAPPING_NO_EXECUTE                                     0x04
+#define XTBL_MAPPING_READ_ONLY                                      0x08
+
 /* TUI dialog box attributes */
 #define XTBL_TUI_DIALOG_GENERIC_BOX                                 1
 #define XTBL_TUI_DIALOG_ERROR_BOX                                   2
@@ -84,7 +93,7 @@ typedef EFI_STATUS (*PBL_INVOKE_BOOT_PROTOCOL)(IN PWCHAR ShortName, IN PLIST_ENT
 typedef EFI_STATUS (*PBL_LOCATE_PROTOCOL_HANDLES)(OUT PEFI_HANDLE *Handles, OUT PUINT_PTR Count, IN PEFI_GUID ProtocolGuid);
 typedef EFI_STATUS (*PBL_LOAD_EFI_IMAGE)(IN PEFI_DEVICE_PATH_PROTOCOL DevicePath, IN PVOID ImageData, IN SIZE_T ImageSize, OUT PEFI_HANDLE ImageHandle);
 typedef EFI_STATUS (*PBL_MAP_EFI_MEMORY)(IN OUT PXTBL_PAGE_MAPPING PageMap, IN OUT PVOID *MemoryMapAddress, IN PBL_GET_MEMTYPE_ROUTINE GetMemoryTypeRoutine);
-typedef EFI_STATUS (*PBL_MAP_PAGE)(IN PXTBL_PAGE_MAPPING PageMap, IN ULONG_PTR VirtualAddress, IN ULONG_PTR PhysicalAddress, IN ULONG NumberOfPages);
+typedef EFI_STATUS (*PBL_MAP_PAGE)(IN PXTBL_PAGE_MAPPING PageMap, IN ULONG_PTR VirtualAddress, IN ULONG_PTR PhysicalAddress, IN ULONG NumberOfPages, IN ULONG Attributes);
 typedef EFI_STATUS (*PBL_MAP_VIRTUAL_MEMORY)(IN OUT PXTBL_PAGE_MAPPING PageMap, IN PVOID VirtualAddress, IN PVOID PhysicalAddress, IN ULONGLONG NumberOfPages, IN LOADER_MEMORY_TYPE MemoryType);
 typedef EFI_STATUS (*PBL_OPEN_VOLUME)(IN PEFI_DEVICE_PATH_PROTOCOL DevicePath, OUT PEFI_HANDLE DiskHandle, OUT PEFI_FILE_HANDLE *FsHandle);
 typedef EFI_STATUS (*PBL_OPEN_PROTOCOL)(OUT PEFI_HANDLE Handle, OUT PVOID *ProtocolHandler, IN PEFI_GUID ProtocolGuid);
@@ -96,6 +105,7 @@ typedef EFI_STATUS (*PBL_READ_FILE)(IN PEFI_FILE_HANDLE DirHandle, IN CONST PWCH
 typedef EFI_STATUS (*PBL_REGISTER_BOOT_PROTOCOL)(IN PWCHAR SystemType, IN PEFI_GUID BootProtocolGuid);
 typedef VOID (*PBL_REGISTER_XT_BOOT_MENU)(PVOID BootMenuRoutine);
 typedef EFI_STATUS (*PBL_SET_EFI_VARIABLE)(IN PEFI_GUID Vendor, IN PWCHAR VariableName, IN PVOID VariableValue, IN UINT_PTR Size);
+typedef EFI_STATUS (*PBL_SET_MAPPING_ATTRIBUTES)(IN OUT PXTBL_PAGE_MAPPING PageMap, IN PVOID PhysicalAddress, IN ULONGLONG NumberOfPages, IN ULONG Attributes);
 typedef VOID (XTAPI *PBL_SET_MEMORY)(OUT PVOID Destination, IN UCHAR Byte, IN SIZE_T Length);
 typedef VOID (*PBL_SLEEP_EXECUTION)(IN ULONG_PTR Milliseconds);
 typedef EFI_STATUS (*PBL_START_EFI_IMAGE)(IN EFI_HANDLE ImageHandle);
@@ -104,6 +114,7 @@ typedef VOID (*PBL_TUI_DISPLAY_INFO_DIALOG)(IN PWCHAR Caption, IN PWCHAR Message
 typedef VOID (*PBL_TUI_DISPLAY_INPUT_DIALOG)(IN PWCHAR Caption, IN PWCHAR Message, IN PWCHAR *InputFieldText);
 typedef XTBL_DIALOG_HANDLE (*PBL_TUI_DISPLAY_PROGRESS_DIALOG)(IN PWCHAR Caption, IN PWCHAR Message, IN UCHAR Percentage);
 typedef VOID (*PBL_TUI_UPDATE_PROGRESS_BAR)(IN PXTBL_DIALOG_HANDLE Handle, IN PWCHAR Message, IN UCHAR Percentage);
+typedef EFI_STATUS (*PBL_UNMAP_VIRTUAL_MEMORY)(IN OUT PXTBL_PAGE_MAPPING PageMap, IN PVOID PhysicalAddress, IN ULONGLONG NumberOfPages);
 typedef EFI_STATUS (*PBL_WAIT_FOR_EFI_EVENT)(IN UINT_PTR NumberOfEvents, IN PEFI_EVENT Event, OUT PUINT_PTR Index);
 typedef VOID (*PBL_XT_BOOT_MENU)();
 typedef VOID (XTAPI *PBL_ZERO_MEMORY)(OUT PVOID Destination, IN SIZE_T Length);
@@ -197,11 +208,11 @@ typedef struct _XTBL_KNOWN_BOOT_PROTOCOL
 /* Boot Loader memory mapping information */
 typedef struct _XTBL_MEMORY_MAPPING
 {
-    LIST_ENTRY ListEntry;
     PVOID VirtualAddress;
     PVOID PhysicalAddress;
     ULONGLONG NumberOfPages;
     LOADER_MEMORY_TYPE MemoryType;
+    ULONG Attributes;
 } XTBL_MEMORY_MAPPING, *PXTBL_MEMORY_MAPPING;
 
 /* XTLDR Module dependencies data */
@@ -237,11 +248,14 @@ typedef struct _XTBL_MODULE_INFO
 /* Boot Loader page mapping information */
 typedef struct _XTBL_PAGE_MAPPING
 {
-    LIST_ENTRY MemoryMap;
+    PXTBL_MEMORY_MAPPING MemoryMap;
     ULONG MapSize;
+    ULONG MapCapacity;
+    ULONG MapOperations;
     PVOID PtePointer;
     SHORT PageMapLevel;
     PAGE_SIZE PageSize;
+    BOOLEAN NoExecute;
 } XTBL_PAGE_MAPPING, *PXTBL_PAGE_MAPPING;
 
 /* XTLDR Status data */
@@ -399,7 +413,9 @@ typedef struct _XTBL_LOADER_PROTOCOL
         PBL_MAP_VIRTUAL_MEMORY MapVirtualMemory;
         PBL_PHYSICAL_ADDRESS_TO_VIRTUAL PhysicalAddressToVirtual;
         PBL_PHYSICAL_LIST_TO_VIRTUAL PhysicalListToVirtual;
+        PBL_SET_MAPPING_ATTRIBUTES SetMappingAttributes;
         PBL_SET_MEMORY SetMemory;
+        PBL_UNMAP_VIRTUAL_MEMORY UnmapVirtualMemory;
         PBL_ZERO_MEMORY ZeroMemory;
     } Memory;
     struct
@@ -18,14 +18,57 @@ XTFASTCALL
 BOOLEAN
 ExAcquireRundownProtection(IN PEX_RUNDOWN_REFERENCE Descriptor);
 
+XTAPI
+XTSTATUS
+ExAllocateFromCache(IN PEX_OBJECT_CACHE Cache,
+                    OUT PVOID *Object);
+
+XTAPI
+XTSTATUS
+ExAllocatePoolWithTag(IN SIZE_T NumberOfBytes,
+                      IN ULONG Tag,
+                      OUT PVOID *Memory);
+
 XTFASTCALL
 VOID
 ExCompleteRundownProtection(IN PEX_RUNDOWN_REFERENCE Descriptor);
 
+XTAPI
+XTSTATUS
+ExCreateObjectCache(IN PCWSTR Name,
+                    IN SIZE_T ObjectSize,
+                    IN SIZE_T Alignment,
+                    IN PEX_OBJECT_CONSTRUCTOR Constructor,
+                    IN PEX_OBJECT_DESTRUCTOR Destructor,
+                    IN PVOID Context,
+                    OUT PEX_OBJECT_CACHE *Cache);
+
+XTAPI
+XTSTATUS
+ExDestroyObjectCache(IN PEX_OBJECT_CACHE Cache);
+
+XTAPI
+VOID
+ExFreePool(IN PVOID Memory);
+
+XTAPI
+VOID
+ExFreePoolWithTag(IN PVOID Memory,
+                  IN ULONG Tag);
+
+XTAPI
+VOID
+ExFreeToCache(IN PEX_OBJECT_CACHE Cache,
+              IN PVOID Object);
+
 XTFASTCALL
 VOID
 ExInitializeRundownProtection(IN PEX_RUNDOWN_REFERENCE Descriptor);
 
+XTAPI
+PFN_NUMBER
+ExReclaimObjectCaches(VOID);
+
 XTFASTCALL
 VOID
 ExReInitializeRundownProtection(IN PEX_RUNDOWN_REFERENCE Descriptor);
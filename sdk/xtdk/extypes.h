@@ -17,6 +17,96 @@
 /* Rundown protection flags */
 #define EX_RUNDOWN_ACTIVE                               0x1
 
+/* Object cache definitions */
+#define EX_CACHE_MAGAZINE_SIZE                          16
+#define EX_CACHE_MAXIMUM_EMPTY_SLABS                    2
+#define EX_CACHE_MAXIMUM_SLAB_PAGES                     16
+#define EX_CACHE_MINIMUM_SLAB_OBJECTS                   8
+#define EX_CACHE_RECLAIM_THRESHOLD                      256
+
+/* Pool definitions */
+#define EX_POOL_LARGE_ALLOCATION                        0xFFFF
+#define EX_POOL_SIZE_CLASSES                            13
+#define EX_POOL_TAG_TABLE_SIZE                          512
+
+/* Object cache routine callbacks */
+typedef VOID (XTAPI *PEX_OBJECT_CONSTRUCTOR)(IN PVOID Object, IN PVOID Context);
+typedef VOID (XTAPI *PEX_OBJECT_DESTRUCTOR)(IN PVOID Object, IN PVOID Context);
+
+/* Object cache magazine structure definition */
+typedef struct _EX_CACHE_MAGAZINE
+{
+    ULONG Count;
+    PVOID Objects[EX_CACHE_MAGAZINE_SIZE];
+} EX_CACHE_MAGAZINE, *PEX_CACHE_MAGAZINE;
+
+/* Object cache per-processor layer structure definition */
+typedef struct _EX_CACHE_PROCESSOR
+{
+    PEX_CACHE_MAGAZINE Loaded;
+    PEX_CACHE_MAGAZINE Previous;
+    ULONG_PTR Hits;
+    ULONG_PTR Misses;
+    EX_CACHE_MAGAZINE Magazines[2];
+} ALIGN(CACHE_ALIGNMENT) EX_CACHE_PROCESSOR, *PEX_CACHE_PROCESSOR;
+
+/* Object cache slab header structure definition */
+typedef struct _EX_CACHE_SLAB
+{
+    LIST_ENTRY ListEntry;
+    SINGLE_LIST_ENTRY FreeListHead;
+    ULONG FreeCount;
+    ULONG ColorOffset;
+} EX_CACHE_SLAB, *PEX_CACHE_SLAB;
+
+/* Pool block header structure definition */
+typedef struct _EX_POOL_HEADER
+{
+    ULONG PoolTag;
+    USHORT PoolIndex;
+    USHORT Reserved;
+    SIZE_T BlockSize;
+} ALIGN(16) EX_POOL_HEADER, *PEX_POOL_HEADER;
+
+/* Pool tag usage structure definition */
+typedef struct _EX_POOL_TAG_ENTRY
+{
+    ULONG PoolTag;
+    LONG_PTR Allocations;
+    LONG_PTR Frees;
+    LONG_PTR BytesInUse;
+} EX_POOL_TAG_ENTRY, *PEX_POOL_TAG_ENTRY;
+
+/* Executive object cache structure definition */
+typedef struct _EX_OBJECT_CACHE
+{
+    LIST_ENTRY ListEntry;
+    PCWSTR Name;
+    SIZE_T ObjectSize;
+    SIZE_T SlotSize;
+    SIZE_T LinkOffset;
+    SIZE_T FirstObjectOffset;
+    ULONG ObjectsPerSlab;
+    ULONG SlabPages;
+    ULONG ColorCount;
+    ULONG ColorStep;
+    ULONG NextColor;
+    PEX_OBJECT_CONSTRUCTOR Constructor;
+    PEX_OBJECT_DESTRUCTOR Destructor;
+    PVOID Context;
+    KSPIN_LOCK Lock;
+    LIST_ENTRY EmptySlabs;
+    LIST_ENTRY PartialSlabs;
+    LIST_ENTRY FullSlabs;
+    ULONG EmptySlabCount;
+    ULONG_PTR SlabCount;
+    ULONG_PTR ObjectsInUse;
+    ULONG_PTR ReclaimedSlabs;
+    PFN_NUMBER DescriptorPages;
+    ULONG ProcessorCount;
+    PEX_CACHE_PROCESSOR Processors;
+} EX_OBJECT_CACHE, *PEX_OBJECT_CACHE;
+
 /* Executive rundown protection structure definition */
 typedef struct _EX_RUNDOWN_REFERENCE
 {
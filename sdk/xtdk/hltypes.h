@@ -97,6 +97,17 @@
 #define ACPI_MADT_TYPE_APLIC                        26
 #define ACPI_MADT_TYPE_PLIC                         27
 
+/* ACPI SRAT subtable type definitions */
+#define ACPI_SRAT_TYPE_CPU_AFFINITY                 0
+#define ACPI_SRAT_TYPE_MEMORY_AFFINITY              1
+#define ACPI_SRAT_TYPE_X2APIC_CPU_AFFINITY          2
+
+/* ACPI SRAT affinity flags */
+#define ACPI_SRAT_CPU_ENABLED                       0x01 /* Processor Affinity Entry Enabled */
+#define ACPI_SRAT_MEMORY_ENABLED                    0x01 /* Memory Affinity Entry Enabled */
+#define ACPI_SRAT_MEMORY_HOT_PLUGGABLE              0x02 /* Memory Hot Pluggable */
+#define ACPI_SRAT_MEMORY_NON_VOLATILE               0x04 /* Non-Volatile Memory */
+
 /* ACPI MADT Processor Local APIC Flags */
 #define ACPI_MADT_PLACE_ENABLED                     0 /* Processor Local APIC CPU Enabled */
 #define ACPI_MADT_PLAOC_ENABLED                     1 /* Processor Local APIC Online Capable */
@@ -333,6 +344,60 @@ typedef struct _ACPI_MADT_LOCAL_X2APIC
     ULONG AcpiId;
 } PACKED ACPI_MADT_LOCAL_X2APIC, *PACPI_MADT_LOCAL_X2APIC;
 
+/* ACPI System Resource Affinity Table (SRAT) structure */
+typedef struct _ACPI_SRAT
+{
+    ACPI_DESCRIPTION_HEADER Header;
+    ULONG TableRevision;
+    ULONG Reserved[2];
+    UCHAR AffinityTables[];
+} PACKED ACPI_SRAT, *PACPI_SRAT;
+
+/* ACPI Processor Local APIC Affinity SRAT subtable structure */
+typedef struct _ACPI_SRAT_CPU_AFFINITY
+{
+    ACPI_SUBTABLE_HEADER Header;
+    UCHAR ProximityDomainLow;
+    UCHAR ApicId;
+    ULONG Flags;
+    UCHAR LocalSapicEid;
+    UCHAR ProximityDomainHigh[3];
+    ULONG ClockDomain;
+} PACKED ACPI_SRAT_CPU_AFFINITY, *PACPI_SRAT_CPU_AFFINITY;
+
+/* ACPI Memory Affinity SRAT subtable structure */
+typedef struct _ACPI_SRAT_MEMORY_AFFINITY
+{
+    ACPI_SUBTABLE_HEADER Header;
+    ULONG ProximityDomain;
+    USHORT Reserved0;
+    ULONGLONG BaseAddress;
+    ULONGLONG Length;
+    ULONG Reserved1;
+    ULONG Flags;
+    ULONGLONG Reserved2;
+} PACKED ACPI_SRAT_MEMORY_AFFINITY, *PACPI_SRAT_MEMORY_AFFINITY;
+
+/* ACPI Processor Local X2APIC Affinity SRAT subtable structure */
+typedef struct _ACPI_SRAT_X2APIC_CPU_AFFINITY
+{
+    ACPI_SUBTABLE_HEADER Header;
+    USHORT Reserved0;
+    ULONG ProximityDomain;
+    ULONG ApicId;
+    ULONG Flags;
+    ULONG ClockDomain;
+    ULONG Reserved1;
+} PACKED ACPI_SRAT_X2APIC_CPU_AFFINITY, *PACPI_SRAT_X2APIC_CPU_AFFINITY;
+
+/* ACPI System Locality Information Table (SLIT) structure */
+typedef struct _ACPI_SLIT
+{
+    ACPI_DESCRIPTION_HEADER Header;
+    ULONGLONG LocalityCount;
+    UCHAR Entries[];
+} PACKED ACPI_SLIT, *PACPI_SLIT;
+
 /* ACPI System Information structure */
 typedef struct _ACPI_SYSTEM_INFO
 {
@@ -398,6 +463,7 @@ typedef struct _PROCESSOR_IDENTITY
     USHORT CpuNumber;
     BOOLEAN Bsp;
     BOOLEAN Started;
+    UCHAR NodeNumber;
 } PROCESSOR_IDENTITY, *PPROCESSOR_IDENTITY;
 
 /* SMBIOS table header structure */
@@ -54,6 +54,24 @@
 /* Initial MXCSR control */
 #define INITIAL_MXCSR                                   0x1F80
 
+/* Processor features stored in processor control block */
+#define KF_GLOBAL_PAGE                                  0x00000001
+#define KF_PCID                                         0x00000002
+#define KF_INVPCID                                      0x00000004
+#define KF_PAT                                          0x00000008
+#define KF_CLFLUSH                                      0x00000010
+
+/* Page Attributes Table types */
+#define PAT_TYPE_STRONG_UC                              0ULL
+#define PAT_TYPE_USWC                                   1ULL
+#define PAT_TYPE_WT                                     4ULL
+#define PAT_TYPE_WP                                     5ULL
+#define PAT_TYPE_WB                                     6ULL
+#define PAT_TYPE_WEAK_UC                                7ULL
+
+/* Page Attributes Table model specific register */
+#define X86_MSR_PAT                                     0x00000277
+
 /* Segment defintions */
 #define SEGMENT_CS                                      0x2E
 #define SEGMENT_DS                                      0x3E
@@ -83,6 +101,13 @@
 #define X86_EFLAGS_VIP_MASK                             0x00100000 /* Virtual Interrupt Pending */
 #define X86_EFLAGS_ID_MASK                              0x00200000 /* Identification */
 
+/* X86 page fault error code bit masks definitions */
+#define X86_PF_PRESENT_MASK                             0x00000001 /* Protection violation */
+#define X86_PF_WRITE_MASK                               0x00000002 /* Write access */
+#define X86_PF_USER_MASK                                0x00000004 /* User mode access */
+#define X86_PF_RESERVED_MASK                            0x00000008 /* Reserved bit set */
+#define X86_PF_INSTRUCTION_MASK                         0x00000010 /* Instruction fetch */
+
 /* CPU vendor enumeration list */
 typedef enum _CPU_VENDOR
 {
@@ -157,15 +182,39 @@ typedef enum _CPUID_FEATURES
     CPUID_FEATURES_EDX_PBE          = 1 << 31
 } CPUID_FEATURES, *PCPUID_FEATURES;
 
+/* CPUID structured extended features (leaf 0x00000007) enumeration list */
+typedef enum _CPUID_STANDARD7_FEATURES
+{
+    CPUID_FEATURES_LEAF7_EBX_INVPCID = 1 << 10
+} CPUID_STANDARD7_FEATURES, *PCPUID_STANDARD7_FEATURES;
+
+/* CPUID extended features (leaf 0x80000008) enumeration list */
+typedef enum _CPUID_EXTENDED_FEATURES
+{
+    CPUID_FEATURES_EXTENDED_EBX_CLZERO = 1 << 0
+} CPUID_EXTENDED_FEATURES, *PCPUID_EXTENDED_FEATURES;
+
 /* CPUID requests */
 typedef enum _CPUID_REQUESTS
 {
     CPUID_GET_VENDOR_STRING,
     CPUID_GET_CPU_FEATURES,
     CPUID_GET_TLB,
-    CPUID_GET_SERIAL
+    CPUID_GET_SERIAL,
+    CPUID_GET_STANDARD7_FEATURES = 0x00000007,
+    CPUID_GET_EXTENDED_MAXIMUM = 0x80000000,
+    CPUID_GET_EXTENDED_ADDRESS_SIZES = 0x80000008
 } CPUID_REQUESTS, *PCPUID_REQUESTS;
 
+/* INVPCID invalidation types enumeration list */
+typedef enum _INVPCID_TYPE
+{
+    InvpcidIndividualAddress,
+    InvpcidSingleContext,
+    InvpcidAllContextsWithGlobals,
+    InvpcidAllContexts
+} INVPCID_TYPE, *PINVPCID_TYPE;
+
 /* Processor identification information */
 typedef struct _CPU_IDENTIFICATION
 {
@@ -174,6 +223,8 @@ typedef struct _CPU_IDENTIFICATION
     USHORT Stepping;
     CPU_VENDOR Vendor;
     UCHAR VendorName[13];
+    ULONG FeatureBits;
+    ULONG CacheFlushSize;
 } CPU_IDENTIFICATION, *PCPU_IDENTIFICATION;
 
 /* CPUID registers */
@@ -12,6 +12,7 @@
 #include <xtbase.h>
 #include <xtstruct.h>
 #include <xttypes.h>
+#include <mmtypes.h>
 #include <potypes.h>
 #include ARCH_HEADER(xtstruct.h)
 #include ARCH_HEADER(artypes.h)
@@ -140,12 +141,15 @@
 /* XTOS Kernel stack size */
 #define KERNEL_STACK_SIZE                 0x4000
 
+/* XTOS Kernel large stack size */
+#define KERNEL_LARGE_STACK_SIZE           0xF000
+
 /* XTOS Kernel stack guard pages */
 #define KERNEL_STACK_GUARD_PAGES          1
 
 /* Processor structures size */
 #define KPROCESSOR_STRUCTURES_SIZE        ((2 * KERNEL_STACK_SIZE) + sizeof(ArInitialGdt) + sizeof(ArInitialTss) + \
-                                          sizeof(ArInitialProcessorBlock) + MM_PAGE_SIZE)
+                                          sizeof(ArInitialProcessorBlock))
 
 /* Kernel frames */
 #define KTRAP_FRAME_ALIGN                 0x08
@@ -443,7 +447,18 @@ typedef struct _KPROCESSOR_CONTROL_BLOCK
     VOLATILE BOOLEAN DpcRoutineActive;
     VOLATILE ULONG_PTR TimerRequest;
     SINGLE_LIST_ENTRY DeferredReadyListHead;
+    KSPIN_LOCK PrcbLock;
+    ULONG ReadySummary;
+    LIST_ENTRY DispatcherReadyListHead[THREAD_MAXIMUM_PRIORITY];
     PROCESSOR_POWER_STATE PowerState;
+    ULONG PageColor;
+    UCHAR NodeNumber;
+    MMPAGE_MAGAZINE PageMagazine;
+    MMSTACK_CACHE StackCache;
+    PVOID ZeroingAddress;
+#ifdef LOCKPROF
+    KLOCK_PROFILE LockProfile;
+#endif
 } KPROCESSOR_CONTROL_BLOCK, *PKPROCESSOR_CONTROL_BLOCK;
 
 /* Processor Block structure definition */
@@ -31,20 +31,51 @@
 /* PTE legacy shift values */
 #define MM_PDI_LEGACY_SHIFT                        22
 
+/* Number of PTEs per page */
+#define MM_PTE_PER_PAGE                            512
+#define MM_PDE_PER_PAGE                            512
+
+/* Large (2MB) page definitions */
+#define MM_LARGE_PAGE_SHIFT                        21
+#define MM_LARGE_PAGE_SIZE                         0x200000
+
 /* Minimum number of physical pages needed by the system */
 #define MM_MINIMUM_PHYSICAL_PAGES                  1100
 
 /* Default number of secondary colors */
 #define MM_DEFAULT_SECONDARY_COLORS                64
 
-/* Number of HAL allocation descriptors */
-#define MM_HARDWARE_ALLOCATION_DESCRIPTORS         64
+/* Maximum number of NUMA nodes */
+#define MM_MAXIMUM_NUMA_NODES                      4
+
+/* Maximum number of free pages kept on colored lists before they are returned to the buddy allocator */
+#define MM_MAXIMUM_COLORED_FREE_PAGES              4096
+
+/* Buddy allocator orders (maximum block size and block size used to refill colored lists) */
+#define MM_MAXIMUM_BUDDY_ORDER                     10
+#define MM_REFILL_BUDDY_ORDER                      6
 
 /* Kernel HAL heap initial start address */
 #define MM_HARDWARE_HEAP_START_ADDRESS             ((PVOID)(((ULONG_PTR)MM_HARDWARE_VA_START) + 1024 * 1024))
 
-/* HAL memory pool virtual address start */
+/* HAL memory pool virtual address start and size */
 #define MM_HARDWARE_VA_START                       0xFFC00000
+#define MM_HARDWARE_VA_SIZE                        0x200000
+
+/* HAL large page memory pool virtual address start and size */
+#define MM_HARDWARE_LARGE_VA_START                 0xF0000000
+#define MM_HARDWARE_LARGE_VA_SIZE                  0x0FC00000
+
+/* System pages pool virtual address start and size */
+#define MM_SYSTEM_VA_START                         0xD0000000
+#define MM_SYSTEM_VA_SIZE                          0x10000000
+
+/* Kernel stacks pool virtual address start and size */
+#define MM_KERNEL_STACK_VA_START                   0xE0000000
+#define MM_KERNEL_STACK_VA_SIZE                    0x08000000
+
+/* PFN database virtual address start */
+#define MM_PFN_DATABASE_ADDRESS                    0xB0000000
 
 /* Maximum physical address used by HAL allocations */
 #define MM_MAXIMUM_PHYSICAL_ADDRESS                0xFFFFFFFF
@@ -228,7 +259,8 @@ typedef struct _MMPFN
         ULONG_PTR EntireFrame;
         struct
         {
-            ULONG_PTR PteFrame:26;
+            ULONG_PTR PteFrame:24;
+            ULONG_PTR NodeNumber:2;
             ULONG_PTR InPageError:1;
             ULONG_PTR VerifierAllocation:1;
             ULONG_PTR AweAllocation:1;
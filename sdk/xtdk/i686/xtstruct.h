@@ -18,8 +18,11 @@ typedef enum _APIC_MODE APIC_MODE, *PAPIC_MODE;
 typedef enum _APIC_MT APIC_MT, *PAPIC_MT;
 typedef enum _APIC_REGISTER APIC_REGISTER, *PAPIC_REGISTER;
 typedef enum _CPU_VENDOR CPU_VENDOR, *PCPU_VENDOR;
+typedef enum _CPUID_EXTENDED_FEATURES CPUID_EXTENDED_FEATURES, *PCPUID_EXTENDED_FEATURES;
 typedef enum _CPUID_FEATURES CPUID_FEATURES, *PCPUID_FEATURES;
 typedef enum _CPUID_REQUESTS CPUID_REQUESTS, *PCPUID_REQUESTS;
+typedef enum _CPUID_STANDARD7_FEATURES CPUID_STANDARD7_FEATURES, *PCPUID_STANDARD7_FEATURES;
+typedef enum _INVPCID_TYPE INVPCID_TYPE, *PINVPCID_TYPE;
 typedef enum _PAGE_SIZE PAGE_SIZE, *PPAGE_SIZE;
 typedef enum _PIC_I8259_ICW1_INTERRUPT_MODE PIC_I8259_ICW1_INTERRUPT_MODE, *PPIC_I8259_ICW1_INTERRUPT_MODE;
 typedef enum _PIC_I8259_ICW1_INTERVAL PIC_I8259_ICW1_INTERVAL, *PPIC_I8259_ICW1_INTERVAL;
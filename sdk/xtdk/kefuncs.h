@@ -16,6 +16,11 @@
 
 
 /* Kernel services routines forward references */
+XTFASTCALL
+VOID
+KeAcquireInStackQueuedSpinLock(IN OUT PKSPIN_LOCK SpinLock,
+                               OUT PKLOCK_QUEUE_HANDLE LockHandle);
+
 XTFASTCALL
 VOID
 KeAcquireQueuedSpinLock(IN KSPIN_LOCK_QUEUE_LEVEL LockLevel);
@@ -24,6 +29,14 @@ XTFASTCALL
 VOID
 KeAcquireSpinLock(IN OUT PKSPIN_LOCK SpinLock);
 
+XTFASTCALL
+VOID
+KeAcquireSpinLockExclusive(IN OUT PKSHARED_SPIN_LOCK SpinLock);
+
+XTFASTCALL
+VOID
+KeAcquireSpinLockShared(IN OUT PKSHARED_SPIN_LOCK SpinLock);
+
 XTAPI
 XTSTATUS
 KeAcquireSystemResource(IN SYSTEM_RESOURCE_TYPE ResourceType,
@@ -33,6 +46,10 @@ XTAPI
 BOOLEAN
 KeCancelTimer(IN PKTIMER Timer);
 
+XTAPI
+VOID
+KeDumpLockStatistics(VOID);
+
 XTFASTCALL
 KRUNLEVEL
 KeGetCurrentRunLevel(VOID);
@@ -69,6 +86,10 @@ KeInitializeSemaphore(IN PKSEMAPHORE Semaphore,
                       IN LONG Count,
                       IN LONG Limit);
 
+XTAPI
+VOID
+KeInitializeSharedSpinLock(IN PKSHARED_SPIN_LOCK SpinLock);
+
 XTAPI
 VOID
 KeInitializeSpinLock(IN PKSPIN_LOCK SpinLock);
@@ -103,6 +124,10 @@ KeReleaseSemaphore(IN PKSEMAPHORE Semaphore,
                    IN LONG Adjustment,
                    IN BOOLEAN Wait);
 
+XTFASTCALL
+VOID
+KeReleaseInStackQueuedSpinLock(IN PKLOCK_QUEUE_HANDLE LockHandle);
+
 XTFASTCALL
 VOID
 KeReleaseQueuedSpinLock(IN KSPIN_LOCK_QUEUE_LEVEL LockLevel);
@@ -111,6 +136,14 @@ XTFASTCALL
 VOID
 KeReleaseSpinLock(IN OUT PKSPIN_LOCK SpinLock);
 
+XTFASTCALL
+VOID
+KeReleaseSpinLockExclusive(IN OUT PKSHARED_SPIN_LOCK SpinLock);
+
+XTFASTCALL
+VOID
+KeReleaseSpinLockShared(IN OUT PKSHARED_SPIN_LOCK SpinLock);
+
 XTAPI
 VOID
 KeReleaseSystemResource(IN PSYSTEM_RESOURCE_HEADER ResourceHeader);
@@ -135,4 +168,8 @@ XTAPI
 BOOLEAN
 KeSignalCallDpcSynchronize(IN PVOID SystemArgument);
 
+XTFASTCALL
+BOOLEAN
+KeTryConvertSharedSpinLockExclusive(IN OUT PKSHARED_SPIN_LOCK SpinLock);
+
 #endif /* __XTDK_KEFUNCS_H */
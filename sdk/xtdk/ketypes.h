@@ -39,6 +39,18 @@
 #define KTIMER_WAIT_BLOCK                           3
 #define SEMAPHORE_WAIT_BLOCK                        2
 
+/* Number of spinlocks tracked by the lock profiler on each processor */
+#define KLOCK_PROFILE_ENTRIES                       32
+
+/* Queued spinlock entry flags */
+#define LOCK_QUEUE_WAIT                             0x01
+#define LOCK_QUEUE_OWNER                            0x02
+
+/* Shared spinlock state bits */
+#define SHARED_SPIN_LOCK_EXCLUSIVE                  0x80000000
+#define SHARED_SPIN_LOCK_WAITING                    0x40000000
+#define SHARED_SPIN_LOCK_SHARED_MASK                0x3FFFFFFF
+
 /* Quantum values */
 #define READY_SKIP_QUANTUM                          2
 #define THREAD_QUANTUM                              6
@@ -321,6 +333,27 @@ typedef struct _KLOCK_QUEUE_HANDLE
     KRUNLEVEL OldRunLevel;
 } KLOCK_QUEUE_HANDLE, *PKLOCK_QUEUE_HANDLE;
 
+/* Spinlock profiling statistics structure definition */
+typedef struct _KLOCK_STATISTICS
+{
+    PVOID Lock;
+    PVOID MaximumSpinCallSite;
+    ULONG_PTR Acquisitions;
+    ULONG_PTR ContendedAcquisitions;
+    ULONGLONG SpinCycles;
+    ULONGLONG MaximumSpinCycles;
+    ULONGLONG HoldCycles;
+    ULONGLONG MaximumHoldCycles;
+    ULONGLONG AcquireTime;
+} KLOCK_STATISTICS, *PKLOCK_STATISTICS;
+
+/* Per-processor spinlock profiling buffer structure definition */
+typedef struct _KLOCK_PROFILE
+{
+    ULONG_PTR DroppedEvents;
+    KLOCK_STATISTICS Locks[KLOCK_PROFILE_ENTRIES];
+} KLOCK_PROFILE, *PKLOCK_PROFILE;
+
 /* Queue object structure definition */
 typedef struct _KQUEUE
 {
@@ -383,6 +416,9 @@ typedef struct _KPROCESS
     USHORT IopmOffset;
     UCHAR Iopl;
     VOLATILE KAFFINITY ActiveProcessors;
+    ULONG Pcid;
+    ULONGLONG PcidGeneration;
+    VOLATILE KAFFINITY PcidStaleProcessors;
     ULONG KernelTime;
     ULONG UserTime;
     LIST_ENTRY ReadyListHead;
@@ -0,0 +1,27 @@
+/**
+ * PROJECT:         ExectOS
+ * COPYRIGHT:       See COPYING.md in the top level directory
+ * FILE:            sdk/xtdk/mmfuncs.h
+ * DESCRIPTION:     XTOS memory manager routine definitions
+ * DEVELOPERS:      Rafal Kupiec <belliash@codingworkshop.eu.org>
+ */
+
+#ifndef __XTDK_MMFUNCS_H
+#define __XTDK_MMFUNCS_H
+
+#include <xtbase.h>
+#include <xttypes.h>
+
+
+/* Memory manager routines forward references */
+XTAPI
+VOID
+MmFreeSystemPages(IN PVOID VirtualAddress,
+                  IN PFN_NUMBER PageCount);
+
+XTAPI
+XTSTATUS
+MmReserveSystemPages(IN PFN_NUMBER PageCount,
+                     OUT PVOID *VirtualAddress);
+
+#endif /* __XTDK_MMFUNCS_H */
@@ -12,6 +12,91 @@
 #include <xtbase.h>
 
 
+/* Page Frame Number list terminator */
+#define MM_PFN_LIST_END                            ((PFN_NUMBER)-1)
+
+/* Number of pages cached in per-processor page magazine */
+#define MM_PAGE_MAGAZINE_SIZE                      32
+
+/* Number of free kernel stacks of each size cached by every processor */
+#define MM_STACK_CACHE_DEPTH                       4
+
+/* Page Attribute Table entries selected by PAT, PCD and PWT bits of a PTE, as programmed by the kernel */
+#define MM_PAT_INDEX_WRITE_BACK                    0
+#define MM_PAT_INDEX_WRITE_THROUGH                 1
+#define MM_PAT_INDEX_UNCACHED_MINUS                2
+#define MM_PAT_INDEX_UNCACHED                      3
+#define MM_PAT_INDEX_WRITE_COMBINED                5
+
+/* Software PTE protection marking reserved memory, that gets committed with zeroed pages on first access */
+#define MM_DEMAND_ZERO_PROTECTION                  0x04
+
+/* Number of pages in the aligned window committed together on a demand-zero page fault */
+#define MM_FAULT_AROUND_PAGES                      8
+
+/* Maximum number of physical memory descriptors kept by the memory manager */
+#define MM_MAXIMUM_MEMORY_DESCRIPTORS              512
+
+/* Maximum number of NUMA memory ranges and default NUMA distances */
+#define MM_MAXIMUM_NUMA_RANGES                     64
+#define MM_NUMA_LOCAL_DISTANCE                     10
+#define MM_NUMA_REMOTE_DISTANCE                    20
+
+/* Maximum number of pages invalidated one by one, before the whole TLB gets flushed */
+#define MM_TLB_FLUSH_THRESHOLD                     32
+
+/* Idle loop zeroing batch size, number of zeroed pages it tries to keep available and free pages that request it */
+#define MM_ZERO_PAGE_BATCH                         16
+#define MM_ZEROED_PAGES_TARGET                     1024
+#define MM_ZERO_PAGE_THRESHOLD                     64
+
+/* Memory caching types enumeration list */
+typedef enum _MEMORY_CACHING_TYPE
+{
+    MmNonCached,
+    MmCached,
+    MmWriteCombined,
+    MmWriteThrough,
+    MmUncachedMinus,
+    MmMaximumCacheType
+} MEMORY_CACHING_TYPE, *PMEMORY_CACHING_TYPE;
+
+/* Buddy allocator zones enumeration list */
+typedef enum _MMBUDDY_ZONE
+{
+    MmBuddyLowZone,
+    MmBuddyHighZone,
+    MmBuddyMaximumZone
+} MMBUDDY_ZONE, *PMMBUDDY_ZONE;
+
+/* Page lists enumeration list */
+typedef enum _MMPAGE_LIST
+{
+    ZeroedPageList,
+    FreePageList,
+    StandbyPageList,
+    ModifiedPageList,
+    ModifiedNoWritePageList,
+    BadPageList,
+    ActiveAndValid,
+    TransitionPage
+} MMPAGE_LIST, *PMMPAGE_LIST;
+
+/* Page zeroing methods enumeration list */
+typedef enum _MMPAGE_ZEROING_METHOD
+{
+    PageZeroingStandard,
+    PageZeroingNonTemporal,
+    PageZeroingCacheLineZero
+} MMPAGE_ZEROING_METHOD, *PMMPAGE_ZEROING_METHOD;
+
+/* Buddy allocator free area structure definition */
+typedef struct _MMBUDDY_FREE_AREA
+{
+    PFN_NUMBER ListHead[MmBuddyMaximumZone];
+    PFN_NUMBER BlockCount;
+} MMBUDDY_FREE_AREA, *PMMBUDDY_FREE_AREA;
+
 /* Color tables structure definition */
 typedef struct _MMCOLOR_TABLES
 {
@@ -20,6 +105,50 @@ typedef struct _MMCOLOR_TABLES
     ULONG_PTR Count;
 } MMCOLOR_TABLES, *PMMCOLOR_TABLES;
 
+/* Hardware memory mapping statistics structure definition */
+typedef struct _MMHARDWARE_MAPPING_STATISTICS
+{
+    ULONG_PTR SmallPages;
+    ULONG_PTR LargePages;
+    ULONG_PTR HugePages;
+    ULONG_PTR SplitPages;
+} MMHARDWARE_MAPPING_STATISTICS, *PMMHARDWARE_MAPPING_STATISTICS;
+
+/* Physical memory descriptor structure definition */
+typedef struct _MMMEMORY_DESCRIPTOR
+{
+    ULONG BasePage;
+    ULONG PageCount;
+    LOADER_MEMORY_TYPE MemoryType;
+} MMMEMORY_DESCRIPTOR, *PMMMEMORY_DESCRIPTOR;
+
+/* NUMA memory range structure definition */
+typedef struct _MMNUMA_MEMORY_RANGE
+{
+    PFN_NUMBER BasePage;
+    PFN_NUMBER PageCount;
+    ULONG NodeNumber;
+} MMNUMA_MEMORY_RANGE, *PMMNUMA_MEMORY_RANGE;
+
+/* Demand-zero page fault statistics structure definition */
+typedef struct _MMPAGE_FAULT_STATISTICS
+{
+    ULONG_PTR DemandZeroFaults;
+    ULONG_PTR FailedFaults;
+    ULONG_PTR FaultAroundPages;
+    ULONG_PTR FaultAroundUnusedPages;
+    ULONG_PTR FaultCycles;
+} MMPAGE_FAULT_STATISTICS, *PMMPAGE_FAULT_STATISTICS;
+
+/* Per-processor page magazine structure definition */
+typedef struct _MMPAGE_MAGAZINE
+{
+    ULONG Count;
+    ULONG_PTR Hits;
+    ULONG_PTR Misses;
+    PFN_NUMBER Pages[MM_PAGE_MAGAZINE_SIZE];
+} MMPAGE_MAGAZINE, *PMMPAGE_MAGAZINE;
+
 /* Page Frame Entry structure definition */
 typedef struct _MMPFNENTRY
 {
@@ -35,4 +164,23 @@ typedef struct _MMPFNENTRY
     USHORT ParityError:1;
 } MMPFNENTRY, *PMMPFNENTRY;
 
+/* Per-processor cache of free, still mapped kernel stacks structure definition */
+typedef struct _MMSTACK_CACHE
+{
+    ULONG Count[2];
+    ULONG_PTR Hits;
+    ULONG_PTR Misses;
+    PVOID Stacks[2][MM_STACK_CACHE_DEPTH];
+} MMSTACK_CACHE, *PMMSTACK_CACHE;
+
+/* TLB flush batch structure definition */
+typedef struct _MMTLB_FLUSH_BATCH
+{
+    PKPROCESS Process;
+    BOOLEAN FlushAll;
+    BOOLEAN FlushCaches;
+    ULONG Count;
+    PVOID VirtualAddress[MM_TLB_FLUSH_THRESHOLD];
+} MMTLB_FLUSH_BATCH, *PMMTLB_FLUSH_BATCH;
+
 #endif /* __XTDK_MMTYPES_H */
@@ -26,4 +26,11 @@
     #define DebugPrint(Format, ...)     ((VOID)NULL)
 #endif
 
+/* XTOS spinlock profiling macros */
+#ifdef LOCKPROF
+    #define LOCK_PROFILING              1
+#else
+    #define LOCK_PROFILING              0
+#endif
+
 #endif /* __XTDK_XTDEBUG_H */
@@ -14,7 +14,7 @@
 
 
 /* Version number of the current kernel initialization block */
-#define INITIALIZATION_BLOCK_VERSION                            1
+#define INITIALIZATION_BLOCK_VERSION                            2
 
 /* Version number of the current XTOS loader protocol */
 #define BOOT_PROTOCOL_VERSION                                   1
@@ -110,6 +110,8 @@ typedef struct _KERNEL_INITIALIZATION_BLOCK
     PWCHAR KernelParameters;
     LIST_ENTRY LoadOrderListHead;
     LIST_ENTRY MemoryDescriptorListHead;
+    PLOADER_MEMORY_DESCRIPTOR MemoryDescriptors;
+    ULONG MemoryDescriptorCount;
     LIST_ENTRY BootDriverListHead;
     LIST_ENTRY SystemResourcesListHead;
     LOADER_INFORMATION_BLOCK LoaderInformation;
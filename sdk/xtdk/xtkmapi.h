@@ -47,6 +47,7 @@
 #include <exfuncs.h>
 #include <hlfuncs.h>
 #include <kefuncs.h>
+#include <mmfuncs.h>
 #include <rtlfuncs.h>
 
 /* Architecture specific XT routines */
@@ -49,6 +49,10 @@ typedef enum _KTHREAD_STATE KTHREAD_STATE, *PKTHREAD_STATE;
 typedef enum _KTIMER_TYPE KTIMER_TYPE, *PKTIMER_TYPE;
 typedef enum _KUBSAN_DATA_TYPE KUBSAN_DATA_TYPE, *PKUBSAN_DATA_TYPE;
 typedef enum _LOADER_MEMORY_TYPE LOADER_MEMORY_TYPE, *PLOADER_MEMORY_TYPE;
+typedef enum _MEMORY_CACHING_TYPE MEMORY_CACHING_TYPE, *PMEMORY_CACHING_TYPE;
+typedef enum _MMBUDDY_ZONE MMBUDDY_ZONE, *PMMBUDDY_ZONE;
+typedef enum _MMPAGE_LIST MMPAGE_LIST, *PMMPAGE_LIST;
+typedef enum _MMPAGE_ZEROING_METHOD MMPAGE_ZEROING_METHOD, *PMMPAGE_ZEROING_METHOD;
 typedef enum _MODE MODE, *PMODE;
 typedef enum _SYSTEM_FIRMWARE_TYPE SYSTEM_FIRMWARE_TYPE, *PSYSTEM_FIRMWARE_TYPE;
 typedef enum _WAIT_TYPE WAIT_TYPE, *PWAIT_TYPE;
@@ -61,6 +65,11 @@ typedef struct _ACPI_MADT ACPI_MADT, *PACPI_MADT;
 typedef struct _ACPI_MADT_TABLE_LOCAL_APIC ACPI_MADT_TABLE_LOCAL_APIC, *PACPI_MADT_TABLE_LOCAL_APIC;
 typedef struct _ACPI_RSDP ACPI_RSDP, *PACPI_RSDP;
 typedef struct _ACPI_RSDT ACPI_RSDT, *PACPI_RSDT;
+typedef struct _ACPI_SLIT ACPI_SLIT, *PACPI_SLIT;
+typedef struct _ACPI_SRAT ACPI_SRAT, *PACPI_SRAT;
+typedef struct _ACPI_SRAT_CPU_AFFINITY ACPI_SRAT_CPU_AFFINITY, *PACPI_SRAT_CPU_AFFINITY;
+typedef struct _ACPI_SRAT_MEMORY_AFFINITY ACPI_SRAT_MEMORY_AFFINITY, *PACPI_SRAT_MEMORY_AFFINITY;
+typedef struct _ACPI_SRAT_X2APIC_CPU_AFFINITY ACPI_SRAT_X2APIC_CPU_AFFINITY, *PACPI_SRAT_X2APIC_CPU_AFFINITY;
 typedef struct _ACPI_SUBTABLE_HEADER ACPI_SUBTABLE_HEADER, *PACPI_SUBTABLE_HEADER;
 typedef struct _ACPI_SYSTEM_INFO ACPI_SYSTEM_INFO, *PACPI_SYSTEM_INFO;
 typedef struct _ACPI_TIMER_INFO ACPI_TIMER_INFO, *PACPI_TIMER_INFO;
@@ -226,6 +235,12 @@ typedef struct _EFI_VLAN_DEVICE_PATH EFI_VLAN_DEVICE_PATH, *PEFI_VLAN_DEVICE_PAT
 typedef struct _EFI_WORD_REGS EFI_WORD_REGS, *PEFI_WORD_REGS;
 typedef struct _EPROCESS EPROCESS, *PEPROCESS;
 typedef struct _ETHREAD ETHREAD, *PETHREAD;
+typedef struct _EX_CACHE_MAGAZINE EX_CACHE_MAGAZINE, *PEX_CACHE_MAGAZINE;
+typedef struct _EX_CACHE_PROCESSOR EX_CACHE_PROCESSOR, *PEX_CACHE_PROCESSOR;
+typedef struct _EX_CACHE_SLAB EX_CACHE_SLAB, *PEX_CACHE_SLAB;
+typedef struct _EX_OBJECT_CACHE EX_OBJECT_CACHE, *PEX_OBJECT_CACHE;
+typedef struct _EX_POOL_HEADER EX_POOL_HEADER, *PEX_POOL_HEADER;
+typedef struct _EX_POOL_TAG_ENTRY EX_POOL_TAG_ENTRY, *PEX_POOL_TAG_ENTRY;
 typedef struct _EX_RUNDOWN_REFERENCE EX_RUNDOWN_REFERENCE, *PEX_RUNDOWN_REFERENCE;
 typedef struct _EXCEPTION_RECORD EXCEPTION_RECORD, *PEXCEPTION_RECORD;
 typedef struct _EXCEPTION_REGISTRATION_RECORD EXCEPTION_REGISTRATION_RECORD, *PEXCEPTION_REGISTRATION_RECORD;
@@ -241,7 +256,9 @@ typedef struct _KDPC_DATA KDPC_DATA, *PKDPC_DATA;
 typedef struct _KERNEL_INITIALIZATION_BLOCK KERNEL_INITIALIZATION_BLOCK, *PKERNEL_INITIALIZATION_BLOCK;
 typedef struct _KEVENT KEVENT, *PKEVENT;
 typedef struct _KGATE KGATE, *PKGATE;
+typedef struct _KLOCK_PROFILE KLOCK_PROFILE, *PKLOCK_PROFILE;
 typedef struct _KLOCK_QUEUE_HANDLE KLOCK_QUEUE_HANDLE, *PKLOCK_QUEUE_HANDLE;
+typedef struct _KLOCK_STATISTICS KLOCK_STATISTICS, *PKLOCK_STATISTICS;
 typedef struct _KPROCESS KPROCESS, *PKPROCESS;
 typedef struct _KQUEUE KQUEUE, *PKQUEUE;
 typedef struct _KSEMAPHORE KSEMAPHORE, *PKSEMAPHORE;
@@ -268,8 +285,16 @@ typedef struct _LOADER_GRAPHICS_INFORMATION_BLOCK LOADER_GRAPHICS_INFORMATION_BL
 typedef struct _LOADER_INFORMATION_BLOCK LOADER_INFORMATION_BLOCK, *PLOADER_INFORMATION_BLOCK;
 typedef struct _LOADER_MEMORY_DESCRIPTOR LOADER_MEMORY_DESCRIPTOR, *PLOADER_MEMORY_DESCRIPTOR;
 typedef struct _M128 M128, *PM128;
+typedef struct _MMBUDDY_FREE_AREA MMBUDDY_FREE_AREA, *PMMBUDDY_FREE_AREA;
 typedef struct _MMCOLOR_TABLES MMCOLOR_TABLES, *PMMCOLOR_TABLES;
+typedef struct _MMHARDWARE_MAPPING_STATISTICS MMHARDWARE_MAPPING_STATISTICS, *PMMHARDWARE_MAPPING_STATISTICS;
+typedef struct _MMMEMORY_DESCRIPTOR MMMEMORY_DESCRIPTOR, *PMMMEMORY_DESCRIPTOR;
+typedef struct _MMNUMA_MEMORY_RANGE MMNUMA_MEMORY_RANGE, *PMMNUMA_MEMORY_RANGE;
+typedef struct _MMPAGE_FAULT_STATISTICS MMPAGE_FAULT_STATISTICS, *PMMPAGE_FAULT_STATISTICS;
+typedef struct _MMPAGE_MAGAZINE MMPAGE_MAGAZINE, *PMMPAGE_MAGAZINE;
 typedef struct _MMPFNENTRY MMPFNENTRY, *PMMPFNENTRY;
+typedef struct _MMSTACK_CACHE MMSTACK_CACHE, *PMMSTACK_CACHE;
+typedef struct _MMTLB_FLUSH_BATCH MMTLB_FLUSH_BATCH, *PMMTLB_FLUSH_BATCH;
 typedef struct _PCAT_FIRMWARE_INFORMATION PCAT_FIRMWARE_INFORMATION, *PPCAT_FIRMWARE_INFORMATION;
 typedef struct _PCI_BRIDGE_CONTROL_REGISTER PCI_BRIDGE_CONTROL_REGISTER, *PPCI_BRIDGE_CONTROL_REGISTER;
 typedef struct _PCI_COMMON_CONFIG PCI_COMMON_CONFIG, *PPCI_COMMON_CONFIG;
@@ -27,11 +27,12 @@ EFI_STATUS
 BlBuildPageMap(IN PXTBL_PAGE_MAPPING PageMap,
                IN ULONG_PTR SelfMapAddress)
 {
-    PLIST_ENTRY ListEntry, ModulesList, ModulesListEntry;
+    PLIST_ENTRY ModulesList, ModulesListEntry;
     PXTBL_MEMORY_MAPPING Mapping;
     PXTBL_MODULE_INFO ModuleInfo;
     EFI_PHYSICAL_ADDRESS Address;
     EFI_STATUS Status;
+    ULONG Index;
 
     /* Allocate pages for the Page Map */
     Status = BlAllocateMemoryPages(1, &Address);
@@ -94,13 +95,13 @@ BlBuildPageMap(IN PXTBL_PAGE_MAPPING PageMap,
         return STATUS_EFI_PROTOCOL_ERROR;
     }
 
-    /* Iterate through and map all the mappings*/
-    BlDebugPrint(L"Mapping and dumping EFI memory:\n");
-    ListEntry = PageMap->MemoryMap.Flink;
-    while(ListEntry != &PageMap->MemoryMap)
+    /* Iterate through and map all the mappings */
+    BlDebugPrint(L"Mapping and dumping EFI memory (%lu mappings, %lu mapping operations):\n",
+                 PageMap->MapSize, PageMap->MapOperations);
+    for(Index = 0; Index < PageMap->MapSize; Index++)
     {
-        /* Take mapping from the list */
-        Mapping = CONTAIN_RECORD(ListEntry, XTBL_MEMORY_MAPPING, ListEntry);
+        /* Take mapping from the array */
+        Mapping = &PageMap->MemoryMap[Index];
 
         /* Check if virtual address is set */
         if(Mapping->VirtualAddress)
@@ -111,16 +112,14 @@ BlBuildPageMap(IN PXTBL_PAGE_MAPPING PageMap,
 
             /* Map memory */
             Status = BlMapPage(PageMap, (UINT_PTR)Mapping->VirtualAddress,
-                                        (UINT_PTR)Mapping->PhysicalAddress, Mapping->NumberOfPages);
+                                        (UINT_PTR)Mapping->PhysicalAddress, Mapping->NumberOfPages,
+                                        Mapping->Attributes);
             if(Status != STATUS_EFI_SUCCESS)
             {
                 /* Memory mapping failed */
                 return Status;
             }
         }
-
-        /* Take next element */
-        ListEntry = ListEntry->Flink;
     }
 
     /* Return success */
@@ -128,7 +127,9 @@ BlBuildPageMap(IN PXTBL_PAGE_MAPPING PageMap,
 }
 
 /**
- * Does the actual virtual memory mapping.
+ * Does the actual virtual memory mapping. Page tables are cached across iterations and looked up again only when
+ * the mapping crosses the area covered by them. Identity mappings and mappings allowing large pages are done with
+ * 2MB or 1GB pages, whenever both alignment and length allow it and the page map permits such page size.
  *
  * @param PageMap
  *        Supplies a pointer to the page mapping structure.
@@ -142,6 +143,9 @@ BlBuildPageMap(IN PXTBL_PAGE_MAPPING PageMap,
  * @param NumberOfPages
  *        Supplies a number of the pages of the mapping.
  *
+ * @param Attributes
+ *        Supplies a combination of XTBL_MAPPING_* attributes of the mapping.
+ *
  * @return This routine returns a status code.
  *
  * @since XT 1.0
@@ -151,16 +155,43 @@ EFI_STATUS
 BlMapPage(IN PXTBL_PAGE_MAPPING PageMap,
           IN ULONG_PTR VirtualAddress,
           IN ULONG_PTR PhysicalAddress,
-          IN ULONG NumberOfPages)
+          IN ULONG NumberOfPages,
+          IN ULONG Attributes)
 {
     SIZE_T Pml1Entry, Pml2Entry, Pml3Entry, Pml4Entry, Pml5Entry;
     PHARDWARE_PTE Pml1, Pml2, Pml3, Pml4, Pml5;
+    HARDWARE_PTE PageEntry;
     SIZE_T PageFrameNumber;
+    PAGE_SIZE LargestPage;
     EFI_STATUS Status;
 
     /* Set the Page Frame Number (PFN) */
     PageFrameNumber = PhysicalAddress >> EFI_PAGE_SHIFT;
 
+    /* Kernel expects 4KB pages unless told otherwise, so only use large pages where it is allowed */
+    if(VirtualAddress == PhysicalAddress || (Attributes & XTBL_MAPPING_LARGE_PAGES))
+    {
+        /* Use the largest page size permitted by the page map */
+        LargestPage = PageMap->PageSize;
+    }
+    else
+    {
+        /* Use 4KB pages only */
+        LargestPage = Size4K;
+    }
+
+    /* Prepare paging entry settings shared by all pages of the mapping */
+    RtlZeroMemory(&PageEntry, sizeof(HARDWARE_PTE));
+    PageEntry.Valid = 1;
+    PageEntry.Writable = (Attributes & XTBL_MAPPING_READ_ONLY) ? 0 : 1;
+    PageEntry.Global = (Attributes & XTBL_MAPPING_GLOBAL) ? 1 : 0;
+    PageEntry.NoExecute = (PageMap->NoExecute && (Attributes & XTBL_MAPPING_NO_EXECUTE)) ? 1 : 0;
+
+    /* No page tables cached yet */
+    Pml1 = NULL;
+    Pml2 = NULL;
+    Pml3 = NULL;
+
     /* Do the recursive mapping */
     while(NumberOfPages > 0)
     {
@@ -171,57 +202,109 @@ BlMapPage(IN PXTBL_PAGE_MAPPING PageMap,
         Pml2Entry = (VirtualAddress & ((ULONGLONG)0x1FF << MM_PDI_SHIFT)) >> MM_PDI_SHIFT;
         Pml1Entry = (VirtualAddress & ((ULONGLONG)0x1FF << MM_PTI_SHIFT)) >> MM_PTI_SHIFT;
 
-        /* Check page map level */
-        if(PageMap->PageMapLevel == 5)
+        /* Check if PML3 has to be looked up, as mapping crossed the 512GB boundary */
+        if(!Pml3 || !(VirtualAddress & (((ULONGLONG)1 << MM_PXI_SHIFT) - 1)))
         {
-            /* Five level Page Map */
-            Pml5 = ((PHARDWARE_PTE)(PageMap->PtePointer));
+            /* Check page map level */
+            if(PageMap->PageMapLevel == 5)
+            {
+                /* Five level Page Map */
+                Pml5 = ((PHARDWARE_PTE)(PageMap->PtePointer));
+
+                /* Get PML4 */
+                Status = BlpGetNextPageTable(PageMap, Pml5, Pml5Entry, &Pml4);
+                if(Status != STATUS_EFI_SUCCESS)
+                {
+                    /* Memory mapping failure */
+                    return Status;
+                }
+            }
+            else
+            {
+                /* Four level Page Map */
+                Pml4 = ((PHARDWARE_PTE)(PageMap->PtePointer));
+            }
 
-            /* Get PML4 */
-            Status = BlpGetNextPageTable(PageMap, Pml5, Pml5Entry, &Pml4);
+            /* Get PML3 */
+            Status = BlpGetNextPageTable(PageMap, Pml4, Pml4Entry, &Pml3);
             if(Status != STATUS_EFI_SUCCESS)
             {
                 /* Memory mapping failure */
                 return Status;
             }
         }
-        else
+
+        /* Check if the rest of the mapping can be done with a 1GB page */
+        if(LargestPage >= Size1G && !Pml3[Pml3Entry].Valid &&
+           !((VirtualAddress | PhysicalAddress) & (MM_HUGE_PAGE_SIZE - 1)) &&
+           NumberOfPages >= (MM_HUGE_PAGE_SIZE / EFI_PAGE_SIZE))
         {
-            /* Four level Page Map */
-            Pml4 = ((PHARDWARE_PTE)(PageMap->PtePointer));
+            /* Set huge paging entry settings */
+            Pml3[Pml3Entry] = PageEntry;
+            Pml3[Pml3Entry].PageFrameNumber = PageFrameNumber;
+            Pml3[Pml3Entry].LargePage = 1;
+
+            /* Take next virtual address, physical address and PFN */
+            VirtualAddress += MM_HUGE_PAGE_SIZE;
+            PhysicalAddress += MM_HUGE_PAGE_SIZE;
+            PageFrameNumber += (MM_HUGE_PAGE_SIZE / EFI_PAGE_SIZE);
+
+            /* Decrease number of pages left */
+            NumberOfPages -= (MM_HUGE_PAGE_SIZE / EFI_PAGE_SIZE);
+            continue;
         }
 
-        /* Get PML3 */
-        Status = BlpGetNextPageTable(PageMap, Pml4, Pml4Entry, &Pml3);
-        if(Status != STATUS_EFI_SUCCESS)
+        /* Check if PML2 has to be looked up, as mapping crossed the 1GB boundary */
+        if(!Pml2 || !(VirtualAddress & (MM_HUGE_PAGE_SIZE - 1)))
         {
-            /* Memory mapping failure */
-            return Status;
+            /* Get PML2 */
+            Status = BlpGetNextPageTable(PageMap, Pml3, Pml3Entry, &Pml2);
+            if(Status != STATUS_EFI_SUCCESS)
+            {
+                /* Memory mapping failure */
+                return Status;
+            }
         }
 
-        /* Get PML 2 */
-        Status = BlpGetNextPageTable(PageMap, Pml3, Pml3Entry, &Pml2);
-        if(Status != STATUS_EFI_SUCCESS)
+        /* Check if the rest of the mapping can be done with a 2MB page */
+        if(LargestPage >= Size2M && !Pml2[Pml2Entry].Valid &&
+           !((VirtualAddress | PhysicalAddress) & (MM_LARGE_PAGE_SIZE - 1)) &&
+           NumberOfPages >= (MM_LARGE_PAGE_SIZE / EFI_PAGE_SIZE))
         {
-            /* Memory mapping failure */
-            return Status;
+            /* Set large paging entry settings */
+            Pml2[Pml2Entry] = PageEntry;
+            Pml2[Pml2Entry].PageFrameNumber = PageFrameNumber;
+            Pml2[Pml2Entry].LargePage = 1;
+
+            /* Take next virtual address, physical address and PFN */
+            VirtualAddress += MM_LARGE_PAGE_SIZE;
+            PhysicalAddress += MM_LARGE_PAGE_SIZE;
+            PageFrameNumber += (MM_LARGE_PAGE_SIZE / EFI_PAGE_SIZE);
+
+            /* Decrease number of pages left */
+            NumberOfPages -= (MM_LARGE_PAGE_SIZE / EFI_PAGE_SIZE);
+            continue;
         }
 
-        /* Get PML1 */
-        Status = BlpGetNextPageTable(PageMap, Pml2, Pml2Entry, &Pml1);
-        if(Status != STATUS_EFI_SUCCESS)
+        /* Check if PML1 has to be looked up, as mapping crossed the 2MB boundary */
+        if(!Pml1 || !(VirtualAddress & (MM_LARGE_PAGE_SIZE - 1)))
         {
-            /* Memory mapping failure */
-            return Status;
+            /* Get PML1 */
+            Status = BlpGetNextPageTable(PageMap, Pml2, Pml2Entry, &Pml1);
+            if(Status != STATUS_EFI_SUCCESS)
+            {
+                /* Memory mapping failure */
+                return Status;
+            }
         }
 
         /* Set paging entry settings */
+        Pml1[Pml1Entry] = PageEntry;
         Pml1[Pml1Entry].PageFrameNumber = PageFrameNumber;
-        Pml1[Pml1Entry].Valid = 1;
-        Pml1[Pml1Entry].Writable = 1;
 
-        /* Take next virtual address and PFN */
+        /* Take next virtual address, physical address and PFN */
         VirtualAddress += EFI_PAGE_SIZE;
+        PhysicalAddress += EFI_PAGE_SIZE;
         PageFrameNumber++;
 
         /* Decrease number of pages left */
@@ -24,7 +24,7 @@ EFI_STATUS
 BlBuildPageMap(IN PXTBL_PAGE_MAPPING PageMap,
                IN ULONG_PTR SelfMapAddress)
 {
-    PLIST_ENTRY ListEntry, ModulesList, ModulesListEntry;
+    PLIST_ENTRY ModulesList, ModulesListEntry;
     EFI_PHYSICAL_ADDRESS Address, DirectoryAddress;
     PXTBL_MODULE_INFO ModuleInfo;
     PXTBL_MEMORY_MAPPING Mapping;
@@ -114,13 +114,13 @@ BlBuildPageMap(IN PXTBL_PAGE_MAPPING PageMap,
         return STATUS_EFI_PROTOCOL_ERROR;
     }
 
-    /* Iterate through and map all the mappings*/
-    BlDebugPrint(L"Mapping and dumping EFI memory:\n");
-    ListEntry = PageMap->MemoryMap.Flink;
-    while(ListEntry != &PageMap->MemoryMap)
+    /* Iterate through and map all the mappings */
+    BlDebugPrint(L"Mapping and dumping EFI memory (%lu mappings, %lu mapping operations):\n",
+                 PageMap->MapSize, PageMap->MapOperations);
+    for(Index = 0; Index < PageMap->MapSize; Index++)
     {
-        /* Take mapping from the list */
-        Mapping = CONTAIN_RECORD(ListEntry, XTBL_MEMORY_MAPPING, ListEntry);
+        /* Take mapping from the array */
+        Mapping = &PageMap->MemoryMap[Index];
 
         /* Check if virtual address is set */
         if(Mapping->VirtualAddress)
@@ -131,16 +131,14 @@ BlBuildPageMap(IN PXTBL_PAGE_MAPPING PageMap,
 
             /* Map memory */
             Status = BlMapPage(PageMap, (UINT_PTR)Mapping->VirtualAddress,
-                                        (UINT_PTR)Mapping->PhysicalAddress, Mapping->NumberOfPages);
+                                        (UINT_PTR)Mapping->PhysicalAddress, Mapping->NumberOfPages,
+                                        Mapping->Attributes);
             if(Status != STATUS_EFI_SUCCESS)
             {
                 /* Memory mapping failed */
                 return Status;
             }
         }
-
-        /* Take next element */
-        ListEntry = ListEntry->Flink;
     }
 
     /* Return success */
@@ -162,6 +160,9 @@ BlBuildPageMap(IN PXTBL_PAGE_MAPPING PageMap,
  * @param NumberOfPages
  *        Supplies a number of the pages of the mapping.
  *
+ * @param Attributes
+ *        Supplies a combination of XTBL_MAPPING_* attributes of the mapping.
+ *
  * @return This routine returns a status code.
  *
  * @since XT 1.0
@@ -171,16 +172,25 @@ EFI_STATUS
 BlMapPage(IN PXTBL_PAGE_MAPPING PageMap,
           IN ULONG_PTR VirtualAddress,
           IN ULONG_PTR PhysicalAddress,
-          IN ULONG NumberOfPages)
+          IN ULONG NumberOfPages,
+          IN ULONG Attributes)
 {
     SIZE_T Pml1Entry, Pml2Entry, Pml3Entry;
     PHARDWARE_PTE Pml1, Pml2, Pml3;
+    HARDWARE_PTE PageEntry;
     SIZE_T PageFrameNumber;
     EFI_STATUS Status;
 
     /* Set the Page Frame Number (PFN) */
     PageFrameNumber = PhysicalAddress >> EFI_PAGE_SHIFT;
 
+    /* Prepare paging entry settings shared by all pages of the mapping */
+    RtlZeroMemory(&PageEntry, sizeof(HARDWARE_PTE));
+    PageEntry.Valid = 1;
+    PageEntry.Writable = (Attributes & XTBL_MAPPING_READ_ONLY) ? 0 : 1;
+    PageEntry.Global = (Attributes & XTBL_MAPPING_GLOBAL) ? 1 : 0;
+    PageEntry.NoExecute = (PageMap->NoExecute && (Attributes & XTBL_MAPPING_NO_EXECUTE)) ? 1 : 0;
+
     /* Do the recursive mapping */
     while(NumberOfPages > 0)
     {
@@ -218,9 +228,8 @@ BlMapPage(IN PXTBL_PAGE_MAPPING PageMap,
         }
 
         /* Set paging entry settings */
+        Pml1[Pml1Entry] = PageEntry;
         Pml1[Pml1Entry].PageFrameNumber = PageFrameNumber;
-        Pml1[Pml1Entry].Valid = 1;
-        Pml1[Pml1Entry].Writable = 1;
 
         /* Take next virtual address and PFN */
         VirtualAddress += EFI_PAGE_SIZE;
@@ -251,7 +251,8 @@ EFI_STATUS
 BlMapPage(IN PXTBL_PAGE_MAPPING PageMap,
           IN ULONG_PTR VirtualAddress,
           IN ULONG_PTR PhysicalAddress,
-          IN ULONG NumberOfPages);
+          IN ULONG NumberOfPages,
+          IN ULONG Attributes);
 
 XTCDECL
 EFI_STATUS
@@ -350,6 +351,13 @@ BlSetEfiVariable(IN PEFI_GUID Vendor,
                  IN PVOID VariableValue,
                  IN UINT_PTR Size);
 
+XTCDECL
+EFI_STATUS
+BlSetMappingAttributes(IN OUT PXTBL_PAGE_MAPPING PageMap,
+                       IN PVOID PhysicalAddress,
+                       IN ULONGLONG NumberOfPages,
+                       IN ULONG Attributes);
+
 XTCDECL
 EFI_STATUS
 BlShutdownSystem();
@@ -371,6 +379,12 @@ EFI_STATUS
 BlStartXtLoader(IN EFI_HANDLE ImageHandle,
                 IN PEFI_SYSTEM_TABLE SystemTable);
 
+XTCDECL
+EFI_STATUS
+BlUnmapVirtualMemory(IN OUT PXTBL_PAGE_MAPPING PageMap,
+                     IN PVOID PhysicalAddress,
+                     IN ULONGLONG NumberOfPages);
+
 XTCDECL
 VOID
 BlUpdateProgressBar(IN PXTBL_DIALOG_HANDLE Handle,
@@ -458,6 +472,11 @@ EFI_STATUS
 BlpFindLastBlockDeviceNode(IN PEFI_DEVICE_PATH_PROTOCOL DevicePath,
                            OUT PEFI_DEVICE_PATH_PROTOCOL *LastNode);
 
+XTCDECL
+ULONG
+BlpFindMemoryMapping(IN PXTBL_PAGE_MAPPING PageMap,
+                     IN PVOID PhysicalAddress);
+
 XTCDECL
 BOOLEAN
 BlpFindParentBlockDevice(IN PLIST_ENTRY BlockDevices,
@@ -488,6 +507,11 @@ BlpGetNextPageTable(IN PXTBL_PAGE_MAPPING PageMap,
                     IN SIZE_T Entry,
                     OUT PHARDWARE_PTE *NextPageTable);
 
+XTCDECL
+EFI_STATUS
+BlpGrowMemoryMap(IN OUT PXTBL_PAGE_MAPPING PageMap,
+                 IN ULONG NumberOfMappings);
+
 XTCDECL
 EFI_STATUS
 BlpInitializeDebugConsole();
@@ -195,29 +195,19 @@ BlGetVirtualAddress(IN PXTBL_PAGE_MAPPING PageMap,
                     IN PVOID PhysicalAddress)
 {
     PXTBL_MEMORY_MAPPING Mapping;
-    PLIST_ENTRY ListEntry;
+    ULONG Index;
 
-    /* Iterate over memory mappings in order to find descriptor containing a physical address */
-    ListEntry = PageMap->MemoryMap.Flink;
-    while(ListEntry != &PageMap->MemoryMap)
+    /* Find the first mapping ending above the physical address */
+    Index = BlpFindMemoryMapping(PageMap, PhysicalAddress);
+    if(Index < PageMap->MapSize)
     {
-        /* Get mapping from linked list */
-        Mapping = CONTAIN_RECORD(ListEntry, XTBL_MEMORY_MAPPING, ListEntry);
-
-        /* Make sure any virtual address is set */
-        if(Mapping->VirtualAddress)
+        /* Check if the mapping contains the physical address and has any virtual address set */
+        Mapping = &PageMap->MemoryMap[Index];
+        if(Mapping->VirtualAddress && (PUCHAR)PhysicalAddress >= (PUCHAR)Mapping->PhysicalAddress)
         {
-            /* Check if provided physical address is in range of this mapping */
-            if((PhysicalAddress >= Mapping->PhysicalAddress) &&
-               (PhysicalAddress < Mapping->PhysicalAddress + (Mapping->NumberOfPages * EFI_PAGE_SIZE)))
-            {
-                /* Calculate virtual address based on the mapping and return it */
-                return PhysicalAddress - Mapping->PhysicalAddress + Mapping->VirtualAddress;
-            }
+            /* Calculate virtual address based on the mapping and return it */
+            return (PUCHAR)Mapping->VirtualAddress + ((PUCHAR)PhysicalAddress - (PUCHAR)Mapping->PhysicalAddress);
         }
-
-        /* Get next element from the list */
-        ListEntry = ListEntry->Flink;
     }
 
     /* Mapping not found, return 0 */
@@ -234,7 +224,7 @@ BlGetVirtualAddress(IN PXTBL_PAGE_MAPPING PageMap,
  *        Specifies a number of of paging structures levels.
  *
  * @param PageSize
- *        Specifies a page size (currently it has no effect).
+ *        Specifies the largest page size, that can be used for identity mappings.
  *
  * @return This routine does not return any value.
  *
@@ -246,13 +236,16 @@ BlInitializePageMap(OUT PXTBL_PAGE_MAPPING PageMap,
                     IN SHORT PageMapLevel,
                     IN PAGE_SIZE PageSize)
 {
-    /* Initialize memory mappings */
-    RtlInitializeListHead(&PageMap->MemoryMap);
+    /* Initialize memory mappings, the array gets allocated on first mapping */
+    PageMap->MemoryMap = NULL;
     PageMap->MapSize = 0;
+    PageMap->MapCapacity = 0;
+    PageMap->MapOperations = 0;
 
     /* Set page map size/level and memory map address */
     PageMap->PageMapLevel = PageMapLevel;
     PageMap->PageSize = PageSize;
+    PageMap->NoExecute = FALSE;
 }
 
 /**
@@ -433,159 +426,123 @@ BlMapVirtualMemory(IN OUT PXTBL_PAGE_MAPPING PageMap,
                    IN ULONGLONG NumberOfPages,
                    IN LOADER_MEMORY_TYPE MemoryType)
 {
-    PXTBL_MEMORY_MAPPING Mapping1, Mapping2, Mapping3;
-    PVOID PhysicalAddressEnd, PhysicalAddress2End;
-    PLIST_ENTRY ListEntry, MappingListEntry;
-    SIZE_T NumberOfMappedPages;
+    XTBL_MEMORY_MAPPING Head, Tail;
+    PUCHAR MappingEnd, PhysicalEnd;
+    PXTBL_MEMORY_MAPPING Mapping;
+    ULONG First, Index, Last;
+    ULONG NumberOfMappings;
     EFI_STATUS Status;
 
-    /* Allocate memory for new mapping */
-    Status = BlAllocateMemoryPool(sizeof(XTBL_MEMORY_MAPPING), (PVOID *)&Mapping1);
-    if(Status != STATUS_EFI_SUCCESS)
+    /* Account mapping operation */
+    PageMap->MapOperations++;
+
+    /* Make sure there is anything to map */
+    if(NumberOfPages == 0)
     {
-        /* Memory allocation failure */
-        return Status;
+        /* Nothing to do */
+        return STATUS_EFI_SUCCESS;
     }
 
-    /* Set mapping fields */
-    Mapping1->PhysicalAddress = PhysicalAddress;
-    Mapping1->VirtualAddress = VirtualAddress;
-    Mapping1->NumberOfPages = NumberOfPages;
-    Mapping1->MemoryType = MemoryType;
+    /* Calculate the end of the physical address range */
+    PhysicalEnd = (PUCHAR)PhysicalAddress + (NumberOfPages * EFI_PAGE_SIZE);
 
-    /* Calculate the end of the physical address */
-    PhysicalAddressEnd = (PVOID)((ULONG_PTR)PhysicalAddress + (NumberOfPages * EFI_PAGE_SIZE) - 1);
+    /* Find the first mapping ending above the physical address, mappings before it cannot overlap */
+    First = BlpFindMemoryMapping(PageMap, PhysicalAddress);
 
-    /* Iterate through all the mappings already set to insert new mapping at the correct place */
-    ListEntry = PageMap->MemoryMap.Flink;
-    while(ListEntry != &PageMap->MemoryMap)
+    /* Validate all overlapping mappings before modifying any of them */
+    for(Last = First; Last < PageMap->MapSize && (PUCHAR)PageMap->MemoryMap[Last].PhysicalAddress < PhysicalEnd; Last++)
     {
-        /* Take a mapping from the list and calculate its end of physical address */
-        Mapping2 = CONTAIN_RECORD(ListEntry, XTBL_MEMORY_MAPPING, ListEntry);
-        PhysicalAddress2End = (PVOID)((ULONG_PTR)Mapping2->PhysicalAddress + (Mapping2->NumberOfPages * EFI_PAGE_SIZE) - 1);
+        /* Calculate the end of the physical address of overlapping mapping */
+        Mapping = &PageMap->MemoryMap[Last];
+        MappingEnd = (PUCHAR)Mapping->PhysicalAddress + (Mapping->NumberOfPages * EFI_PAGE_SIZE);
 
-        /* Check if new mapping is a subset of an existing mapping */
-        if(Mapping1->PhysicalAddress >= Mapping2->PhysicalAddress && PhysicalAddressEnd <= PhysicalAddress2End)
+        /* Check if new mapping is a subset of an existing mapping of the same memory type */
+        if(Mapping->MemoryType == MemoryType && (PUCHAR)PhysicalAddress >= (PUCHAR)Mapping->PhysicalAddress &&
+           PhysicalEnd <= MappingEnd)
         {
-            /* Make sure it's memory type is the same */
-            if(Mapping1->MemoryType == Mapping2->MemoryType)
-            {
-                /* It is already mapped */
-                return STATUS_EFI_SUCCESS;
-            }
+            /* It is already mapped */
+            return STATUS_EFI_SUCCESS;
         }
 
-        /* Check if they overlap */
-        if(PhysicalAddressEnd > Mapping2->PhysicalAddress && PhysicalAddressEnd <= PhysicalAddress2End)
+        /* Make sure it's memory type is LoaderFree */
+        if(Mapping->MemoryType != LoaderFree)
         {
-            /* Make sure it's memory type is LoaderFree */
-            if(Mapping2->MemoryType != LoaderFree)
-            {
-                /* LoaderFree memory type is strictly expected */
-                return STATUS_EFI_INVALID_PARAMETER;
-            }
-
-            /* Calculate number of pages for this mapping */
-            NumberOfMappedPages = ((PUCHAR)PhysicalAddress2End - (PUCHAR)PhysicalAddressEnd) / EFI_PAGE_SIZE;
-            if(NumberOfMappedPages > 0)
-            {
-                /* Pages associated to the mapping, allocate memory for it */
-                Status = BlAllocateMemoryPool(sizeof(XTBL_MEMORY_MAPPING), (PVOID*)&Mapping3);
-                if(Status != STATUS_EFI_SUCCESS)
-                {
-                    /* Memory allocation failure */
-                    return Status;
-                }
+            /* LoaderFree memory type is strictly expected */
+            return STATUS_EFI_INVALID_PARAMETER;
+        }
+    }
 
-                /* Set mapping fields and insert it on the top */
-                Mapping3->PhysicalAddress = (PUCHAR)PhysicalAddressEnd + 1;
-                Mapping3->VirtualAddress = NULL;
-                Mapping3->NumberOfPages = NumberOfMappedPages;
-                Mapping3->MemoryType = Mapping2->MemoryType;
-                RtlInsertHeadList(&Mapping2->ListEntry, &Mapping3->ListEntry);
-            }
+    /* Assume that overlapping mappings are fully covered */
+    Head.NumberOfPages = 0;
+    Tail.NumberOfPages = 0;
 
-            /* Calculate number of pages and the end of the physical address */
-            Mapping2->NumberOfPages = ((PUCHAR)PhysicalAddressEnd + 1 -
-                                       (PUCHAR)Mapping2->PhysicalAddress) / EFI_PAGE_SIZE;
-            PhysicalAddress2End = (PVOID)((ULONG_PTR)Mapping2->PhysicalAddress + (Mapping2->NumberOfPages * EFI_PAGE_SIZE) - 1);
+    /* Check if any mapping overlaps */
+    if(Last > First)
+    {
+        /* Check if the first overlapping mapping starts below the new one */
+        Mapping = &PageMap->MemoryMap[First];
+        if((PUCHAR)Mapping->PhysicalAddress < (PUCHAR)PhysicalAddress)
+        {
+            /* Keep the part below the new mapping */
+            Head = *Mapping;
+            Head.NumberOfPages = ((PUCHAR)PhysicalAddress - (PUCHAR)Mapping->PhysicalAddress) / EFI_PAGE_SIZE;
         }
 
-        /* Check if they overlap */
-        if(Mapping1->PhysicalAddress > Mapping2->PhysicalAddress && Mapping1->PhysicalAddress < PhysicalAddress2End)
+        /* Check if the last overlapping mapping ends above the new one */
+        Mapping = &PageMap->MemoryMap[Last - 1];
+        MappingEnd = (PUCHAR)Mapping->PhysicalAddress + (Mapping->NumberOfPages * EFI_PAGE_SIZE);
+        if(MappingEnd > PhysicalEnd)
         {
-            /* Make sure it's memory type is LoaderFree */
-            if(Mapping2->MemoryType != LoaderFree)
+            /* Keep the part above the new mapping */
+            Tail = *Mapping;
+            Tail.PhysicalAddress = PhysicalEnd;
+            Tail.NumberOfPages = (MappingEnd - PhysicalEnd) / EFI_PAGE_SIZE;
+            if(Tail.VirtualAddress)
             {
-                /* LoaderFree memory type is strictly expected */
-                return STATUS_EFI_INVALID_PARAMETER;
+                /* Keep virtual address in sync with the physical one */
+                Tail.VirtualAddress = (PUCHAR)Mapping->VirtualAddress +
+                                      (PhysicalEnd - (PUCHAR)Mapping->PhysicalAddress);
             }
-
-            /* Calculate number of pages for this mapping */
-            NumberOfMappedPages = ((PUCHAR)PhysicalAddress2End + 1 - (PUCHAR)Mapping1->PhysicalAddress) / EFI_PAGE_SIZE;
-            if(NumberOfMappedPages > 0)
-            {
-                /* Pages associated to the mapping, allocate memory for it */
-                Status = BlAllocateMemoryPool(sizeof(XTBL_MEMORY_MAPPING), (PVOID*)&Mapping3);
-                if(Status != STATUS_EFI_SUCCESS)
-                {
-                    /* Memory allocation failure */
-                    return Status;
-                }
-
-                /* Set mapping fields and insert it on the top */
-                Mapping3->PhysicalAddress = Mapping1->PhysicalAddress;
-                Mapping3->VirtualAddress = NULL;
-                Mapping3->NumberOfPages = NumberOfMappedPages;
-                Mapping3->MemoryType = Mapping2->MemoryType;
-                RtlInsertHeadList(&Mapping2->ListEntry, &Mapping3->ListEntry);
-            }
-
-            /* Calculate number of pages and the end of the physical address */
-            Mapping2->NumberOfPages = ((PUCHAR)Mapping1->PhysicalAddress -
-                                       (PUCHAR)Mapping2->PhysicalAddress) / EFI_PAGE_SIZE;
-            PhysicalAddress2End = (PVOID)((ULONG_PTR)Mapping2->PhysicalAddress + (Mapping2->NumberOfPages * EFI_PAGE_SIZE) - 1);
         }
+    }
 
-        /* Check if mapping is really needed */
-        if((Mapping2->PhysicalAddress >= Mapping1->PhysicalAddress && PhysicalAddress2End <= PhysicalAddressEnd) ||
-           (Mapping2->NumberOfPages == 0))
-        {
-            /* Make sure it's memory type is LoaderFree */
-            if(Mapping2->MemoryType != LoaderFree)
-            {
-                /* LoaderFree memory type is strictly expected */
-                return STATUS_EFI_INVALID_PARAMETER;
-            }
+    /* Overlapping mappings get replaced by the new mapping and the remaining parts of the free ones */
+    NumberOfMappings = 1 + (Head.NumberOfPages ? 1 : 0) + (Tail.NumberOfPages ? 1 : 0);
 
-            /* Store address of the next mapping */
-            MappingListEntry = ListEntry->Flink;
+    /* Make sure there is enough room in the memory map */
+    Status = BlpGrowMemoryMap(PageMap, PageMap->MapSize - (Last - First) + NumberOfMappings);
+    if(Status != STATUS_EFI_SUCCESS)
+    {
+        /* Memory allocation failure */
+        return Status;
+    }
 
-            /* Remove mapping from the list and free up it's memory */
-            RtlRemoveEntryList(&Mapping2->ListEntry);
-            Status = BlFreeMemoryPool(Mapping2);
-            ListEntry = MappingListEntry;
+    /* Move the following mappings, so the new ones fit exactly in place of the overlapping ones */
+    RtlMoveMemory(&PageMap->MemoryMap[First + NumberOfMappings], &PageMap->MemoryMap[Last],
+                  (PageMap->MapSize - Last) * sizeof(XTBL_MEMORY_MAPPING));
+    PageMap->MapSize = PageMap->MapSize - (Last - First) + NumberOfMappings;
 
-            /* Go to the next mapping */
-            continue;
-        }
+    /* Store the part of the free mapping below the new one */
+    Index = First;
+    if(Head.NumberOfPages)
+    {
+        PageMap->MemoryMap[Index++] = Head;
+    }
 
-        /* Determine physical address order */
-        if(Mapping2->PhysicalAddress > Mapping1->PhysicalAddress)
-        {
-            /* Insert new mapping in front */
-            RtlInsertHeadList(Mapping2->ListEntry.Blink, &Mapping1->ListEntry);
-            return STATUS_EFI_SUCCESS;
-        }
+    /* Store the new mapping */
+    PageMap->MemoryMap[Index].PhysicalAddress = PhysicalAddress;
+    PageMap->MemoryMap[Index].VirtualAddress = VirtualAddress;
+    PageMap->MemoryMap[Index].NumberOfPages = NumberOfPages;
+    PageMap->MemoryMap[Index].MemoryType = MemoryType;
+    PageMap->MemoryMap[Index].Attributes = 0;
+    Index++;
 
-        /* Get next mapping from the list */
-        ListEntry = ListEntry->Flink;
+    /* Store the part of the free mapping above the new one */
+    if(Tail.NumberOfPages)
+    {
+        PageMap->MemoryMap[Index] = Tail;
     }
 
-    /* Insert new mapping to the list and increase page map size */
-    RtlInsertTailList(&PageMap->MemoryMap, &Mapping1->ListEntry);
-    PageMap->MapSize++;
-
     /* Return success */
     return STATUS_EFI_SUCCESS;
 }
@@ -692,6 +649,215 @@ BlPhysicalListToVirtual(IN PXTBL_PAGE_MAPPING PageMap,
     return STATUS_EFI_SUCCESS;
 }
 
+/**
+ * Sets attributes of the page table entries, that will be created for the given physical memory range. The range
+ * has to be described by a single memory mapping, that gets split if the range does not cover it entirely.
+ *
+ * @param PageMap
+ *        Supplies a pointer to the page mapping structure.
+ *
+ * @param PhysicalAddress
+ *        Supplies a physical address of the range.
+ *
+ * @param NumberOfPages
+ *        Supplies a number of pages in the range.
+ *
+ * @param Attributes
+ *        Supplies a combination of XTBL_MAPPING_* attributes to set.
+ *
+ * @return This routine returns a status code.
+ *
+ * @since XT 1.0
+ */
+XTCDECL
+EFI_STATUS
+BlSetMappingAttributes(IN OUT PXTBL_PAGE_MAPPING PageMap,
+                       IN PVOID PhysicalAddress,
+                       IN ULONGLONG NumberOfPages,
+                       IN ULONG Attributes)
+{
+    XTBL_MEMORY_MAPPING Head, Range, Tail;
+    PUCHAR MappingEnd, PhysicalEnd;
+    PXTBL_MEMORY_MAPPING Mapping;
+    ULONG Index, NumberOfMappings;
+    EFI_STATUS Status;
+
+    /* Find the mapping containing the beginning of the range */
+    Index = BlpFindMemoryMapping(PageMap, PhysicalAddress);
+    if(Index >= PageMap->MapSize || NumberOfPages == 0)
+    {
+        /* Range not mapped, return error */
+        return STATUS_EFI_NOT_FOUND;
+    }
+
+    /* Calculate the end of the range and the end of the mapping */
+    Mapping = &PageMap->MemoryMap[Index];
+    PhysicalEnd = (PUCHAR)PhysicalAddress + (NumberOfPages * EFI_PAGE_SIZE);
+    MappingEnd = (PUCHAR)Mapping->PhysicalAddress + (Mapping->NumberOfPages * EFI_PAGE_SIZE);
+
+    /* Make sure the whole range is described by this mapping */
+    if((PUCHAR)Mapping->PhysicalAddress > (PUCHAR)PhysicalAddress || MappingEnd < PhysicalEnd)
+    {
+        /* Range spans multiple mappings, return error */
+        return STATUS_EFI_INVALID_PARAMETER;
+    }
+
+    /* Check if attributes change at all */
+    if(Mapping->Attributes == Attributes)
+    {
+        /* Nothing to do */
+        return STATUS_EFI_SUCCESS;
+    }
+
+    /* Describe the parts of the mapping below, within and above the range */
+    Head = *Mapping;
+    Head.NumberOfPages = ((PUCHAR)PhysicalAddress - (PUCHAR)Mapping->PhysicalAddress) / EFI_PAGE_SIZE;
+    Range = *Mapping;
+    Range.PhysicalAddress = PhysicalAddress;
+    Range.NumberOfPages = NumberOfPages;
+    Range.Attributes = Attributes;
+    Tail = *Mapping;
+    Tail.PhysicalAddress = PhysicalEnd;
+    Tail.NumberOfPages = (MappingEnd - PhysicalEnd) / EFI_PAGE_SIZE;
+
+    /* Keep virtual addresses in sync with the physical ones */
+    if(Mapping->VirtualAddress)
+    {
+        Range.VirtualAddress = (PUCHAR)Mapping->VirtualAddress +
+                               ((PUCHAR)PhysicalAddress - (PUCHAR)Mapping->PhysicalAddress);
+        Tail.VirtualAddress = (PUCHAR)Mapping->VirtualAddress + (PhysicalEnd - (PUCHAR)Mapping->PhysicalAddress);
+    }
+
+    /* Make sure there is enough room in the memory map for the split */
+    NumberOfMappings = 1 + (Head.NumberOfPages ? 1 : 0) + (Tail.NumberOfPages ? 1 : 0);
+    Status = BlpGrowMemoryMap(PageMap, PageMap->MapSize + NumberOfMappings - 1);
+    if(Status != STATUS_EFI_SUCCESS)
+    {
+        /* Memory allocation failure */
+        return Status;
+    }
+
+    /* Move the following mappings, so the parts fit in place of the original mapping */
+    RtlMoveMemory(&PageMap->MemoryMap[Index + NumberOfMappings], &PageMap->MemoryMap[Index + 1],
+                  (PageMap->MapSize - Index - 1) * sizeof(XTBL_MEMORY_MAPPING));
+    PageMap->MapSize += NumberOfMappings - 1;
+
+    /* Store the part of the mapping below the range */
+    if(Head.NumberOfPages)
+    {
+        PageMap->MemoryMap[Index++] = Head;
+    }
+
+    /* Store the range with new attributes */
+    PageMap->MemoryMap[Index++] = Range;
+
+    /* Store the part of the mapping above the range */
+    if(Tail.NumberOfPages)
+    {
+        PageMap->MemoryMap[Index] = Tail;
+    }
+
+    /* Return success */
+    return STATUS_EFI_SUCCESS;
+}
+
+/**
+ * Removes the physical to virtual address mapping, returning the memory range to the loader free memory.
+ *
+ * @param PageMap
+ *        Supplies a pointer to the page mapping structure.
+ *
+ * @param PhysicalAddress
+ *        Supplies a physical address the mapping starts at.
+ *
+ * @param NumberOfPages
+ *        Supplies a number of pages in the mapping.
+ *
+ * @return This routine returns a status code.
+ *
+ * @note The range has to match exactly a mapping added by BlMapVirtualMemory().
+ *
+ * @since XT 1.0
+ */
+XTCDECL
+EFI_STATUS
+BlUnmapVirtualMemory(IN OUT PXTBL_PAGE_MAPPING PageMap,
+                     IN PVOID PhysicalAddress,
+                     IN ULONGLONG NumberOfPages)
+{
+    PXTBL_MEMORY_MAPPING Mapping;
+    ULONG Index;
+
+    /* Find the mapping starting at the physical address */
+    Index = BlpFindMemoryMapping(PageMap, PhysicalAddress);
+    if(Index >= PageMap->MapSize)
+    {
+        /* Range not mapped, return error */
+        return STATUS_EFI_NOT_FOUND;
+    }
+
+    /* Make sure the range describes the whole mapping */
+    Mapping = &PageMap->MemoryMap[Index];
+    if(Mapping->PhysicalAddress != PhysicalAddress || Mapping->NumberOfPages != NumberOfPages)
+    {
+        /* Range does not match the mapping, return error */
+        return STATUS_EFI_INVALID_PARAMETER;
+    }
+
+    /* Turn the mapping back into loader free memory */
+    Mapping->VirtualAddress = NULL;
+    Mapping->MemoryType = LoaderFree;
+    Mapping->Attributes = 0;
+
+    /* Return success */
+    return STATUS_EFI_SUCCESS;
+}
+
+/**
+ * Finds the first memory mapping, that ends above the given physical address, using binary search.
+ *
+ * @param PageMap
+ *        Supplies a pointer to the page mapping structure.
+ *
+ * @param PhysicalAddress
+ *        Supplies a physical address to search for.
+ *
+ * @return This routine returns an index of the mapping, or the number of mappings if there is no such mapping.
+ *
+ * @since XT 1.0
+ */
+XTCDECL
+ULONG
+BlpFindMemoryMapping(IN PXTBL_PAGE_MAPPING PageMap,
+                     IN PVOID PhysicalAddress)
+{
+    PXTBL_MEMORY_MAPPING Mapping;
+    ULONG High, Low, Middle;
+
+    /* Mappings never overlap, so they are sorted by both start and end of the physical address */
+    Low = 0;
+    High = PageMap->MapSize;
+    while(Low < High)
+    {
+        /* Check if mapping in the middle ends at or below the physical address */
+        Middle = Low + ((High - Low) / 2);
+        Mapping = &PageMap->MemoryMap[Middle];
+        if((PUCHAR)Mapping->PhysicalAddress + (Mapping->NumberOfPages * EFI_PAGE_SIZE) <= (PUCHAR)PhysicalAddress)
+        {
+            /* Look in the upper half */
+            Low = Middle + 1;
+        }
+        else
+        {
+            /* Look in the lower half */
+            High = Middle;
+        }
+    }
+
+    /* Return mapping index */
+    return Low;
+}
+
 /**
  * Converts EFI memory type to XTLDR memory type.
  *
@@ -770,6 +936,13 @@ BlpGetNextPageTable(IN PXTBL_PAGE_MAPPING PageMap,
     ULONGLONG PmlPointer;
     EFI_STATUS Status;
 
+    /* Check if entry maps a large page instead of pointing to the next table */
+    if(PageTable[Entry].Valid && PageTable[Entry].LargePage)
+    {
+        /* Area already mapped with a large page, return error */
+        return STATUS_EFI_INVALID_PARAMETER;
+    }
+
     /* Check if this is a valid table */
     if(PageTable[Entry].Valid)
     {
@@ -811,3 +984,63 @@ BlpGetNextPageTable(IN PXTBL_PAGE_MAPPING PageMap,
     /* Return success */
     return STATUS_EFI_SUCCESS;
 }
+
+/**
+ * Makes sure the memory map array has room for the given number of mappings, growing it if needed.
+ *
+ * @param PageMap
+ *        Supplies a pointer to the page mapping structure.
+ *
+ * @param NumberOfMappings
+ *        Supplies the number of mappings the array has to hold.
+ *
+ * @return This routine returns a status code.
+ *
+ * @since XT 1.0
+ */
+XTCDECL
+EFI_STATUS
+BlpGrowMemoryMap(IN OUT PXTBL_PAGE_MAPPING PageMap,
+                 IN ULONG NumberOfMappings)
+{
+    PXTBL_MEMORY_MAPPING MemoryMap;
+    EFI_STATUS Status;
+    ULONG Capacity;
+
+    /* Check if there is enough room already */
+    if(NumberOfMappings <= PageMap->MapCapacity)
+    {
+        /* Nothing to do */
+        return STATUS_EFI_SUCCESS;
+    }
+
+    /* Double the capacity, so the number of reallocations stays logarithmic */
+    Capacity = PageMap->MapCapacity ? PageMap->MapCapacity : XTBL_MEMORY_MAP_INITIAL_SIZE;
+    while(Capacity < NumberOfMappings)
+    {
+        Capacity *= 2;
+    }
+
+    /* Allocate memory for the new array */
+    Status = BlAllocateMemoryPool(Capacity * sizeof(XTBL_MEMORY_MAPPING), (PVOID *)&MemoryMap);
+    if(Status != STATUS_EFI_SUCCESS)
+    {
+        /* Memory allocation failure */
+        return Status;
+    }
+
+    /* Check if there is any array already */
+    if(PageMap->MemoryMap)
+    {
+        /* Copy existing mappings and free the old array */
+        RtlCopyMemory(MemoryMap, PageMap->MemoryMap, PageMap->MapSize * sizeof(XTBL_MEMORY_MAPPING));
+        BlFreeMemoryPool(PageMap->MemoryMap);
+    }
+
+    /* Use the new array */
+    PageMap->MemoryMap = MemoryMap;
+    PageMap->MapCapacity = Capacity;
+
+    /* Return success */
+    return STATUS_EFI_SUCCESS;
+}
@@ -343,9 +343,10 @@ PeLoadImage(IN PEFI_FILE_HANDLE FileHandle,
             OUT PVOID *ImagePointer)
 {
     EFI_GUID FileInfoGuid = EFI_FILE_INFO_PROTOCOL_GUID;
+    EFI_PHYSICAL_ADDRESS Address, AlignedAddress;
     PPECOFF_IMAGE_SECTION_HEADER SectionHeader;
     PPECOFF_IMAGE_CONTEXT ImageData;
-    EFI_PHYSICAL_ADDRESS Address;
+    SIZE_T AlignPages, HeadPages;
     PEFI_FILE_INFO FileInfo;
     UINT_PTR ReadSize;
     EFI_STATUS Status;
@@ -471,8 +472,11 @@ PeLoadImage(IN PEFI_FILE_HANDLE FileHandle,
     /* Calculate number of image pages */
     ImageData->ImagePages = EFI_SIZE_TO_PAGES(ImageData->ImageSize);
 
+    /* Images spanning a large page get aligned physically, so they can be mapped with large pages */
+    AlignPages = (ImageData->ImageSize >= MM_LARGE_PAGE_SIZE) ? (MM_LARGE_PAGE_SIZE / EFI_PAGE_SIZE) - 1 : 0;
+
     /* Allocate image pages */
-    Status = XtLdrProtocol->Memory.AllocatePages(ImageData->ImagePages, &Address);
+    Status = XtLdrProtocol->Memory.AllocatePages(ImageData->ImagePages + AlignPages, &Address);
     if(Status != STATUS_EFI_SUCCESS)
     {
         /* Pages reallocation failure */
@@ -481,6 +485,30 @@ PeLoadImage(IN PEFI_FILE_HANDLE FileHandle,
         return Status;
     }
 
+    /* Check if image has to be aligned */
+    if(AlignPages)
+    {
+        /* Align image to the large page boundary */
+        AlignedAddress = ROUND_UP(Address, MM_LARGE_PAGE_SIZE);
+        HeadPages = (AlignedAddress - Address) / EFI_PAGE_SIZE;
+
+        /* Free pages left below the image */
+        if(HeadPages)
+        {
+            XtLdrProtocol->Memory.FreePages(HeadPages, Address);
+        }
+
+        /* Free pages left above the image */
+        if(AlignPages > HeadPages)
+        {
+            XtLdrProtocol->Memory.FreePages(AlignPages - HeadPages,
+                                            AlignedAddress + (ImageData->ImagePages * EFI_PAGE_SIZE));
+        }
+
+        /* Use aligned address */
+        Address = AlignedAddress;
+    }
+
     /* Store image data and virtual address */
     ImageData->Data = (PUINT8)(UINT_PTR)Address;
     ImageData->PhysicalAddress = (PVOID)(UINT_PTR)Address;
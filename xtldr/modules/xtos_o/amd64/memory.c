@@ -135,8 +135,38 @@ XTCDECL
 EFI_STATUS
 XtEnablePaging(IN PXTBL_PAGE_MAPPING PageMap)
 {
+    CPUID_REGISTERS CpuRegisters;
     EFI_STATUS Status;
 
+    /* Large pages are always supported, so identity mapping can use at least 2MB pages */
+    PageMap->PageSize = Size2M;
+
+    /* Get highest supported extended CPUID leaf */
+    CpuRegisters.Leaf = CPUID_GET_EXTENDED_MAXIMUM;
+    CpuRegisters.SubLeaf = 0;
+    ArCpuId(&CpuRegisters);
+
+    /* Check if extended features are reported */
+    if(CpuRegisters.Eax >= CPUID_GET_EXTENDED_FEATURES)
+    {
+        /* Check if 1GB pages are supported */
+        CpuRegisters.Leaf = CPUID_GET_EXTENDED_FEATURES;
+        CpuRegisters.SubLeaf = 0;
+        ArCpuId(&CpuRegisters);
+        if(CpuRegisters.Edx & CPUID_FEATURES_EXTENDED_EDX_PAGE1GB)
+        {
+            /* Allow mapping memory with 1GB pages */
+            PageMap->PageSize = Size1G;
+        }
+
+        /* Check if No-Execute pages are supported */
+        if(CpuRegisters.Edx & CPUID_FEATURES_EXTENDED_EDX_NX)
+        {
+            /* Allow marking non-executable memory */
+            PageMap->NoExecute = TRUE;
+        }
+    }
+
     /* Build page map */
     Status = XtLdrProtocol->Memory.BuildPageMap(PageMap, 0xFFFFF6FB7DBED000);
     if(Status != STATUS_EFI_SUCCESS)
@@ -165,6 +195,13 @@ XtEnablePaging(IN PXTBL_PAGE_MAPPING PageMap)
         return STATUS_EFI_ABORTED;
     }
 
+    /* Check if non-executable pages are in use */
+    if(PageMap->NoExecute)
+    {
+        /* Enable No-Execute (NXE) in EFER MSR, otherwise NX bit is reserved */
+        ArWriteModelSpecificRegister(X86_MSR_EFER, ArReadModelSpecificRegister(X86_MSR_EFER) | X86_MSR_EFER_NXE);
+    }
+
     /* Write PML4 to CR3 */
     ArWriteControlRegister(3, (UINT_PTR)PageMap->PtePointer);
 
@@ -100,6 +100,11 @@ XTCDECL
 EFI_STATUS
 XtpMapHardwareMemoryPool(IN PXTBL_PAGE_MAPPING PageMap);
 
+XTCDECL
+EFI_STATUS
+XtpMapKernelImage(IN PXTBL_PAGE_MAPPING PageMap,
+                  IN PPECOFF_IMAGE_CONTEXT ImageContext);
+
 XTCDECL
 EFI_STATUS
 BlXtLdrModuleMain(IN EFI_HANDLE ImageHandle,
@@ -63,52 +63,116 @@ XtGetDisplayInformation(OUT PSYSTEM_RESOURCE_FRAMEBUFFER FrameBufferResource,
     FrameBufferResource->Pixels.ReservedSize = FrameBufferModeInfo->PixelInformation.ReservedSize;
 }
 
+/**
+ * Builds the memory descriptors passed to the kernel. Physically contiguous memory mappings of the same memory type
+ * are merged, and the resulting descriptors are stored in an array sorted by the base page, that is linked into
+ * a list as well.
+ *
+ * @param PageMap
+ *        Supplies a pointer to the page mapping structure.
+ *
+ * @param VirtualAddress
+ *        Supplies a pointer to the next valid, free and available virtual address.
+ *
+ * @param MemoryDescriptorList
+ *        Supplies a pointer to the list head, that will be linked with all memory descriptors.
+ *
+ * @param MemoryDescriptors
+ *        Supplies a pointer to the variable that receives the virtual address of the memory descriptors array.
+ *
+ * @param MemoryDescriptorCount
+ *        Supplies a pointer to the variable that receives the number of memory descriptors in the array.
+ *
+ * @return This routine returns a status code.
+ *
+ * @since XT 1.0
+ */
 XTCDECL
 EFI_STATUS
 XtGetMemoryDescriptorList(IN PXTBL_PAGE_MAPPING PageMap,
                           IN PVOID *VirtualAddress,
-                          OUT PLIST_ENTRY MemoryDescriptorList)
+                          OUT PLIST_ENTRY MemoryDescriptorList,
+                          OUT PLOADER_MEMORY_DESCRIPTOR *MemoryDescriptors,
+                          OUT PULONG MemoryDescriptorCount)
 {
+    PLOADER_MEMORY_DESCRIPTOR Descriptors, LastDescriptor;
+    ULONG BasePage, Index, MaximumCount;
+    PXTBL_MEMORY_MAPPING MemoryMapping;
     EFI_PHYSICAL_ADDRESS Address;
     EFI_STATUS Status;
     ULONGLONG Pages;
 
-    Pages = (ULONGLONG)EFI_SIZE_TO_PAGES((PageMap->MapSize + 1) * sizeof(LOADER_MEMORY_DESCRIPTOR));
+    /* Mapping the descriptors array adds one mapping and can split an existing one in two */
+    Pages = (ULONGLONG)EFI_SIZE_TO_PAGES((PageMap->MapSize + 3) * sizeof(LOADER_MEMORY_DESCRIPTOR));
+    MaximumCount = (ULONG)((Pages * EFI_PAGE_SIZE) / sizeof(LOADER_MEMORY_DESCRIPTOR));
 
+    /* Allocate memory for the memory descriptors array */
     Status = XtLdrProtocol->Memory.AllocatePages(Pages, &Address);
     if(Status != STATUS_EFI_SUCCESS)
     {
+        /* Memory allocation failure */
         return Status;
     }
 
+    /* Map the memory descriptors array */
     Status = XtLdrProtocol->Memory.MapVirtualMemory(PageMap, *VirtualAddress, (PVOID)Address, Pages, LoaderMemoryData);
     if(Status != STATUS_EFI_SUCCESS)
     {
-        XtLdrProtocol->Memory.FreePages(Address, Pages);
+        /* Mapping failed, free memory and return error */
+        XtLdrProtocol->Memory.FreePages(Pages, Address);
         return Status;
     }
 
-    PVOID PhysicalBase = (PVOID)Address;
-
-    PLIST_ENTRY ListEntry;
-    ListEntry = PageMap->MemoryMap.Flink;
-    while(ListEntry != &PageMap->MemoryMap)
+    /* Memory mappings are kept sorted by the physical address, so descriptors only need to be merged */
+    Descriptors = (PLOADER_MEMORY_DESCRIPTOR)(UINT_PTR)Address;
+    LastDescriptor = NULL;
+    RtlInitializeListHead(MemoryDescriptorList);
+    for(Index = 0; Index < PageMap->MapSize; Index++)
     {
-        PXTBL_MEMORY_MAPPING MemoryMapping = CONTAIN_RECORD(ListEntry, XTBL_MEMORY_MAPPING, ListEntry);
-        PLOADER_MEMORY_DESCRIPTOR MemoryDescriptor = (PLOADER_MEMORY_DESCRIPTOR)Address;
+        /* Get memory mapping */
+        MemoryMapping = &PageMap->MemoryMap[Index];
+        BasePage = (ULONG)((UINT_PTR)MemoryMapping->PhysicalAddress / EFI_PAGE_SIZE);
 
-        MemoryDescriptor->MemoryType = MemoryMapping->MemoryType;
-        MemoryDescriptor->BasePage = (UINT_PTR)MemoryMapping->PhysicalAddress / EFI_PAGE_SIZE;
-        MemoryDescriptor->PageCount = MemoryMapping->NumberOfPages;
+        /* Check if mapping continues the previous descriptor */
+        if(LastDescriptor && LastDescriptor->MemoryType == MemoryMapping->MemoryType &&
+           LastDescriptor->BasePage + LastDescriptor->PageCount == BasePage)
+        {
+            /* Extend the previous descriptor */
+            LastDescriptor->PageCount += (ULONG)MemoryMapping->NumberOfPages;
+            continue;
+        }
 
-        RtlInsertTailList(MemoryDescriptorList, &MemoryDescriptor->ListEntry);
+        /* Make sure there is room for another descriptor */
+        if(LastDescriptor == &Descriptors[MaximumCount - 1])
+        {
+            /* Array is full, kernel cannot be given an incomplete memory map, return error */
+            XtLdrProtocol->Debug.Print(L"ERROR: Too many memory descriptors to pass to the kernel\n");
+
+            /* Unmap and free the memory descriptors array */
+            XtLdrProtocol->Memory.UnmapVirtualMemory(PageMap, (PVOID)Address, Pages);
+            XtLdrProtocol->Memory.FreePages(Pages, Address);
+            return STATUS_EFI_BUFFER_TOO_SMALL;
+        }
 
-        Address = Address + sizeof(LOADER_MEMORY_DESCRIPTOR);
-        ListEntry = ListEntry->Flink;
+        /* Store new descriptor right after the previous one and link it into the list */
+        LastDescriptor = LastDescriptor ? LastDescriptor + 1 : Descriptors;
+        LastDescriptor->MemoryType = MemoryMapping->MemoryType;
+        LastDescriptor->BasePage = BasePage;
+        LastDescriptor->PageCount = (ULONG)MemoryMapping->NumberOfPages;
+        RtlInsertTailList(MemoryDescriptorList, &LastDescriptor->ListEntry);
     }
 
-    XtLdrProtocol->Memory.PhysicalListToVirtual(PageMap, MemoryDescriptorList, PhysicalBase, *VirtualAddress);
+    /* Convert the list to virtual addresses */
+    XtLdrProtocol->Memory.PhysicalListToVirtual(PageMap, MemoryDescriptorList, Descriptors, *VirtualAddress);
+
+    /* Return memory descriptors array */
+    *MemoryDescriptors = (PLOADER_MEMORY_DESCRIPTOR)*VirtualAddress;
+    *MemoryDescriptorCount = LastDescriptor ? (ULONG)(LastDescriptor - Descriptors) + 1 : 0;
+
+    /* Calculate next valid virtual address */
+    *VirtualAddress += (UINT_PTR)(Pages * EFI_PAGE_SIZE);
 
+    /* Return success */
     return STATUS_EFI_SUCCESS;
 }
 
@@ -144,7 +208,7 @@ XtGetSystemResourcesList(IN PXTBL_PAGE_MAPPING PageMap,
     Status = XtLdrProtocol->Memory.MapVirtualMemory(PageMap, *VirtualAddress, (PVOID)Address, Pages, LoaderFirmwarePermanent);
     if(Status != STATUS_EFI_SUCCESS)
     {
-        XtLdrProtocol->Memory.FreePages(Address, Pages);
+        XtLdrProtocol->Memory.FreePages(Pages, Address);
         return Status;
     }
 
@@ -426,11 +490,12 @@ XtpBootSequence(IN PEFI_FILE_HANDLE BootDir,
         return Status;
     }
 
-    /* Add kernel image memory mapping */
-    Status = XtLdrProtocol->Memory.MapVirtualMemory(&PageMap, ImageContext->VirtualAddress,
-                                                    ImageContext->PhysicalAddress, ImageContext->ImagePages, 0);
+    /* Add kernel image memory mappings */
+    Status = XtpMapKernelImage(&PageMap, ImageContext);
     if(Status != STATUS_EFI_SUCCESS)
     {
+        /* Failed to map the kernel */
+        XtLdrProtocol->Debug.Print(L"Failed to map the kernel image (Status Code: 0x%zX)\n", Status);
         return Status;
     }
 
@@ -603,9 +668,15 @@ XtpInitializeLoaderBlock(IN PXTBL_PAGE_MAPPING PageMap,
     RtlInitializeListHead(&LoaderBlock->SystemResourcesListHead);
     XtGetSystemResourcesList(PageMap, VirtualAddress, &LoaderBlock->SystemResourcesListHead);
 
-    /* Initialize memory descriptor list */
+    /* Initialize memory descriptor list and array */
     RtlInitializeListHead(&LoaderBlock->MemoryDescriptorListHead);
-    XtGetMemoryDescriptorList(PageMap, VirtualAddress, &LoaderBlock->MemoryDescriptorListHead);
+    Status = XtGetMemoryDescriptorList(PageMap, VirtualAddress, &LoaderBlock->MemoryDescriptorListHead,
+                                       &LoaderBlock->MemoryDescriptors, &LoaderBlock->MemoryDescriptorCount);
+    if(Status != STATUS_EFI_SUCCESS)
+    {
+        /* Failed to build memory descriptors, return error */
+        return Status;
+    }
 
     /* Return success */
     return STATUS_EFI_SUCCESS;
@@ -695,6 +766,126 @@ XtpLoadModule(IN PEFI_FILE_HANDLE SystemDir,
     return STATUS_EFI_SUCCESS;
 }
 
+/**
+ * Maps the kernel image according to its PE/COFF section headers. All pages are global, so they survive address
+ * space switches, code is read-only and data is non-executable. Pages shared by several sections get permissions
+ * of all of them.
+ *
+ * @param PageMap
+ *        Supplies a pointer to the page mapping structure.
+ *
+ * @param ImageContext
+ *        Supplies a pointer to the loaded kernel image context.
+ *
+ * @return This routine returns a status code.
+ *
+ * @since XT 1.0
+ */
+XTCDECL
+EFI_STATUS
+XtpMapKernelImage(IN PXTBL_PAGE_MAPPING PageMap,
+                  IN PPECOFF_IMAGE_CONTEXT ImageContext)
+{
+    ULONG Attributes, Index, Page, RunStart, SectionEnd, SectionSize;
+    PPECOFF_IMAGE_SECTION_HEADER SectionHeader;
+    PULONG PagePermissions;
+    EFI_STATUS Status;
+
+    /* Add kernel image memory mapping */
+    Status = XtLdrProtocol->Memory.MapVirtualMemory(PageMap, ImageContext->VirtualAddress,
+                                                    ImageContext->PhysicalAddress, ImageContext->ImagePages, 0);
+    if(Status != STATUS_EFI_SUCCESS)
+    {
+        /* Mapping failed */
+        return Status;
+    }
+
+    /* Allocate memory for permissions of every image page */
+    Status = XtLdrProtocol->Memory.AllocatePool(ImageContext->ImagePages * sizeof(ULONG), (PVOID *)&PagePermissions);
+    if(Status != STATUS_EFI_SUCCESS)
+    {
+        /* Memory allocation failure */
+        return Status;
+    }
+
+    /* Headers and gaps between sections are neither writable nor executable */
+    XtLdrProtocol->Memory.ZeroMemory(PagePermissions, ImageContext->ImagePages * sizeof(ULONG));
+
+    /* Find section headers */
+    SectionHeader = (PPECOFF_IMAGE_SECTION_HEADER)((PUCHAR)&ImageContext->PeHeader->OptionalHeader64 +
+                                                   ImageContext->PeHeader->FileHeader.SizeOfOptionalHeader);
+
+    /* Collect permissions of all sections */
+    for(Index = 0; Index < ImageContext->PeHeader->FileHeader.NumberOfSections; Index++)
+    {
+        /* Get the size of the section in memory */
+        SectionSize = SectionHeader[Index].Misc.VirtualSize ? SectionHeader[Index].Misc.VirtualSize :
+                                                              SectionHeader[Index].SizeOfRawData;
+
+        /* Calculate the first page after the section */
+        SectionEnd = EFI_SIZE_TO_PAGES(SectionHeader[Index].VirtualAddress + SectionSize);
+        if(SectionEnd > ImageContext->ImagePages)
+        {
+            /* Section exceeds the image */
+            SectionEnd = ImageContext->ImagePages;
+        }
+
+        /* Mark all pages of the section */
+        for(Page = SectionHeader[Index].VirtualAddress / EFI_PAGE_SIZE; Page < SectionEnd; Page++)
+        {
+            PagePermissions[Page] |= SectionHeader[Index].Characteristics &
+                                     (PECOFF_IMAGE_SCN_MEM_EXECUTE | PECOFF_IMAGE_SCN_MEM_WRITE);
+        }
+    }
+
+    /* Set attributes of every run of pages sharing the same permissions */
+    RunStart = 0;
+    for(Page = 1; Page <= ImageContext->ImagePages; Page++)
+    {
+        /* Check if the run continues */
+        if(Page < ImageContext->ImagePages && PagePermissions[Page] == PagePermissions[RunStart])
+        {
+            continue;
+        }
+
+        /* Kernel mappings are global and can use large pages */
+        Attributes = XTBL_MAPPING_GLOBAL | XTBL_MAPPING_LARGE_PAGES;
+
+        /* Check if pages are writable */
+        if(!(PagePermissions[RunStart] & PECOFF_IMAGE_SCN_MEM_WRITE))
+        {
+            /* Read-only pages */
+            Attributes |= XTBL_MAPPING_READ_ONLY;
+        }
+
+        /* Check if pages are executable */
+        if(!(PagePermissions[RunStart] & PECOFF_IMAGE_SCN_MEM_EXECUTE))
+        {
+            /* Non-executable pages */
+            Attributes |= XTBL_MAPPING_NO_EXECUTE;
+        }
+
+        /* Set attributes of the run */
+        Status = XtLdrProtocol->Memory.SetMappingAttributes(PageMap,
+                                                            (PUCHAR)ImageContext->PhysicalAddress +
+                                                            (RunStart * EFI_PAGE_SIZE),
+                                                            Page - RunStart, Attributes);
+        if(Status != STATUS_EFI_SUCCESS)
+        {
+            /* Failed to set attributes, free memory and return error */
+            XtLdrProtocol->Memory.FreePool(PagePermissions);
+            return Status;
+        }
+
+        /* Start next run */
+        RunStart = Page;
+    }
+
+    /* Free memory and return success */
+    XtLdrProtocol->Memory.FreePool(PagePermissions);
+    return STATUS_EFI_SUCCESS;
+}
+
 /**
  * This routine is the entry point of the XT EFI boot loader module.
  *
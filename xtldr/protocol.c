@@ -904,7 +904,9 @@ BlpInstallXtLoaderProtocol()
     BlpLdrProtocol.Memory.MapVirtualMemory = BlMapVirtualMemory;
     BlpLdrProtocol.Memory.PhysicalAddressToVirtual = BlPhysicalAddressToVirtual;
     BlpLdrProtocol.Memory.PhysicalListToVirtual = BlPhysicalListToVirtual;
+    BlpLdrProtocol.Memory.SetMappingAttributes = BlSetMappingAttributes;
     BlpLdrProtocol.Memory.SetMemory = RtlSetMemory;
+    BlpLdrProtocol.Memory.UnmapVirtualMemory = BlUnmapVirtualMemory;
     BlpLdrProtocol.Memory.ZeroMemory = RtlZeroMemory;
     BlpLdrProtocol.Protocol.Close = BlCloseProtocol;
     BlpLdrProtocol.Protocol.GetModulesList = BlGetModulesList;
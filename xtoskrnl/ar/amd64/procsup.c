@@ -82,6 +82,9 @@ ArInitializeProcessor(IN PVOID ProcessorStructures)
 
     /* Identify processor */
     ArpIdentifyProcessor();
+
+    /* Initialize Page Attribute Table */
+    ArpInitializePageAttributeTable();
 }
 
 /**
@@ -133,6 +136,7 @@ ArpIdentifyProcessor(VOID)
     PKPROCESSOR_CONTROL_BLOCK Prcb;
     CPUID_REGISTERS CpuRegisters;
     CPUID_SIGNATURE CpuSignature;
+    ULONG MaximumLeaf;
 
     /* Not fully implemented yet */
     UNIMPLEMENTED;
@@ -152,6 +156,9 @@ ArpIdentifyProcessor(VOID)
     *(PULONG)&Prcb->CpuId.VendorName[8] = CpuRegisters.Ecx;
     Prcb->CpuId.VendorName[12] = '\0';
 
+    /* Save maximum supported standard CPUID leaf */
+    MaximumLeaf = CpuRegisters.Eax;
+
     /* Get CPU features */
     RtlZeroMemory(&CpuRegisters, sizeof(CPUID_REGISTERS));
     CpuRegisters.Leaf = CPUID_GET_CPU_FEATURES;
@@ -192,7 +199,55 @@ ArpIdentifyProcessor(VOID)
         Prcb->CpuId.Vendor = CPU_VENDOR_UNKNOWN;
     }
 
-    /* TODO: Store a list of CPU features in processor control block */
+    /* Store TLB management features in processor control block */
+    Prcb->CpuId.FeatureBits = 0;
+
+    /* Check if Paging Global Extensions (PGE) is supported */
+    if(CpuRegisters.Edx & CPUID_FEATURES_EDX_PGE)
+    {
+        /* Global pages supported */
+        Prcb->CpuId.FeatureBits |= KF_GLOBAL_PAGE;
+    }
+
+    /* Check if Page Attribute Table (PAT) is supported */
+    if(CpuRegisters.Edx & CPUID_FEATURES_EDX_PAT)
+    {
+        /* PAT supported */
+        Prcb->CpuId.FeatureBits |= KF_PAT;
+    }
+
+    /* Check if CLFLUSH instruction is supported and reports the flushed line size given in quadwords */
+    Prcb->CpuId.CacheFlushSize = ((CpuRegisters.Ebx >> 8) & 0xFF) * 8;
+    if((CpuRegisters.Edx & CPUID_FEATURES_EDX_CLFLUSH) && Prcb->CpuId.CacheFlushSize)
+    {
+        /* CLFLUSH supported */
+        Prcb->CpuId.FeatureBits |= KF_CLFLUSH;
+    }
+
+    /* Check if Process Context Identifiers (PCID) are supported */
+    if(CpuRegisters.Ecx & CPUID_FEATURES_ECX_PCID)
+    {
+        /* PCID supported */
+        Prcb->CpuId.FeatureBits |= KF_PCID;
+    }
+
+    /* Check if structured extended features leaf is available */
+    if(MaximumLeaf >= CPUID_GET_STANDARD7_FEATURES)
+    {
+        /* Get structured extended features */
+        RtlZeroMemory(&CpuRegisters, sizeof(CPUID_REGISTERS));
+        CpuRegisters.Leaf = CPUID_GET_STANDARD7_FEATURES;
+        ArCpuId(&CpuRegisters);
+
+        /* Check if INVPCID instruction is supported */
+        if(CpuRegisters.Ebx & CPUID_FEATURES_LEAF7_EBX_INVPCID)
+        {
+            /* INVPCID supported */
+            Prcb->CpuId.FeatureBits |= KF_INVPCID;
+        }
+    }
+
+    /* TODO: Store remaining CPU features in processor control block */
 }
 
 /**
@@ -272,6 +327,32 @@ ArpInitializeIdt(IN PKPROCESSOR_BLOCK ProcessorBlock)
     ArpSetIdtGate(ProcessorBlock->IdtBase, 0xE1, ArpTrap0xE1, KGDT_R0_CODE, KIDT_IST_RESERVED, KIDT_ACCESS_RING0);
 }
 
+/**
+ * Programs the Page Attribute Table, so that memory caching types used by the memory manager can be selected by PTEs.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+ArpInitializePageAttributeTable(VOID)
+{
+    ULONGLONG PatAttributes;
+
+    /* Make sure PAT is supported */
+    if(!(KeGetCurrentProcessorControlBlock()->CpuId.FeatureBits & KF_PAT))
+    {
+        /* PAT not supported, PCD and PWT bits select legacy WB, WT, UC- and UC types */
+        return;
+    }
+
+    /* Keep the first four entries compatible with PCD and PWT bits, upper half provides write-combining */
+    PatAttributes = (PAT_TYPE_WB << 0) | (PAT_TYPE_WT << 8) | (PAT_TYPE_WEAK_UC << 16) | (PAT_TYPE_STRONG_UC << 24) |
+                    (PAT_TYPE_WB << 32) | (PAT_TYPE_USWC << 40) | (PAT_TYPE_WEAK_UC << 48) | (PAT_TYPE_STRONG_UC << 56);
+    ArWriteModelSpecificRegister(X86_MSR_PAT, PatAttributes);
+}
+
 /**
  * Initializes processor block.
  *
@@ -299,6 +380,8 @@ ArpInitializeProcessorBlock(OUT PKPROCESSOR_BLOCK ProcessorBlock,
                             IN PKTSS Tss,
                             IN PVOID DpcStack)
 {
+    ULONG Index;
+
     /* Set processor block and processor control block */
     ProcessorBlock->Self = ProcessorBlock;
     ProcessorBlock->CurrentPrcb = &ProcessorBlock->Prcb;
@@ -317,6 +400,13 @@ ArpInitializeProcessorBlock(OUT PKPROCESSOR_BLOCK ProcessorBlock,
     ProcessorBlock->Prcb.SetMember = 1ULL << ProcessorBlock->CpuNumber;
     ProcessorBlock->Prcb.MultiThreadProcessorSet = 1ULL << ProcessorBlock->CpuNumber;
 
+    /* Point lock queue entries to the kernel queued spinlocks */
+    for(Index = 0; Index < MaximumLock; Index++)
+    {
+        ProcessorBlock->Prcb.LockQueue[Index].Next = NULL;
+        ProcessorBlock->Prcb.LockQueue[Index].Lock = &KepQueuedSpinLocks[Index];
+    }
+
     /* Clear DR6 and DR7 registers */
     ProcessorBlock->Prcb.ProcessorState.SpecialRegisters.KernelDr6 = 0;
     ProcessorBlock->Prcb.ProcessorState.SpecialRegisters.KernelDr7 = 0;
@@ -345,8 +435,6 @@ XTAPI
 VOID
 ArpInitializeProcessorRegisters(VOID)
 {
-    ULONGLONG PatAttributes;
-
     /* Enable FXSAVE restore */
     ArWriteControlRegister(4, ArReadControlRegister(4) | CR4_FXSR);
 
@@ -359,6 +447,9 @@ ArpInitializeProcessorRegisters(VOID)
     /* Enable large pages */
     ArWriteControlRegister(4, ArReadControlRegister(4) | CR4_PSE);
 
+    /* Enable global pages, so kernel mappings survive address space switches */
+    ArWriteControlRegister(4, ArReadControlRegister(4) | CR4_PGE);
+
     /* Enable write-protection */
     ArWriteControlRegister(0, ArReadControlRegister(0) | CR0_WP);
 
@@ -386,11 +477,6 @@ ArpInitializeProcessorRegisters(VOID)
     /* Enable No-Execute (NXE) in EFER MSR */
     ArWriteModelSpecificRegister(X86_MSR_EFER, ArReadModelSpecificRegister(X86_MSR_EFER) | X86_MSR_EFER_NXE);
 
-    /* Initialize Page Attribute Table */
-    PatAttributes = (PAT_TYPE_WB << 0) | (PAT_TYPE_USWC << 8) | (PAT_TYPE_WEAK_UC << 16) | (PAT_TYPE_STRONG_UC << 24) |
-                    (PAT_TYPE_WB << 32) | (PAT_TYPE_USWC << 40) | (PAT_TYPE_WEAK_UC << 48) | (PAT_TYPE_STRONG_UC << 56);
-    ArWriteModelSpecificRegister(X86_MSR_PAT, PatAttributes);
-
     /* Initialize MXCSR register */
     ArLoadMxcsrRegister(INITIAL_MXCSR);
 }
@@ -431,8 +517,8 @@ ArpInitializeProcessorStructures(IN PVOID ProcessorStructures,
 {
     UINT_PTR Address;
 
-    /* Align address to page size boundary and move to kernel boot stack */
-    Address = ROUND_UP((UINT_PTR)ProcessorStructures, MM_PAGE_SIZE) + KERNEL_STACK_SIZE;
+    /* Processor structures are page aligned, move to kernel boot stack */
+    Address = (UINT_PTR)ProcessorStructures + KERNEL_STACK_SIZE;
 
     /* Assign a space for kernel boot stack and advance */
     *KernelBootStack = (PVOID)Address;
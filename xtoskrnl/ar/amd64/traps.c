@@ -409,7 +409,16 @@ XTCDECL
 VOID
 ArpHandleTrap0E(IN PKTRAP_FRAME TrapFrame)
 {
-    DebugPrint(L"Handled Page-Fault exception (0x0E)!\n");
+    /* Try to resolve the fault, eg. first access to reserved kernel memory */
+    if(MmAccessFault(TrapFrame->ErrorCode, (PVOID)TrapFrame->Cr2) == STATUS_SUCCESS)
+    {
+        /* Fault resolved, restart the faulting instruction */
+        return;
+    }
+
+    /* Unresolvable page fault */
+    DebugPrint(L"Handled Page-Fault exception (0x0E) at %P, error code %lX!\n",
+               (PVOID)TrapFrame->Cr2, (ULONG)TrapFrame->ErrorCode);
     for(;;);
 }
 
@@ -569,7 +578,11 @@ XTCDECL
 VOID
 ArpHandleTrapE1(IN PKTRAP_FRAME TrapFrame)
 {
-    DebugPrint(L"Unhandled IPI interrupt (0xE1)!\n");
+    /* Process pending TLB shootdown */
+    MmpProcessTlbShootdown();
+
+    /* Send EOI */
+    HlSendEoi();
 }
 
 /**
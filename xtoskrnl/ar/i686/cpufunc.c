@@ -67,6 +67,26 @@ ArCpuId(IN OUT PCPUID_REGISTERS Registers)
     return TRUE;
 }
 
+/**
+ * Writes back and invalidates the cache line containing the specified address in all caches of the coherency domain.
+ *
+ * @param Address
+ *        Supplies a linear address within the cache line to flush.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTCDECL
+VOID
+ArFlushCacheLine(IN PVOID Address)
+{
+    asm volatile("clflush (%0)"
+                 :
+                 : "r" (Address)
+                 : "memory");
+}
+
 /**
  * Partially flushes the Translation Lookaside Buffer (TLB)
  *
@@ -160,6 +180,42 @@ ArInterruptsEnabled(VOID)
     return (Flags & X86_EFLAGS_IF_MASK) ? TRUE : FALSE;
 }
 
+/**
+ * Invalidates TLB entries and paging-structure caches based on the Process Context Identifier (PCID).
+ *
+ * @param Type
+ *        Supplies the INVPCID invalidation type.
+ *
+ * @param Pcid
+ *        Supplies the PCID to invalidate entries for. It is ignored for all-contexts invalidation types.
+ *
+ * @param Address
+ *        Supplies the linear address to invalidate. It is used by individual-address invalidation only.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTCDECL
+VOID
+ArInvalidatePcid(IN INVPCID_TYPE Type,
+                 IN ULONG_PTR Pcid,
+                 IN PVOID Address)
+{
+    ULONGLONG Descriptor[2];
+
+    /* Build INVPCID descriptor */
+    Descriptor[0] = Pcid;
+    Descriptor[1] = (ULONG_PTR)Address;
+
+    /* Invalidate TLB entries */
+    asm volatile("invpcid %0, %1"
+                 :
+                 : "m" (Descriptor),
+                   "r" ((ULONG_PTR)Type)
+                 : "memory");
+}
+
 /**
  * Invalidates the TLB (Translation Lookaside Buffer) for specified virtual address.
  *
@@ -704,6 +760,23 @@ ArStoreTaskRegister(OUT PVOID Destination)
                  : "memory");
 }
 
+/**
+ * Writes back all modified cache lines of the processor's caches to the main memory and invalidates the caches.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTCDECL
+VOID
+ArWriteBackInvalidateCache(VOID)
+{
+    asm volatile("wbinvd"
+                 :
+                 :
+                 : "memory");
+}
+
 /**
  * Writes a value to the specified CPU control register.
  *
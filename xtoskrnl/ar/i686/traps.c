@@ -122,6 +122,10 @@ ArpDispatchTrap(IN PKTRAP_FRAME TrapFrame)
             /* System call service request */
             ArpHandleTrap2E(TrapFrame);
             break;
+        case 0xE1:
+            /* InterProcessor Interrupt (IPI) */
+            ArpHandleTrapE1(TrapFrame);
+            break;
         default:
             /* Unknown/Unexpected trap */
             ArpHandleTrapFF(TrapFrame);
@@ -395,7 +399,16 @@ XTCDECL
 VOID
 ArpHandleTrap0E(IN PKTRAP_FRAME TrapFrame)
 {
-    DebugPrint(L"Handled Page-Fault exception (0x0E)!\n");
+    /* Try to resolve the fault, eg. first access to reserved kernel memory */
+    if(MmAccessFault(TrapFrame->ErrorCode, (PVOID)TrapFrame->Cr2) == STATUS_SUCCESS)
+    {
+        /* Fault resolved, restart the faulting instruction */
+        return;
+    }
+
+    /* Unresolvable page fault */
+    DebugPrint(L"Handled Page-Fault exception (0x0E) at %P, error code %lX!\n",
+               (PVOID)TrapFrame->Cr2, (ULONG)TrapFrame->ErrorCode);
     for(;;);
 }
 
@@ -558,6 +571,27 @@ ArpHandleTrap2E(IN PKTRAP_FRAME TrapFrame)
     DebugPrint(L"Unhandled system call (0x2E)!\n");
 }
 
+/**
+ * Handles the trap 0xE1 when InterProcessor Interrupt (IPI) occurs.
+ *
+ * @param TrapFrame
+ *        Supplies a kernel trap frame pushed by common trap handler on the stack.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTCDECL
+VOID
+ArpHandleTrapE1(IN PKTRAP_FRAME TrapFrame)
+{
+    /* Process pending TLB shootdown */
+    MmpProcessTlbShootdown();
+
+    /* Send EOI */
+    HlSendEoi();
+}
+
 /**
  * Handles the trap 0xFF then Unexpected Interrupt occurs.
  *
@@ -0,0 +1,28 @@
+/**
+ * PROJECT:         ExectOS
+ * COPYRIGHT:       See COPYING.md in the top level directory
+ * FILE:            xtoskrnl/ex/globals.c
+ * DESCRIPTION:     Architecture independent global variables related to EX subsystem
+ * DEVELOPERS:      Rafal Kupiec <belliash@codingworkshop.eu.org>
+ */
+
+#include <xtos.h>
+
+
+/* List of all object caches */
+LIST_ENTRY ExpObjectCacheListHead;
+
+/* Object caches list lock */
+KSPIN_LOCK ExpObjectCacheListLock;
+
+/* Pool block sizes, including block header, for all pool size classes */
+ULONG ExpPoolBlockSizes[EX_POOL_SIZE_CLASSES] = {32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048};
+
+/* Object caches backing pool size classes */
+PEX_OBJECT_CACHE ExpPoolCaches[EX_POOL_SIZE_CLASSES];
+
+/* Pool usage of allocations, that did not fit in the pool tag table */
+EX_POOL_TAG_ENTRY ExpPoolTagOverflow;
+
+/* Pool usage tracked by pool tag */
+EX_POOL_TAG_ENTRY ExpPoolTagTable[EX_POOL_TAG_TABLE_SIZE];
@@ -0,0 +1,37 @@
+/**
+ * PROJECT:         ExectOS
+ * COPYRIGHT:       See COPYING.md in the top level directory
+ * FILE:            xtoskrnl/ex/init.c
+ * DESCRIPTION:     Kernel executive initialization
+ * DEVELOPERS:      Rafal Kupiec <belliash@codingworkshop.eu.org>
+ */
+
+#include <xtos.h>
+
+
+/**
+ * Initializes the kernel executive. Memory manager has to be initialized already.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+ExInitializeExecutive(VOID)
+{
+    XTSTATUS Status;
+
+    /* Initialize object caches list */
+    RtlInitializeListHead(&ExpObjectCacheListHead);
+    KeInitializeSpinLock(&ExpObjectCacheListLock);
+
+    /* Initialize nonpaged pool */
+    Status = ExpInitializePool();
+    if(Status != STATUS_SUCCESS)
+    {
+        /* Pool initialization failed, kernel panic */
+        DebugPrint(L"Failed to initialize nonpaged pool (Status: 0x%lX)!\n", Status);
+        KePanic(0);
+    }
+}
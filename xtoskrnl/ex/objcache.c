@@ -0,0 +1,770 @@
+/**
+ * PROJECT:         ExectOS
+ * COPYRIGHT:       See COPYING.md in the top level directory
+ * FILE:            xtoskrnl/ex/objcache.c
+ * DESCRIPTION:     Object cache (slab) allocator for fixed-size kernel objects
+ * DEVELOPERS:      Rafal Kupiec <belliash@codingworkshop.eu.org>
+ */
+
+#include <xtos.h>
+
+
+/**
+ * Allocates an object from the object cache. The object is already initialized by the cache constructor.
+ *
+ * @param Cache
+ *        Supplies a pointer to the object cache.
+ *
+ * @param Object
+ *        Supplies a pointer to the variable that receives the address of the allocated object.
+ *
+ * @return This routine returns a status code.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+XTSTATUS
+ExAllocateFromCache(IN PEX_OBJECT_CACHE Cache,
+                    OUT PVOID *Object)
+{
+    PEX_CACHE_PROCESSOR Processor;
+    PEX_CACHE_MAGAZINE Magazine;
+    KRUNLEVEL OldRunLevel;
+    ULONG CpuNumber;
+
+    /* Initialize variables */
+    *Object = NULL;
+
+    /* Raise runlevel to DISPATCH level, so the thread cannot be moved to another processor */
+    OldRunLevel = KeRaiseRunLevel(DISPATCH_LEVEL);
+
+    /* Check if current processor has its own magazines */
+    CpuNumber = KeGetCurrentProcessorNumber();
+    if(CpuNumber >= Cache->ProcessorCount)
+    {
+        /* No magazines available, take the object directly from the slabs */
+        ExpAllocateFromSlabs(Cache, Object, 1);
+        KeLowerRunLevel(OldRunLevel);
+        return *Object ? STATUS_SUCCESS : STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    /* Get per-processor layer of the cache */
+    Processor = &Cache->Processors[CpuNumber];
+
+    /* Check if loaded magazine is empty, but previous one still holds objects */
+    if(!Processor->Loaded->Count && Processor->Previous->Count)
+    {
+        /* Exchange magazines */
+        Magazine = Processor->Loaded;
+        Processor->Loaded = Processor->Previous;
+        Processor->Previous = Magazine;
+    }
+
+    /* Check if there is any object in the loaded magazine */
+    if(Processor->Loaded->Count)
+    {
+        /* Object served from the magazine */
+        Processor->Hits++;
+    }
+    else
+    {
+        /* Both magazines are empty, fill half of the loaded one with objects taken from the slabs */
+        Processor->Misses++;
+        Processor->Loaded->Count = ExpAllocateFromSlabs(Cache, Processor->Loaded->Objects,
+                                                        EX_CACHE_MAGAZINE_SIZE / 2);
+        if(!Processor->Loaded->Count)
+        {
+            /* Out of memory, lower runlevel and return error */
+            KeLowerRunLevel(OldRunLevel);
+            return STATUS_INSUFFICIENT_RESOURCES;
+        }
+    }
+
+    /* Take the most recently freed object, as it is likely still in the processor cache */
+    *Object = Processor->Loaded->Objects[--Processor->Loaded->Count];
+
+    /* Lower runlevel and return success */
+    KeLowerRunLevel(OldRunLevel);
+    return STATUS_SUCCESS;
+}
+
+/**
+ * Creates a new cache of fixed-size objects.
+ *
+ * @param Name
+ *        Supplies a name of the cache, used for debugging purposes. The string has to stay valid as long as the cache.
+ *
+ * @param ObjectSize
+ *        Supplies the size of each object, in bytes.
+ *
+ * @param Alignment
+ *        Supplies the alignment of each object, in bytes. It has to be a power of two, or zero for pointer alignment.
+ *
+ * @param Constructor
+ *        Supplies an optional routine initializing new objects. It is called only once per object, when a slab is
+ *        created, so objects have to be freed back to the cache in their initialized state.
+ *
+ * @param Destructor
+ *        Supplies an optional routine called for each object when its slab is released.
+ *
+ * @param Context
+ *        Supplies an optional context passed to the constructor and destructor routines.
+ *
+ * @param Cache
+ *        Supplies a pointer to the variable that receives the address of the new object cache.
+ *
+ * @return This routine returns a status code.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+XTSTATUS
+ExCreateObjectCache(IN PCWSTR Name,
+                    IN SIZE_T ObjectSize,
+                    IN SIZE_T Alignment,
+                    IN PEX_OBJECT_CONSTRUCTOR Constructor,
+                    IN PEX_OBJECT_DESTRUCTOR Destructor,
+                    IN PVOID Context,
+                    OUT PEX_OBJECT_CACHE *Cache)
+{
+    SIZE_T DescriptorSize, FirstObjectOffset, LinkOffset, SlabSize, SlotSize;
+    ULONG CpuNumber, ObjectsPerSlab, ProcessorCount, SlabPages;
+    PEX_OBJECT_CACHE NewCache;
+    KRUNLEVEL OldRunLevel;
+    XTSTATUS Status;
+
+    /* Initialize variables */
+    *Cache = NULL;
+
+    /* Use pointer alignment by default */
+    if(Alignment < sizeof(PVOID))
+    {
+        Alignment = sizeof(PVOID);
+    }
+
+    /* Validate parameters */
+    if(!ObjectSize || (Alignment & (Alignment - 1)) || Alignment > MM_PAGE_SIZE)
+    {
+        /* Invalid parameters, return error */
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    /* Check if objects are constructed by the cache */
+    if(Constructor)
+    {
+        /* Free list link cannot overwrite constructed object, so it is placed right after it */
+        LinkOffset = ROUND_UP(ObjectSize, sizeof(PVOID));
+        SlotSize = ROUND_UP(LinkOffset + sizeof(SINGLE_LIST_ENTRY), Alignment);
+    }
+    else
+    {
+        /* Free objects are uninitialized, so free list link can be stored inside them */
+        LinkOffset = 0;
+        SlotSize = ROUND_UP((ObjectSize < sizeof(SINGLE_LIST_ENTRY)) ? sizeof(SINGLE_LIST_ENTRY) : ObjectSize,
+                            Alignment);
+    }
+
+    /* Objects start right after the slab header */
+    FirstObjectOffset = ROUND_UP(sizeof(EX_CACHE_SLAB), Alignment);
+
+    /* Find the smallest slab holding enough objects */
+    SlabPages = 1;
+    while((((SlabPages << MM_PAGE_SHIFT) - FirstObjectOffset) / SlotSize) < EX_CACHE_MINIMUM_SLAB_OBJECTS &&
+          SlabPages < EX_CACHE_MAXIMUM_SLAB_PAGES)
+    {
+        /* Slabs are aligned to their size, so their size has to be a power of two */
+        SlabPages <<= 1;
+    }
+
+    /* Make sure at least one object fits in the slab */
+    SlabSize = (SIZE_T)SlabPages << MM_PAGE_SHIFT;
+    if(SlabSize < FirstObjectOffset + SlotSize)
+    {
+        /* Object too large for the object cache, return error */
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    /* Calculate number of objects per slab */
+    ObjectsPerSlab = (ULONG)((SlabSize - FirstObjectOffset) / SlotSize);
+
+    /* Each processor gets its own, cache line aligned magazines */
+    ProcessorCount = HlpSystemInfo.CpuCount ? HlpSystemInfo.CpuCount : 1;
+    DescriptorSize = ROUND_UP(sizeof(EX_OBJECT_CACHE), CACHE_ALIGNMENT) + ProcessorCount * sizeof(EX_CACHE_PROCESSOR);
+
+    /* Allocate memory for the cache descriptor */
+    Status = MmAllocateSystemPages(SIZE_TO_PAGES(DescriptorSize), 1,
+                                   KeGetCurrentProcessorControlBlock()->NodeNumber, (PVOID *)&NewCache);
+    if(Status != STATUS_SUCCESS)
+    {
+        /* Failed to allocate memory, return error */
+        return Status;
+    }
+
+    /* Initialize the cache descriptor */
+    RtlZeroMemory(NewCache, DescriptorSize);
+    NewCache->Name = Name;
+    NewCache->ObjectSize = ObjectSize;
+    NewCache->SlotSize = SlotSize;
+    NewCache->LinkOffset = LinkOffset;
+    NewCache->FirstObjectOffset = FirstObjectOffset;
+    NewCache->ObjectsPerSlab = ObjectsPerSlab;
+    NewCache->SlabPages = SlabPages;
+    NewCache->Constructor = Constructor;
+    NewCache->Destructor = Destructor;
+    NewCache->Context = Context;
+    NewCache->DescriptorPages = SIZE_TO_PAGES(DescriptorSize);
+    KeInitializeSpinLock(&NewCache->Lock);
+    RtlInitializeListHead(&NewCache->EmptySlabs);
+    RtlInitializeListHead(&NewCache->PartialSlabs);
+    RtlInitializeListHead(&NewCache->FullSlabs);
+
+    /* Use space left at the end of the slab to shift objects in consecutive slabs by a cache line */
+    NewCache->ColorStep = (ULONG)((Alignment < CACHE_ALIGNMENT) ? CACHE_ALIGNMENT : Alignment);
+    NewCache->ColorCount = (ULONG)((SlabSize - FirstObjectOffset - ObjectsPerSlab * SlotSize) /
+                                   NewCache->ColorStep) + 1;
+
+    /* Initialize per-processor magazines */
+    NewCache->ProcessorCount = ProcessorCount;
+    NewCache->Processors = (PEX_CACHE_PROCESSOR)((PUCHAR)NewCache + ROUND_UP(sizeof(EX_OBJECT_CACHE), CACHE_ALIGNMENT));
+    for(CpuNumber = 0; CpuNumber < ProcessorCount; CpuNumber++)
+    {
+        NewCache->Processors[CpuNumber].Loaded = &NewCache->Processors[CpuNumber].Magazines[0];
+        NewCache->Processors[CpuNumber].Previous = &NewCache->Processors[CpuNumber].Magazines[1];
+    }
+
+    /* Raise runlevel and acquire object caches list lock */
+    OldRunLevel = KeRaiseRunLevel(DISPATCH_LEVEL);
+    KeAcquireSpinLock(&ExpObjectCacheListLock);
+
+    /* Add the cache to the list of all object caches */
+    RtlInsertTailList(&ExpObjectCacheListHead, &NewCache->ListEntry);
+
+    /* Release object caches list lock and lower runlevel */
+    KeReleaseSpinLock(&ExpObjectCacheListLock);
+    KeLowerRunLevel(OldRunLevel);
+
+    /* Return new object cache */
+    *Cache = NewCache;
+    return STATUS_SUCCESS;
+}
+
+/**
+ * Destroys an object cache. All objects have to be freed back to the cache and no other processor can use the cache
+ * while it is being destroyed.
+ *
+ * @param Cache
+ *        Supplies a pointer to the object cache.
+ *
+ * @return This routine returns a status code.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+XTSTATUS
+ExDestroyObjectCache(IN PEX_OBJECT_CACHE Cache)
+{
+    PEX_CACHE_PROCESSOR Processor;
+    PLIST_ENTRY ListEntry;
+    KRUNLEVEL OldRunLevel;
+    LIST_ENTRY SlabList;
+    ULONG CpuNumber;
+
+    /* Raise runlevel to DISPATCH level */
+    OldRunLevel = KeRaiseRunLevel(DISPATCH_LEVEL);
+
+    /* Return objects cached in all magazines back to the slabs */
+    for(CpuNumber = 0; CpuNumber < Cache->ProcessorCount; CpuNumber++)
+    {
+        /* Flush both magazines of the processor */
+        Processor = &Cache->Processors[CpuNumber];
+        ExpFreeToSlabs(Cache, Processor->Loaded->Objects, Processor->Loaded->Count);
+        ExpFreeToSlabs(Cache, Processor->Previous->Objects, Processor->Previous->Count);
+        Processor->Loaded->Count = 0;
+        Processor->Previous->Count = 0;
+    }
+
+    /* Acquire object caches list lock and cache lock */
+    KeAcquireSpinLock(&ExpObjectCacheListLock);
+    KeAcquireSpinLock(&Cache->Lock);
+
+    /* Make sure all objects have been freed */
+    if(Cache->ObjectsInUse)
+    {
+        /* Cache is still in use, release locks, lower runlevel and return error */
+        DebugPrint(L"Object cache '%S' still has %zu objects in use\n", Cache->Name, Cache->ObjectsInUse);
+        KeReleaseSpinLock(&Cache->Lock);
+        KeReleaseSpinLock(&ExpObjectCacheListLock);
+        KeLowerRunLevel(OldRunLevel);
+        return STATUS_UNSUCCESSFUL;
+    }
+
+    /* Remove the cache from the list of all object caches */
+    RtlRemoveEntryList(&Cache->ListEntry);
+
+    /* All slabs are empty now, take them off the cache */
+    RtlInitializeListHead(&SlabList);
+    while(!RtlListEmpty(&Cache->EmptySlabs))
+    {
+        ListEntry = Cache->EmptySlabs.Flink;
+        RtlRemoveEntryList(ListEntry);
+        RtlInsertTailList(&SlabList, ListEntry);
+    }
+
+    /* Release cache lock and object caches list lock */
+    KeReleaseSpinLock(&Cache->Lock);
+    KeReleaseSpinLock(&ExpObjectCacheListLock);
+
+    /* Release all slabs */
+    while(!RtlListEmpty(&SlabList))
+    {
+        ListEntry = SlabList.Flink;
+        RtlRemoveEntryList(ListEntry);
+        ExpDestroySlab(Cache, CONTAIN_RECORD(ListEntry, EX_CACHE_SLAB, ListEntry));
+    }
+
+    /* Lower runlevel and free the cache descriptor */
+    KeLowerRunLevel(OldRunLevel);
+    MmFreeSystemPages(Cache, Cache->DescriptorPages);
+
+    /* Return success */
+    return STATUS_SUCCESS;
+}
+
+/**
+ * Frees an object back to the object cache. The object has to be in the state left by the cache constructor.
+ *
+ * @param Cache
+ *        Supplies a pointer to the object cache.
+ *
+ * @param Object
+ *        Supplies a pointer to the object to be freed.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+ExFreeToCache(IN PEX_OBJECT_CACHE Cache,
+              IN PVOID Object)
+{
+    PEX_CACHE_PROCESSOR Processor;
+    PEX_CACHE_MAGAZINE Magazine;
+    KRUNLEVEL OldRunLevel;
+    ULONG CpuNumber;
+
+    /* Raise runlevel to DISPATCH level, so the thread cannot be moved to another processor */
+    OldRunLevel = KeRaiseRunLevel(DISPATCH_LEVEL);
+
+    /* Check if current processor has its own magazines */
+    CpuNumber = KeGetCurrentProcessorNumber();
+    if(CpuNumber >= Cache->ProcessorCount)
+    {
+        /* No magazines available, give the object directly back to its slab */
+        ExpFreeToSlabs(Cache, &Object, 1);
+        KeLowerRunLevel(OldRunLevel);
+        return;
+    }
+
+    /* Get per-processor layer of the cache */
+    Processor = &Cache->Processors[CpuNumber];
+
+    /* Check if loaded magazine is full */
+    if(Processor->Loaded->Count == EX_CACHE_MAGAZINE_SIZE)
+    {
+        /* Check if previous magazine holds any objects */
+        if(Processor->Previous->Count)
+        {
+            /* Both magazines are full, return objects from the previous one back to the slabs */
+            ExpFreeToSlabs(Cache, Processor->Previous->Objects, Processor->Previous->Count);
+            Processor->Previous->Count = 0;
+        }
+
+        /* Exchange magazines */
+        Magazine = Processor->Loaded;
+        Processor->Loaded = Processor->Previous;
+        Processor->Previous = Magazine;
+    }
+
+    /* Put the object into the loaded magazine */
+    Processor->Loaded->Objects[Processor->Loaded->Count++] = Object;
+
+    /* Lower runlevel */
+    KeLowerRunLevel(OldRunLevel);
+}
+
+/**
+ * Releases empty slabs of all object caches. This is called when the system runs low on memory.
+ *
+ * @return This routine returns the number of pages given back to the memory manager.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+PFN_NUMBER
+ExReclaimObjectCaches(VOID)
+{
+    PLIST_ENTRY CacheEntry, ListEntry;
+    PFN_NUMBER ReclaimedPages;
+    PEX_OBJECT_CACHE Cache;
+    KRUNLEVEL OldRunLevel;
+    LIST_ENTRY SlabList;
+
+    /* Initialize variables */
+    ReclaimedPages = 0;
+
+    /* Raise runlevel and acquire object caches list lock */
+    OldRunLevel = KeRaiseRunLevel(DISPATCH_LEVEL);
+    KeAcquireSpinLock(&ExpObjectCacheListLock);
+
+    /* Iterate through all object caches */
+    CacheEntry = ExpObjectCacheListHead.Flink;
+    while(CacheEntry != &ExpObjectCacheListHead)
+    {
+        /* Get object cache */
+        Cache = CONTAIN_RECORD(CacheEntry, EX_OBJECT_CACHE, ListEntry);
+        CacheEntry = CacheEntry->Flink;
+
+        /* Take all empty slabs off the cache */
+        RtlInitializeListHead(&SlabList);
+        KeAcquireSpinLock(&Cache->Lock);
+        while(!RtlListEmpty(&Cache->EmptySlabs))
+        {
+            ListEntry = Cache->EmptySlabs.Flink;
+            RtlRemoveEntryList(ListEntry);
+            RtlInsertTailList(&SlabList, ListEntry);
+            Cache->EmptySlabCount--;
+            Cache->SlabCount--;
+            Cache->ReclaimedSlabs++;
+        }
+        KeReleaseSpinLock(&Cache->Lock);
+
+        /* Release empty slabs */
+        while(!RtlListEmpty(&SlabList))
+        {
+            ListEntry = SlabList.Flink;
+            RtlRemoveEntryList(ListEntry);
+            ExpDestroySlab(Cache, CONTAIN_RECORD(ListEntry, EX_CACHE_SLAB, ListEntry));
+            ReclaimedPages += Cache->SlabPages;
+        }
+    }
+
+    /* Release object caches list lock and lower runlevel */
+    KeReleaseSpinLock(&ExpObjectCacheListLock);
+    KeLowerRunLevel(OldRunLevel);
+
+    /* Return number of reclaimed pages */
+    return ReclaimedPages;
+}
+
+/**
+ * Takes a batch of free objects from the slabs of the object cache, creating new slabs when needed.
+ *
+ * @param Cache
+ *        Supplies a pointer to the object cache.
+ *
+ * @param Objects
+ *        Supplies a pointer to the array that receives addresses of the allocated objects.
+ *
+ * @param Count
+ *        Supplies the number of objects to allocate.
+ *
+ * @return This routine returns the number of objects allocated.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+ULONG
+ExpAllocateFromSlabs(IN PEX_OBJECT_CACHE Cache,
+                     OUT PVOID *Objects,
+                     IN ULONG Count)
+{
+    PSINGLE_LIST_ENTRY Link;
+    PEX_CACHE_SLAB Slab;
+    ULONG Allocated, Color;
+    XTSTATUS Status;
+
+    /* Initialize variables */
+    Allocated = 0;
+
+    /* Acquire object cache lock */
+    KeAcquireSpinLock(&Cache->Lock);
+
+    /* Take objects until the request is satisfied */
+    while(Allocated < Count)
+    {
+        /* Prefer partially used slabs, so empty ones can be reclaimed */
+        if(!RtlListEmpty(&Cache->PartialSlabs))
+        {
+            /* Get partially used slab */
+            Slab = CONTAIN_RECORD(Cache->PartialSlabs.Flink, EX_CACHE_SLAB, ListEntry);
+        }
+        else if(!RtlListEmpty(&Cache->EmptySlabs))
+        {
+            /* Move empty slab to the list of partially used slabs */
+            Slab = CONTAIN_RECORD(Cache->EmptySlabs.Flink, EX_CACHE_SLAB, ListEntry);
+            RtlRemoveEntryList(&Slab->ListEntry);
+            RtlInsertHeadList(&Cache->PartialSlabs, &Slab->ListEntry);
+            Cache->EmptySlabCount--;
+        }
+        else
+        {
+            /* No free objects left, pick a color for the new slab */
+            Color = Cache->NextColor;
+            Cache->NextColor = (Color + 1) % Cache->ColorCount;
+
+            /* Create new slab without holding the lock */
+            KeReleaseSpinLock(&Cache->Lock);
+            Status = ExpCreateSlab(Cache, Color, &Slab);
+            KeAcquireSpinLock(&Cache->Lock);
+
+            /* Make sure slab has been created */
+            if(Status != STATUS_SUCCESS)
+            {
+                /* Out of memory, return objects allocated so far */
+                break;
+            }
+
+            /* Add new slab to the list of partially used slabs */
+            RtlInsertHeadList(&Cache->PartialSlabs, &Slab->ListEntry);
+            Cache->SlabCount++;
+            continue;
+        }
+
+        /* Take free objects from the slab */
+        while(Allocated < Count && Slab->FreeCount)
+        {
+            /* Remove object from the slab free list */
+            Link = Slab->FreeListHead.Next;
+            Slab->FreeListHead.Next = Link->Next;
+            Slab->FreeCount--;
+
+            /* Return object address */
+            Objects[Allocated++] = (PVOID)((PUCHAR)Link - Cache->LinkOffset);
+        }
+
+        /* Check if slab is fully used */
+        if(!Slab->FreeCount)
+        {
+            /* Move slab to the list of fully used slabs */
+            RtlRemoveEntryList(&Slab->ListEntry);
+            RtlInsertTailList(&Cache->FullSlabs, &Slab->ListEntry);
+        }
+    }
+
+    /* Update statistics and release object cache lock */
+    Cache->ObjectsInUse += Allocated;
+    KeReleaseSpinLock(&Cache->Lock);
+
+    /* Return number of allocated objects */
+    return Allocated;
+}
+
+/**
+ * Creates a new slab and constructs all its objects.
+ *
+ * @param Cache
+ *        Supplies a pointer to the object cache.
+ *
+ * @param Color
+ *        Supplies the color of the slab, that determines the offset of its first object.
+ *
+ * @param Slab
+ *        Supplies a pointer to the variable that receives the address of the new slab.
+ *
+ * @return This routine returns a status code.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+XTSTATUS
+ExpCreateSlab(IN PEX_OBJECT_CACHE Cache,
+              IN ULONG Color,
+              OUT PEX_CACHE_SLAB *Slab)
+{
+    PSINGLE_LIST_ENTRY Link;
+    PEX_CACHE_SLAB NewSlab;
+    PUCHAR FirstObject;
+    XTSTATUS Status;
+    ULONG Index;
+
+    /* Check if system runs low on memory */
+    if(MmAvailablePages < EX_CACHE_RECLAIM_THRESHOLD)
+    {
+        /* Release empty slabs of all caches first */
+        ExReclaimObjectCaches();
+    }
+
+    /* Allocate memory for the slab, aligned to its size so objects can find it */
+    Status = MmAllocateSystemPages(Cache->SlabPages, Cache->SlabPages,
+                                   KeGetCurrentProcessorControlBlock()->NodeNumber, (PVOID *)&NewSlab);
+    if(Status != STATUS_SUCCESS && ExReclaimObjectCaches())
+    {
+        /* Some memory has been reclaimed, try again */
+        Status = MmAllocateSystemPages(Cache->SlabPages, Cache->SlabPages,
+                                       KeGetCurrentProcessorControlBlock()->NodeNumber, (PVOID *)&NewSlab);
+    }
+
+    /* Make sure slab has been allocated */
+    if(Status != STATUS_SUCCESS)
+    {
+        /* Out of memory, return error */
+        return Status;
+    }
+
+    /* Initialize the slab header */
+    NewSlab->ColorOffset = Color * Cache->ColorStep;
+    NewSlab->FreeListHead.Next = NULL;
+    NewSlab->FreeCount = Cache->ObjectsPerSlab;
+
+    /* Get address of the first object */
+    FirstObject = (PUCHAR)NewSlab + Cache->FirstObjectOffset + NewSlab->ColorOffset;
+
+    /* Construct all objects and put them on the free list, lowest address first */
+    for(Index = Cache->ObjectsPerSlab; Index > 0; Index--)
+    {
+        /* Check if objects are constructed by the cache */
+        if(Cache->Constructor)
+        {
+            /* Construct the object */
+            Cache->Constructor(FirstObject + (Index - 1) * Cache->SlotSize, Cache->Context);
+        }
+
+        /* Put the object on the free list */
+        Link = (PSINGLE_LIST_ENTRY)(FirstObject + (Index - 1) * Cache->SlotSize + Cache->LinkOffset);
+        Link->Next = NewSlab->FreeListHead.Next;
+        NewSlab->FreeListHead.Next = Link;
+    }
+
+    /* Return new slab */
+    *Slab = NewSlab;
+    return STATUS_SUCCESS;
+}
+
+/**
+ * Destroys all objects of an unused slab and gives its memory back to the memory manager.
+ *
+ * @param Cache
+ *        Supplies a pointer to the object cache.
+ *
+ * @param Slab
+ *        Supplies a pointer to the slab. It has to be removed from the object cache already.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+ExpDestroySlab(IN PEX_OBJECT_CACHE Cache,
+               IN PEX_CACHE_SLAB Slab)
+{
+    PSINGLE_LIST_ENTRY Link;
+
+    /* Check if objects have to be destroyed */
+    if(Cache->Destructor)
+    {
+        /* Destroy all objects on the free list */
+        for(Link = Slab->FreeListHead.Next; Link; Link = Link->Next)
+        {
+            Cache->Destructor((PVOID)((PUCHAR)Link - Cache->LinkOffset), Cache->Context);
+        }
+    }
+
+    /* Free slab memory */
+    MmFreeSystemPages(Slab, Cache->SlabPages);
+}
+
+/**
+ * Gives a batch of objects back to their slabs. Slabs left empty are cached or released.
+ *
+ * @param Cache
+ *        Supplies a pointer to the object cache.
+ *
+ * @param Objects
+ *        Supplies a pointer to the array of objects to be freed.
+ *
+ * @param Count
+ *        Supplies the number of objects to be freed.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+ExpFreeToSlabs(IN PEX_OBJECT_CACHE Cache,
+               IN PVOID *Objects,
+               IN ULONG Count)
+{
+    PSINGLE_LIST_ENTRY Link;
+    PLIST_ENTRY ListEntry;
+    LIST_ENTRY SlabList;
+    PEX_CACHE_SLAB Slab;
+    ULONG Index;
+
+    /* Nothing to do if there are no objects */
+    if(!Count)
+    {
+        return;
+    }
+
+    /* Initialize list of slabs to be released */
+    RtlInitializeListHead(&SlabList);
+
+    /* Acquire object cache lock */
+    KeAcquireSpinLock(&Cache->Lock);
+
+    /* Iterate through all objects */
+    for(Index = 0; Index < Count; Index++)
+    {
+        /* Slabs are aligned to their size, so slab header is found by aligning the object address down */
+        Slab = (PEX_CACHE_SLAB)ROUND_DOWN((ULONG_PTR)Objects[Index], (ULONG_PTR)Cache->SlabPages << MM_PAGE_SHIFT);
+
+        /* Put the object back on the slab free list */
+        Link = (PSINGLE_LIST_ENTRY)((PUCHAR)Objects[Index] + Cache->LinkOffset);
+        Link->Next = Slab->FreeListHead.Next;
+        Slab->FreeListHead.Next = Link;
+
+        /* Check if slab was fully used */
+        if(Slab->FreeCount++ == 0)
+        {
+            /* Move slab to the list of partially used slabs */
+            RtlRemoveEntryList(&Slab->ListEntry);
+            RtlInsertTailList(&Cache->PartialSlabs, &Slab->ListEntry);
+        }
+
+        /* Check if slab is empty now */
+        if(Slab->FreeCount == Cache->ObjectsPerSlab)
+        {
+            /* Remove slab from the list of partially used slabs */
+            RtlRemoveEntryList(&Slab->ListEntry);
+
+            /* Keep a few empty slabs around, so allocation bursts do not have to construct objects again */
+            if(Cache->EmptySlabCount < EX_CACHE_MAXIMUM_EMPTY_SLABS)
+            {
+                /* Cache empty slab */
+                RtlInsertHeadList(&Cache->EmptySlabs, &Slab->ListEntry);
+                Cache->EmptySlabCount++;
+            }
+            else
+            {
+                /* Release the slab once the lock is dropped */
+                RtlInsertTailList(&SlabList, &Slab->ListEntry);
+                Cache->SlabCount--;
+            }
+        }
+    }
+
+    /* Update statistics and release object cache lock */
+    Cache->ObjectsInUse -= Count;
+    KeReleaseSpinLock(&Cache->Lock);
+
+    /* Release all surplus empty slabs */
+    while(!RtlListEmpty(&SlabList))
+    {
+        ListEntry = SlabList.Flink;
+        RtlRemoveEntryList(ListEntry);
+        ExpDestroySlab(Cache, CONTAIN_RECORD(ListEntry, EX_CACHE_SLAB, ListEntry));
+    }
+}
@@ -0,0 +1,324 @@
+/**
+ * PROJECT:         ExectOS
+ * COPYRIGHT:       See COPYING.md in the top level directory
+ * FILE:            xtoskrnl/ex/pool.c
+ * DESCRIPTION:     Nonpaged kernel pool with tagged allocations
+ * DEVELOPERS:      Rafal Kupiec <belliash@codingworkshop.eu.org>
+ */
+
+#include <xtos.h>
+
+
+/**
+ * Allocates a block of nonpaged pool memory and charges it to the given pool tag.
+ *
+ * @param NumberOfBytes
+ *        Supplies the number of bytes to allocate.
+ *
+ * @param Tag
+ *        Supplies the pool tag, usually four characters identifying the owner of the allocation.
+ *
+ * @param Memory
+ *        Supplies a pointer to the variable that receives the address of the allocated memory.
+ *
+ * @return This routine returns a status code.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+XTSTATUS
+ExAllocatePoolWithTag(IN SIZE_T NumberOfBytes,
+                      IN ULONG Tag,
+                      OUT PVOID *Memory)
+{
+    PEX_POOL_TAG_ENTRY TagEntry;
+    PEX_POOL_HEADER Header;
+    SIZE_T BlockSize;
+    USHORT PoolIndex;
+    XTSTATUS Status;
+
+    /* Initialize variables */
+    *Memory = NULL;
+
+    /* Every block starts with a header */
+    BlockSize = NumberOfBytes + sizeof(EX_POOL_HEADER);
+    if(!NumberOfBytes || BlockSize < NumberOfBytes)
+    {
+        /* Invalid size, return error */
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    /* Find the smallest size class the block fits in */
+    for(PoolIndex = 0; PoolIndex < EX_POOL_SIZE_CLASSES; PoolIndex++)
+    {
+        if(BlockSize <= ExpPoolBlockSizes[PoolIndex])
+        {
+            /* Size class found */
+            break;
+        }
+    }
+
+    /* Check if block fits in any size class */
+    if(PoolIndex == EX_POOL_SIZE_CLASSES)
+    {
+        /* Large allocation, take it straight from the system pages */
+        Status = MmAllocateSystemPages(SIZE_TO_PAGES(BlockSize), 1, KeGetCurrentProcessorControlBlock()->NodeNumber,
+                                       (PVOID *)&Header);
+        if(Status != STATUS_SUCCESS)
+        {
+            /* Out of memory, return error */
+            return Status;
+        }
+
+        /* Mark block as a large allocation */
+        PoolIndex = EX_POOL_LARGE_ALLOCATION;
+    }
+    else
+    {
+        /* Allocate block from the object cache backing the size class, its magazines cache blocks per processor */
+        Status = ExAllocateFromCache(ExpPoolCaches[PoolIndex], (PVOID *)&Header);
+        if(Status != STATUS_SUCCESS)
+        {
+            /* Out of memory, return error */
+            return Status;
+        }
+    }
+
+    /* Initialize block header */
+    Header->PoolTag = Tag;
+    Header->PoolIndex = PoolIndex;
+    Header->Reserved = 0;
+    Header->BlockSize = NumberOfBytes;
+
+    /* Charge the allocation to the pool tag */
+    TagEntry = ExpGetPoolTagEntry(Tag);
+    RtlAtomicIncrement64(&TagEntry->Allocations);
+    RtlAtomicExchangeAdd64(&TagEntry->BytesInUse, (LONG_PTR)NumberOfBytes);
+
+    /* Return memory right after the block header */
+    *Memory = Header + 1;
+    return STATUS_SUCCESS;
+}
+
+/**
+ * Frees a block of pool memory.
+ *
+ * @param Memory
+ *        Supplies a pointer to the memory allocated by ExAllocatePoolWithTag().
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+ExFreePool(IN PVOID Memory)
+{
+    /* Free the block without checking its tag */
+    ExFreePoolWithTag(Memory, 0);
+}
+
+/**
+ * Frees a block of pool memory and verifies its pool tag.
+ *
+ * @param Memory
+ *        Supplies a pointer to the memory allocated by ExAllocatePoolWithTag().
+ *
+ * @param Tag
+ *        Supplies the pool tag used to allocate the block, or zero to skip the check.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+ExFreePoolWithTag(IN PVOID Memory,
+                  IN ULONG Tag)
+{
+    PEX_POOL_TAG_ENTRY TagEntry;
+    PEX_POOL_HEADER Header;
+    USHORT PoolIndex;
+
+    /* Nothing to do for NULL pointer */
+    if(!Memory)
+    {
+        return;
+    }
+
+    /* Get block header */
+    Header = (PEX_POOL_HEADER)Memory - 1;
+    PoolIndex = Header->PoolIndex;
+
+    /* Make sure block header is valid */
+    if(PoolIndex >= EX_POOL_SIZE_CLASSES && PoolIndex != EX_POOL_LARGE_ALLOCATION)
+    {
+        /* Corrupted pool block, do not touch it */
+        DebugPrint(L"Attempted to free corrupted pool block at %P\n", Memory);
+        return;
+    }
+
+    /* Check if block has been allocated with the expected tag */
+    if(Tag && Header->PoolTag != Tag)
+    {
+        /* Tag mismatch, report it but free the block anyway */
+        DebugPrint(L"Pool block at %P freed with tag 0x%08lX, but allocated with tag 0x%08lX\n",
+                   Memory, Tag, Header->PoolTag);
+    }
+
+    /* Give the allocation back to the pool tag */
+    TagEntry = ExpGetPoolTagEntry(Header->PoolTag);
+    RtlAtomicIncrement64(&TagEntry->Frees);
+    RtlAtomicExchangeAdd64(&TagEntry->BytesInUse, -(LONG_PTR)Header->BlockSize);
+
+    /* Check if this is a large allocation */
+    if(PoolIndex == EX_POOL_LARGE_ALLOCATION)
+    {
+        /* Give pages straight back to the memory manager */
+        MmFreeSystemPages(Header, SIZE_TO_PAGES(Header->BlockSize + sizeof(EX_POOL_HEADER)));
+        return;
+    }
+
+    /* Give the block back to the object cache backing the size class */
+    ExFreeToCache(ExpPoolCaches[PoolIndex], Header);
+}
+
+/**
+ * Prints pool usage by pool tag and pool size class statistics to the debug port.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+ExpDumpPoolUsage(VOID)
+{
+    PEX_CACHE_PROCESSOR Processor;
+    PEX_POOL_TAG_ENTRY TagEntry;
+    ULONG_PTR Hits, Misses;
+    ULONG CpuNumber, Index;
+
+    /* Print usage of all pool tags */
+    DebugPrint(L"Tag   Allocations      Frees   Outstanding   BytesInUse\n");
+    for(Index = 0; Index <= EX_POOL_TAG_TABLE_SIZE; Index++)
+    {
+        /* Get pool tag entry, overflow entry goes last */
+        TagEntry = (Index < EX_POOL_TAG_TABLE_SIZE) ? &ExpPoolTagTable[Index] : &ExpPoolTagOverflow;
+        if(!TagEntry->Allocations)
+        {
+            /* Tag not used */
+            continue;
+        }
+
+        /* Print pool tag usage */
+        DebugPrint(L"%c%c%c%c  %11zd %10zd %13zd %12zd\n",
+                   (WCHAR)(TagEntry->PoolTag & 0xFF) ? (WCHAR)(TagEntry->PoolTag & 0xFF) : L'?',
+                   (WCHAR)((TagEntry->PoolTag >> 8) & 0xFF) ? (WCHAR)((TagEntry->PoolTag >> 8) & 0xFF) : L'?',
+                   (WCHAR)((TagEntry->PoolTag >> 16) & 0xFF) ? (WCHAR)((TagEntry->PoolTag >> 16) & 0xFF) : L'?',
+                   (WCHAR)((TagEntry->PoolTag >> 24) & 0xFF) ? (WCHAR)((TagEntry->PoolTag >> 24) & 0xFF) : L'?',
+                   TagEntry->Allocations, TagEntry->Frees, TagEntry->Allocations - TagEntry->Frees,
+                   TagEntry->BytesInUse);
+    }
+
+    /* Print statistics of all size classes */
+    DebugPrint(L"BlockSize   Slabs   InUse   MagazineHits   MagazineMisses\n");
+    for(Index = 0; Index < EX_POOL_SIZE_CLASSES; Index++)
+    {
+        /* Sum magazine statistics of the object cache from all processors */
+        Hits = 0;
+        Misses = 0;
+        for(CpuNumber = 0; CpuNumber < ExpPoolCaches[Index]->ProcessorCount; CpuNumber++)
+        {
+            Processor = &ExpPoolCaches[Index]->Processors[CpuNumber];
+            Hits += Processor->Hits;
+            Misses += Processor->Misses;
+        }
+
+        /* Print size class statistics */
+        DebugPrint(L"%9lu %7zu %7zu %14zu %16zu\n", ExpPoolBlockSizes[Index], ExpPoolCaches[Index]->SlabCount,
+                   ExpPoolCaches[Index]->ObjectsInUse, Hits, Misses);
+    }
+}
+
+/**
+ * Looks up the usage entry for the given pool tag, creating it on first use.
+ *
+ * @param Tag
+ *        Supplies the pool tag.
+ *
+ * @return This routine returns a pointer to the pool tag usage entry.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+PEX_POOL_TAG_ENTRY
+ExpGetPoolTagEntry(IN ULONG Tag)
+{
+    PEX_POOL_TAG_ENTRY TagEntry;
+    ULONG Index, Probe;
+
+    /* Untagged allocations are charged to the overflow entry */
+    if(!Tag)
+    {
+        return &ExpPoolTagOverflow;
+    }
+
+    /* Hash the pool tag */
+    Index = (Tag ^ (Tag >> 11) ^ (Tag >> 22)) & (EX_POOL_TAG_TABLE_SIZE - 1);
+
+    /* Look for the pool tag using linear probing */
+    for(Probe = 0; Probe < EX_POOL_TAG_TABLE_SIZE; Probe++)
+    {
+        /* Get pool tag entry */
+        TagEntry = &ExpPoolTagTable[(Index + Probe) & (EX_POOL_TAG_TABLE_SIZE - 1)];
+
+        /* Claim the entry if it is unused */
+        if(!TagEntry->PoolTag)
+        {
+            RtlAtomicCompareExchange32((PLONG)&TagEntry->PoolTag, 0, (LONG)Tag);
+        }
+
+        /* Check if entry belongs to the pool tag, it could have been claimed by another processor */
+        if(TagEntry->PoolTag == Tag)
+        {
+            /* Return pool tag entry */
+            return TagEntry;
+        }
+    }
+
+    /* Pool tag table is full */
+    return &ExpPoolTagOverflow;
+}
+
+/**
+ * Initializes the nonpaged pool. It creates object caches backing all pool size classes, their magazines cache
+ * blocks on each processor.
+ *
+ * @return This routine returns a status code.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+XTSTATUS
+ExpInitializePool(VOID)
+{
+    ULONG PoolIndex;
+    XTSTATUS Status;
+
+    /* Create object caches backing all size classes */
+    for(PoolIndex = 0; PoolIndex < EX_POOL_SIZE_CLASSES; PoolIndex++)
+    {
+        /* Create object cache, blocks are aligned to the block header size */
+        Status = ExCreateObjectCache(L"NonPagedPool", ExpPoolBlockSizes[PoolIndex], sizeof(EX_POOL_HEADER),
+                                     NULL, NULL, NULL, &ExpPoolCaches[PoolIndex]);
+        if(Status != STATUS_SUCCESS)
+        {
+            /* Failed to create object cache, return error */
+            return Status;
+        }
+    }
+
+    /* Return success */
+    return STATUS_SUCCESS;
+}
@@ -196,9 +196,8 @@ HlpInitializeAcpiSystemDescriptionTable(OUT PACPI_DESCRIPTION_HEADER *AcpiTable)
     AcpiResource = (PSYSTEM_RESOURCE_ACPI)ResourceHeader;
     RsdpAddress.QuadPart = (LONGLONG)AcpiResource->Header.PhysicalAddress;
 
-    /* Map RSDP and mark it as CD/WT to avoid delays in write-back cache */
-    Status = MmMapHardwareMemory(RsdpAddress, 1, TRUE, (PVOID *)&HlpAcpiRsdp);
-    MmMarkHardwareMemoryWriteThrough(HlpAcpiRsdp, 1);
+    /* Map RSDP as uncached to avoid delays in write-back cache */
+    Status = MmMapHardwareMemory(RsdpAddress, 1, MmNonCached, TRUE, (PVOID *)&HlpAcpiRsdp);
 
     /* Validate RSDP signature */
     if(Status != STATUS_SUCCESS || HlpAcpiRsdp->Signature != ACPI_RSDP_SIGNATURE)
@@ -219,9 +218,8 @@ HlpInitializeAcpiSystemDescriptionTable(OUT PACPI_DESCRIPTION_HEADER *AcpiTable)
         RsdtAddress.QuadPart = (LONGLONG)HlpAcpiRsdp->RsdtAddress;
     }
 
-    /* Map RSDT/XSDT as CD/WT */
-    Status = MmMapHardwareMemory(RsdtAddress, 2, TRUE, (PVOID *)&Rsdt);
-    MmMarkHardwareMemoryWriteThrough(Rsdt, 2);
+    /* Map RSDT/XSDT as uncached */
+    Status = MmMapHardwareMemory(RsdtAddress, 2, MmNonCached, TRUE, (PVOID *)&Rsdt);
 
     /* Validate RSDT/XSDT signature */
     if((Status != STATUS_SUCCESS) ||
@@ -238,8 +236,7 @@ HlpInitializeAcpiSystemDescriptionTable(OUT PACPI_DESCRIPTION_HEADER *AcpiTable)
     {
         /* RSDT/XSDT needs less or more than 2 pages, remap it */
         MmUnmapHardwareMemory(Rsdt, 2, TRUE);
-        Status = MmMapHardwareMemory(RsdtAddress, RsdtPages, TRUE, (PVOID *)&Rsdt);
-        MmMarkHardwareMemoryWriteThrough(Rsdt, RsdtPages);
+        Status = MmMapHardwareMemory(RsdtAddress, RsdtPages, MmNonCached, TRUE, (PVOID *)&Rsdt);
 
         /* Make sure remapping was successful */
         if(Status != STATUS_SUCCESS)
@@ -434,7 +431,7 @@ HlpInitializeAcpiSystemStructure(VOID)
     }
 
     /* Map physical address to the virtual memory area */
-    Status = MmMapHardwareMemory(PhysicalAddress, PageCount, TRUE, (PVOID *)&HlpSystemInfo.CpuInfo);
+    Status = MmMapHardwareMemory(PhysicalAddress, PageCount, MmCached, TRUE, (PVOID *)&HlpSystemInfo.CpuInfo);
     if(Status != STATUS_SUCCESS)
     {
         /* Failed to map memory, return error */
@@ -609,7 +606,7 @@ HlpQueryAcpiTables(IN ULONG Signature,
         TableAddress.HighPart = 0;
 
         /* Map table using hardware memory pool */
-        Status = MmMapHardwareMemory(TableAddress, 2, TRUE, (PVOID*)&TableHeader);
+        Status = MmMapHardwareMemory(TableAddress, 2, MmCached, TRUE, (PVOID*)&TableHeader);
         if(Status != STATUS_SUCCESS)
         {
             /* Failed to map table, return error */
@@ -669,7 +666,7 @@ HlpQueryAcpiTables(IN ULONG Signature,
             }
 
             /* Map table using hardware memory pool */
-            Status = MmMapHardwareMemory(TableAddress, 2, TRUE, (PVOID*)&TableHeader);
+            Status = MmMapHardwareMemory(TableAddress, 2, MmCached, TRUE, (PVOID*)&TableHeader);
             if(Status != STATUS_SUCCESS)
             {
                 /* Failed to map table, return error */
@@ -717,7 +714,7 @@ HlpQueryAcpiTables(IN ULONG Signature,
     {
         /* ACPI table needs less or more than 2 pages, remap it */
         MmUnmapHardwareMemory(TableHeader, 2, FALSE);
-        Status = MmMapHardwareMemory(TableAddress, TablePages, TRUE, (PVOID*)&TableHeader);
+        Status = MmMapHardwareMemory(TableAddress, TablePages, MmCached, TRUE, (PVOID*)&TableHeader);
 
         /* Make sure remapping was successful */
         if(Status != STATUS_SUCCESS)
@@ -727,8 +724,8 @@ HlpQueryAcpiTables(IN ULONG Signature,
         }
     }
 
-    /* Mark table as write through and store it in local cache */
-    MmMarkHardwareMemoryWriteThrough(TableHeader, TablePages);
+    /* Mark table as uncached and store it in local cache */
+    MmSetHardwareMemoryCacheType(TableHeader, TablePages, MmNonCached);
     HlpCacheAcpiTable(TableHeader);
 
     /* Store ACPI table and return success */
@@ -137,6 +137,17 @@ HlInitializeFrameBuffer(VOID)
         return STATUS_DEVICE_NOT_READY;
     }
 
+    /* Map framebuffer as write-combining, as VRAM accessed through uncached or write-back mapping is slow */
+    Status = MmSetHardwareMemoryCacheType(FrameBufferResource->Header.VirtualAddress,
+                                          SIZE_TO_PAGES(PAGE_OFFSET(FrameBufferResource->Header.VirtualAddress) +
+                                                        FrameBufferResource->BufferSize),
+                                          MmWriteCombined);
+    if(Status != STATUS_SUCCESS)
+    {
+        /* Keep the mapping provided by bootloader */
+        DebugPrint(L"Failed to map framebuffer as write-combining (Status: 0x%lX)\n", Status);
+    }
+
     /* Check if bootloader provided a custom font */
     if(FrameBufferResource->Font)
     {
@@ -21,6 +21,10 @@ XTCDECL
 BOOLEAN
 ArCpuId(IN OUT PCPUID_REGISTERS Registers);
 
+XTCDECL
+VOID
+ArFlushCacheLine(IN PVOID Address);
+
 XTCDECL
 VOID
 ArFlushTlb(VOID);
@@ -46,6 +50,12 @@ XTCDECL
 BOOLEAN
 ArInterruptsEnabled(VOID);
 
+XTCDECL
+VOID
+ArInvalidatePcid(IN INVPCID_TYPE Type,
+                 IN ULONG_PTR Pcid,
+                 IN PVOID Address);
+
 XTCDECL
 VOID
 ArInvalidateTlbEntry(IN PVOID Address);
@@ -138,6 +148,10 @@ XTCDECL
 VOID
 ArStoreTaskRegister(OUT PVOID Destination);
 
+XTCDECL
+VOID
+ArWriteBackInvalidateCache(VOID);
+
 XTCDECL
 VOID
 ArWriteControlRegister(IN USHORT ControlRegister,
@@ -285,6 +299,10 @@ XTAPI
 VOID
 ArpInitializeIdt(IN PKPROCESSOR_BLOCK ProcessorBlock);
 
+XTAPI
+VOID
+ArpInitializePageAttributeTable(VOID);
+
 XTAPI
 VOID
 ArpInitializeProcessorBlock(OUT PKPROCESSOR_BLOCK ProcessorBlock,
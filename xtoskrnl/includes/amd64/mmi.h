@@ -13,11 +13,38 @@
 
 
 /* AMD64 Memory Manager routines forward references */
+XTAPI
+VOID
+MmSwitchAddressSpace(IN PKPROCESS OldProcess,
+                     IN PKPROCESS NewProcess);
+
 XTFASTCALL
 VOID
 MmZeroPages(IN PVOID Address,
             IN ULONG Size);
 
+XTFASTCALL
+VOID
+MmZeroPagesNonTemporal(IN PVOID Address,
+                       IN ULONG Size);
+
+XTAPI
+XTSTATUS
+MmpAllocatePageTable(IN PMMPTE PointerPte);
+
+XTAPI
+VOID
+MmpAllocateProcessContextId(IN PKPROCESS Process);
+
+XTAPI
+BOOLEAN
+MmpFreeEmptyPageTables(IN PVOID VirtualAddress);
+
+XTAPI
+PMMPTE
+MmpGetMappingEntry(IN PVOID VirtualAddress,
+                   OUT PULONG_PTR PageSize);
+
 XTAPI
 PMMPTE
 MmpGetPdeAddress(PVOID Address);
@@ -34,10 +61,26 @@ XTAPI
 PMMPTE
 MmpGetPxeAddress(PVOID Address);
 
+XTAPI
+PVOID
+MmpGetVirtualAddressFromPte(IN PMMPTE PointerPte);
+
 XTAPI
 VOID
 MmpInitializeArchitecture(VOID);
 
+XTAPI
+XTSTATUS
+MmpMapLargestPage(IN PVOID VirtualAddress,
+                  IN PHYSICAL_ADDRESS PhysicalAddress,
+                  IN ULONG_PTR Size,
+                  OUT PULONG_PTR MappedSize);
+
+XTAPI
+XTSTATUS
+MmpMapPageTables(IN PVOID VirtualAddress,
+                 IN PFN_NUMBER PageCount);
+
 XTAPI
 BOOLEAN
 MmpMemoryExtensionEnabled(VOID);
@@ -0,0 +1,55 @@
+/**
+ * PROJECT:         ExectOS
+ * COPYRIGHT:       See COPYING.md in the top level directory
+ * FILE:            xtoskrnl/includes/exi.h
+ * DESCRIPTION:     Kernel executive routines
+ * DEVELOPERS:      Rafal Kupiec <belliash@codingworkshop.eu.org>
+ */
+
+#ifndef __XTOSKRNL_EXI_H
+#define __XTOSKRNL_EXI_H
+
+#include <xtos.h>
+
+
+/* Kernel Executive routines forward references */
+XTAPI
+VOID
+ExInitializeExecutive(VOID);
+
+XTAPI
+ULONG
+ExpAllocateFromSlabs(IN PEX_OBJECT_CACHE Cache,
+                     OUT PVOID *Objects,
+                     IN ULONG Count);
+
+XTAPI
+XTSTATUS
+ExpCreateSlab(IN PEX_OBJECT_CACHE Cache,
+              IN ULONG Color,
+              OUT PEX_CACHE_SLAB *Slab);
+
+XTAPI
+VOID
+ExpDestroySlab(IN PEX_OBJECT_CACHE Cache,
+               IN PEX_CACHE_SLAB Slab);
+
+XTAPI
+VOID
+ExpDumpPoolUsage(VOID);
+
+XTAPI
+VOID
+ExpFreeToSlabs(IN PEX_OBJECT_CACHE Cache,
+               IN PVOID *Objects,
+               IN ULONG Count);
+
+XTAPI
+PEX_POOL_TAG_ENTRY
+ExpGetPoolTagEntry(IN ULONG Tag);
+
+XTAPI
+XTSTATUS
+ExpInitializePool(VOID);
+
+#endif /* __XTOSKRNL_EXI_H */
@@ -12,6 +12,24 @@
 #include <xtos.h>
 
 
+/* List of all object caches */
+EXTERN LIST_ENTRY ExpObjectCacheListHead;
+
+/* Object caches list lock */
+EXTERN KSPIN_LOCK ExpObjectCacheListLock;
+
+/* Pool block sizes, including block header, for all pool size classes */
+EXTERN ULONG ExpPoolBlockSizes[EX_POOL_SIZE_CLASSES];
+
+/* Object caches backing pool size classes */
+EXTERN PEX_OBJECT_CACHE ExpPoolCaches[EX_POOL_SIZE_CLASSES];
+
+/* Pool usage of allocations, that did not fit in the pool tag table */
+EXTERN EX_POOL_TAG_ENTRY ExpPoolTagOverflow;
+
+/* Pool usage tracked by pool tag */
+EXTERN EX_POOL_TAG_ENTRY ExpPoolTagTable[EX_POOL_TAG_TABLE_SIZE];
+
 /* ACPI tables cache list */
 EXTERN LIST_ENTRY HlpAcpiCacheList;
 
@@ -51,17 +69,26 @@ EXTERN KSERVICE_DESCRIPTOR_TABLE KeServiceDescriptorTable[KSERVICE_TABLES_COUNT]
 /* Kernel process list */
 EXTERN LIST_ENTRY KepProcessListHead;
 
+/* Processor control blocks of all processors registered with the scheduler */
+EXTERN PKPROCESSOR_CONTROL_BLOCK KepProcessorControlBlocks[MAXIMUM_PROCESSORS];
+
+/* Kernel queued spinlocks */
+EXTERN KSPIN_LOCK KepQueuedSpinLocks[MaximumLock];
+
 /* Kernel system resources list */
 EXTERN LIST_ENTRY KepSystemResourcesListHead;
 
 /* Kernel system resources lock */
-EXTERN KSPIN_LOCK KepSystemResourcesLock;
+EXTERN KSHARED_SPIN_LOCK KepSystemResourcesLock;
 
 /* Kernel UBSAN active frame flag */
 EXTERN BOOLEAN KepUbsanActiveFrame;
 
+/* Number of pages available on the zeroed, free and standby lists */
+EXTERN PFN_NUMBER MmAvailablePages;
+
 /* Biggest free memory descriptor */
-EXTERN PLOADER_MEMORY_DESCRIPTOR MmFreeDescriptor;
+EXTERN PMMMEMORY_DESCRIPTOR MmFreeDescriptor;
 
 /* Highest physical page number */
 EXTERN ULONG_PTR MmHighestPhysicalPage;
@@ -73,24 +100,147 @@ EXTERN ULONG_PTR MmLowestPhysicalPage;
 EXTERN ULONG MmNumberOfPhysicalPages;
 
 /* Old biggest free memory descriptor */
-EXTERN LOADER_MEMORY_DESCRIPTOR MmOldFreeDescriptor;
+EXTERN MMMEMORY_DESCRIPTOR MmOldFreeDescriptor;
 
 /* Page Map Level */
 EXTERN ULONG MmPageMapLevel;
 
-/* Processor structures data (THIS IS A TEMPORARY HACK) */
-EXTERN UCHAR MmProcessorStructuresData[MAXIMUM_PROCESSORS][KPROCESSOR_STRUCTURES_SIZE];
+/* PFN database */
+EXTERN PMMPFN MmPfnDatabase;
+
+/* Buddy allocator bitmaps of free blocks, shared by all NUMA nodes */
+EXTERN RTL_BITMAP MmpBuddyBitmap[MM_MAXIMUM_BUDDY_ORDER + 1];
+
+/* Buddy allocator free areas, one per NUMA node and block order */
+EXTERN MMBUDDY_FREE_AREA MmpBuddyFreeArea[MM_MAXIMUM_NUMA_NODES][MM_MAXIMUM_BUDDY_ORDER + 1];
+
+/* Zeroed, free and standby page lists split by page color */
+EXTERN MMCOLOR_TABLES MmpFreePagesByColor[StandbyPageList + 1][MM_DEFAULT_SECONDARY_COLORS];
+
+/* Hardware layer large page pool slots bitmap */
+EXTERN RTL_BITMAP MmpHardwareLargeBitmap;
 
-/* Allocation descriptors dedicated for hardware layer */
-EXTERN LOADER_MEMORY_DESCRIPTOR MmpHardwareAllocationDescriptors[MM_HARDWARE_ALLOCATION_DESCRIPTORS];
+/* Hardware layer large page pool slots bitmap buffer */
+EXTERN ULONG_PTR MmpHardwareLargeBitmapBuffer[ROUND_UP(MM_HARDWARE_LARGE_VA_SIZE >> MM_LARGE_PAGE_SHIFT, BITS_PER_LONG) / BITS_PER_LONG];
 
-/* Live address of kernel's hardware heap */
-EXTERN PVOID MmpHardwareHeapStart;
+/* Number of pages of each size used to map hardware memory */
+EXTERN MMHARDWARE_MAPPING_STATISTICS MmpHardwareMappingStatistics;
+
+/* Hardware layer memory pool pages bitmap */
+EXTERN RTL_BITMAP MmpHardwareVaBitmap;
+
+/* Hardware layer memory pool pages bitmap buffer */
+EXTERN ULONG_PTR MmpHardwareVaBitmapBuffer[ROUND_UP(MM_HARDWARE_VA_SIZE >> MM_PAGE_SHIFT, BITS_PER_LONG) / BITS_PER_LONG];
+
+/* Next-fit hint, the page in hardware layer memory pool where the next search starts */
+EXTERN ULONG_PTR MmpHardwareVaHint;
+
+/* Hardware layer memory pool lock */
+EXTERN KSPIN_LOCK MmpHardwareVaLock;
+
+/* Kernel stacks pool bitmap */
+EXTERN RTL_BITMAP MmpKernelStackVaBitmap;
+
+/* Kernel stacks pool bitmap buffer */
+EXTERN ULONG_PTR MmpKernelStackVaBitmapBuffer[ROUND_UP(MM_KERNEL_STACK_VA_SIZE >> MM_PAGE_SHIFT, BITS_PER_LONG) / BITS_PER_LONG];
+
+/* Next-fit hint for kernel stacks pool allocations */
+EXTERN ULONG_PTR MmpKernelStackVaHint;
+
+/* Kernel stacks pool lock */
+EXTERN KSPIN_LOCK MmpKernelStackVaLock;
+
+/* Largest page size supported by the processor */
+EXTERN ULONG_PTR MmpLargestPageSize;
+
+/* Number of physical memory descriptors */
+EXTERN ULONG MmpMemoryDescriptorCount;
+
+/* Physical memory descriptors, sorted by base page and coalesced */
+EXTERN MMMEMORY_DESCRIPTOR MmpMemoryDescriptors[MM_MAXIMUM_MEMORY_DESCRIPTORS];
 
 /* Architecture-specific memory extension */
 EXTERN BOOLEAN MmpMemoryExtension;
 
-/* Number of used hardware allocation descriptors */
-EXTERN ULONG MmpUsedHardwareAllocationDescriptors;
+/* Next Process Context Identifier to be assigned */
+EXTERN ULONG MmpNextPcid;
+
+/* Number of NUMA nodes */
+EXTERN ULONG MmpNodeCount;
+
+/* Distances between NUMA nodes */
+EXTERN UCHAR MmpNodeDistance[MM_MAXIMUM_NUMA_NODES][MM_MAXIMUM_NUMA_NODES];
+
+/* NUMA nodes ordered by their distance from each node */
+EXTERN UCHAR MmpNodeFallbackOrder[MM_MAXIMUM_NUMA_NODES][MM_MAXIMUM_NUMA_NODES];
+
+/* ACPI proximity domains of NUMA nodes */
+EXTERN ULONG MmpNodeProximityDomain[MM_MAXIMUM_NUMA_NODES];
+
+/* Number of NUMA memory ranges */
+EXTERN ULONG MmpNumaMemoryRangeCount;
+
+/* Physical memory ranges of NUMA nodes */
+EXTERN MMNUMA_MEMORY_RANGE MmpNumaMemoryRanges[MM_MAXIMUM_NUMA_RANGES];
+
+/* Demand-zero page faults lock */
+EXTERN KSPIN_LOCK MmpPageFaultLock;
+
+/* Demand-zero page faults statistics */
+EXTERN MMPAGE_FAULT_STATISTICS MmpPageFaultStatistics;
+
+/* Instruction set used to zero pages in the background */
+EXTERN MMPAGE_ZEROING_METHOD MmpPageZeroingMethod;
+
+/* Number of pages on the zeroed, free and standby lists */
+EXTERN PFN_NUMBER MmpPageListCount[StandbyPageList + 1];
+
+/* Indicates whether Process Context Identifiers are in use */
+EXTERN BOOLEAN MmpPcidEnabled;
+
+/* Current Process Context Identifiers generation, bumped each time all identifiers get recycled */
+EXTERN ULONGLONG MmpPcidGeneration;
+
+/* Process Context Identifiers allocation lock */
+EXTERN KSPIN_LOCK MmpPcidLock;
+
+/* PFN database initialization flag */
+EXTERN BOOLEAN MmpPfnDatabaseInitialized;
+
+/* PFN database lock */
+EXTERN KSPIN_LOCK MmpPfnLock;
+
+/* Mask of page colors within a single NUMA node */
+EXTERN ULONG MmpSecondaryColorMask;
+
+/* Position of NUMA node number in page color */
+EXTERN ULONG MmpSecondaryColorNodeShift;
+
+/* Number of zeroed page requests, that had to be zeroed synchronously */
+EXTERN ULONG_PTR MmpSynchronousZeroCount;
+
+/* System pages pool bitmap */
+EXTERN RTL_BITMAP MmpSystemVaBitmap;
+
+/* System pages pool bitmap buffer */
+EXTERN ULONG_PTR MmpSystemVaBitmapBuffer[ROUND_UP(MM_SYSTEM_VA_SIZE >> MM_PAGE_SHIFT, BITS_PER_LONG) / BITS_PER_LONG];
+
+/* Next-fit hint for system pages pool allocations */
+EXTERN ULONG_PTR MmpSystemVaHint;
+
+/* System pages pool lock */
+EXTERN KSPIN_LOCK MmpSystemVaLock;
+
+/* Batch of TLB entries being invalidated by the TLB shootdown in progress */
+EXTERN PMMTLB_FLUSH_BATCH MmpTlbShootdownBatch;
+
+/* TLB shootdown lock */
+EXTERN KSPIN_LOCK MmpTlbShootdownLock;
+
+/* Processors, that have not yet acknowledged the TLB shootdown in progress */
+EXTERN VOLATILE KAFFINITY MmpTlbShootdownTargets;
+
+/* Request to zero free pages in the idle loop */
+EXTERN VOLATILE LONG MmpZeroPageRequest;
 
 #endif /* __XTOSKRNL_GLOBALS_H */
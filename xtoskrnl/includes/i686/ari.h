@@ -21,6 +21,10 @@ XTCDECL
 BOOLEAN
 ArCpuId(IN OUT PCPUID_REGISTERS Registers);
 
+XTCDECL
+VOID
+ArFlushCacheLine(IN PVOID Address);
+
 XTCDECL
 VOID
 ArFlushTlb(VOID);
@@ -46,6 +50,12 @@ XTCDECL
 BOOLEAN
 ArInterruptsEnabled(VOID);
 
+XTCDECL
+VOID
+ArInvalidatePcid(IN INVPCID_TYPE Type,
+                 IN ULONG_PTR Pcid,
+                 IN PVOID Address);
+
 XTCDECL
 VOID
 ArInvalidateTlbEntry(IN PVOID Address);
@@ -134,6 +144,10 @@ XTCDECL
 VOID
 ArStoreTaskRegister(OUT PVOID Destination);
 
+XTCDECL
+VOID
+ArWriteBackInvalidateCache(VOID);
+
 XTCDECL
 VOID
 ArWriteControlRegister(IN USHORT ControlRegister,
@@ -257,6 +271,10 @@ XTCDECL
 VOID
 ArpHandleTrap2E(IN PKTRAP_FRAME TrapFrame);
 
+XTCDECL
+VOID
+ArpHandleTrapE1(IN PKTRAP_FRAME TrapFrame);
+
 XTCDECL
 VOID
 ArpHandleTrapFF(IN PKTRAP_FRAME TrapFrame);
@@ -273,6 +291,10 @@ XTAPI
 VOID
 ArpInitializeIdt(IN PKPROCESSOR_BLOCK ProcessorBlock);
 
+XTAPI
+VOID
+ArpInitializePageAttributeTable(VOID);
+
 XTAPI
 VOID
 ArpInitializeProcessorBlock(OUT PKPROCESSOR_BLOCK ProcessorBlock,
@@ -429,4 +451,8 @@ XTCDECL
 VOID
 ArpTrap0x2E(VOID);
 
+XTCDECL
+VOID
+ArpTrap0xE1(VOID);
+
 #endif /* __XTOSKRNL_I686_ARI_H */
@@ -13,11 +13,34 @@
 
 
 /* i686 Memory Manager routines forward references */
+XTAPI
+VOID
+MmSwitchAddressSpace(IN PKPROCESS OldProcess,
+                     IN PKPROCESS NewProcess);
+
 XTFASTCALL
 VOID
 MmZeroPages(IN PVOID Address,
             IN ULONG Size);
 
+XTFASTCALL
+VOID
+MmZeroPagesNonTemporal(IN PVOID Address,
+                       IN ULONG Size);
+
+XTAPI
+XTSTATUS
+MmpAllocatePageTable(IN PMMPTE PointerPte);
+
+XTAPI
+BOOLEAN
+MmpFreeEmptyPageTables(IN PVOID VirtualAddress);
+
+XTAPI
+PMMPTE
+MmpGetMappingEntry(IN PVOID VirtualAddress,
+                   OUT PULONG_PTR PageSize);
+
 XTAPI
 PMMPTE
 MmpGetPdeAddress(PVOID Address);
@@ -26,10 +49,26 @@ XTAPI
 PMMPTE
 MmpGetPteAddress(PVOID Address);
 
+XTAPI
+PVOID
+MmpGetVirtualAddressFromPte(IN PMMPTE PointerPte);
+
 XTAPI
 VOID
 MmpInitializeArchitecture(VOID);
 
+XTAPI
+XTSTATUS
+MmpMapLargestPage(IN PVOID VirtualAddress,
+                  IN PHYSICAL_ADDRESS PhysicalAddress,
+                  IN ULONG_PTR Size,
+                  OUT PULONG_PTR MappedSize);
+
+XTAPI
+XTSTATUS
+MmpMapPageTables(IN PVOID VirtualAddress,
+                 IN PFN_NUMBER PageCount);
+
 XTAPI
 BOOLEAN
 MmpMemoryExtensionEnabled(VOID);
@@ -86,10 +86,19 @@ XTAPI
 VOID
 KeStartXtSystem(IN PKERNEL_INITIALIZATION_BLOCK Parameters);
 
+XTFASTCALL
+VOID
+KepAcquireQueuedSpinLock(IN OUT PKSPIN_LOCK_QUEUE LockQueue,
+                         IN PVOID CallSite);
+
 XTCDECL
 BOOLEAN
 KepCheckUbsanReport(PKUBSAN_SOURCE_LOCATION Location);
 
+XTFASTCALL
+VOID
+KepDeferredReadyThread(IN PKTHREAD Thread);
+
 XTCDECL
 VOID
 KepEnterUbsanFrame(PKUBSAN_SOURCE_LOCATION Location,
@@ -99,6 +108,11 @@ XTFASTCALL
 VOID
 KepExitDispatcher(IN KRUNLEVEL OldRunLevel);
 
+XTFASTCALL
+PKLOCK_STATISTICS
+KepGetLockStatistics(IN PKLOCK_PROFILE Profile,
+                     IN PVOID Lock);
+
 XTCDECL
 LONGLONG
 KepGetSignedUbsanValue(PKUBSAN_TYPE_DESCRIPTOR Type,
@@ -187,14 +201,46 @@ VOID
 KepHandleUbsanTypeMismatch(PKUBSAN_TYPE_MISMATCH_DATA Data,
                            ULONG_PTR Pointer);
 
+XTAPI
+VOID
+KepInitializeScheduler(IN PKPROCESSOR_CONTROL_BLOCK Prcb);
+
 XTAPI
 VOID
 KepInitializeSystemResources(VOID);
 
+XTFASTCALL
+VOID
+KepInsertReadyThread(IN PKPROCESSOR_CONTROL_BLOCK Prcb,
+                     IN PKTHREAD Thread);
+
 XTCDECL
 VOID
 KepLeaveUbsanFrame();
 
+XTFASTCALL
+VOID
+KepProcessDeferredReadyList(IN PKPROCESSOR_CONTROL_BLOCK Prcb);
+
+XTFASTCALL
+VOID
+KepProfileLockAcquired(IN PVOID Lock,
+                       IN ULONGLONG StartTime,
+                       IN BOOLEAN Contended,
+                       IN PVOID CallSite);
+
+XTFASTCALL
+VOID
+KepProfileLockReleased(IN PVOID Lock);
+
+XTFASTCALL
+VOID
+KepReadyThread(IN PKTHREAD Thread);
+
+XTFASTCALL
+VOID
+KepReleaseQueuedSpinLock(IN OUT PKSPIN_LOCK_QUEUE LockQueue);
+
 XTAPI
 VOID
 KepRemoveTimer(IN OUT PKTIMER Timer);
@@ -13,6 +13,18 @@
 
 
 /* Memory Manager routines forward references */
+XTAPI
+XTSTATUS
+MmAccessFault(IN ULONG_PTR FaultCode,
+              IN PVOID VirtualAddress);
+
+XTAPI
+XTSTATUS
+MmAllocateContiguousMemory(IN PFN_NUMBER PageCount,
+                           IN ULONG_PTR Alignment,
+                           IN PHYSICAL_ADDRESS HighestAddress,
+                           OUT PPHYSICAL_ADDRESS PhysicalAddress);
+
 XTAPI
 XTSTATUS
 MmAllocateHardwareMemory(IN PFN_NUMBER PageCount,
@@ -25,20 +37,56 @@ MmAllocateKernelStack(IN PVOID *Stack,
                       IN BOOLEAN LargeStack,
                       IN UCHAR SystemNode);
 
+XTAPI
+XTSTATUS
+MmAllocatePhysicalPage(IN BOOLEAN ZeroPage,
+                       OUT PPFN_NUMBER PageFrameNumber);
+
+XTAPI
+XTSTATUS
+MmAllocatePhysicalPageOnNode(IN ULONG NodeNumber,
+                             IN BOOLEAN ZeroPage,
+                             OUT PPFN_NUMBER PageFrameNumber);
+
 XTAPI
 XTSTATUS
 MmAllocateProcessorStructures(IN ULONG CpuNumber,
                               OUT PVOID *StructuresData);
 
+XTAPI
+XTSTATUS
+MmAllocateSystemPages(IN PFN_NUMBER PageCount,
+                      IN PFN_NUMBER Alignment,
+                      IN ULONG NodeNumber,
+                      OUT PVOID *VirtualAddress);
+
 XTAPI
 VOID
 MmFlushTlb(VOID);
 
+XTAPI
+VOID
+MmFlushTlbBatch(IN OUT PMMTLB_FLUSH_BATCH Batch);
+
+XTAPI
+VOID
+MmFlushTlbRange(IN PVOID VirtualAddress,
+                IN PFN_NUMBER PageCount);
+
+XTAPI
+VOID
+MmFreeContiguousMemory(IN PHYSICAL_ADDRESS PhysicalAddress,
+                       IN PFN_NUMBER PageCount);
+
 XTAPI
 VOID
 MmFreeKernelStack(IN PVOID Stack,
                   IN BOOLEAN LargeStack);
 
+XTAPI
+VOID
+MmFreePhysicalPage(IN PFN_NUMBER PageFrameNumber);
+
 XTAPI
 VOID
 MmFreeProcessorStructures(IN PVOID StructuresData);
@@ -47,17 +95,24 @@ XTAPI
 VOID
 MmInitializeMemoryManager(VOID);
 
+XTAPI
+VOID
+MmInitializeTlbFlushBatch(OUT PMMTLB_FLUSH_BATCH Batch,
+                          IN PKPROCESS Process);
+
 XTAPI
 XTSTATUS
 MmMapHardwareMemory(IN PHYSICAL_ADDRESS PhysicalAddress,
                     IN PFN_NUMBER PageCount,
+                    IN MEMORY_CACHING_TYPE CacheType,
                     IN BOOLEAN FlushTlb,
                     OUT PVOID *VirtualAddress);
 
 XTAPI
 VOID
-MmMarkHardwareMemoryWriteThrough(IN PVOID VirtualAddress,
-                                 IN PFN_NUMBER PageCount);
+MmQueueTlbFlush(IN OUT PMMTLB_FLUSH_BATCH Batch,
+                IN PVOID VirtualAddress,
+                IN PFN_NUMBER PageCount);
 
 XTAPI
 VOID
@@ -65,16 +120,256 @@ MmRemapHardwareMemory(IN PVOID VirtualAddress,
                       IN PHYSICAL_ADDRESS PhysicalAddress,
                       IN BOOLEAN FlushTlb);
 
+XTAPI
+XTSTATUS
+MmSetHardwareMemoryCacheType(IN PVOID VirtualAddress,
+                             IN PFN_NUMBER PageCount,
+                             IN MEMORY_CACHING_TYPE CacheType);
+
 XTAPI
 XTSTATUS
 MmUnmapHardwareMemory(IN PVOID VirtualAddress,
                       IN PFN_NUMBER PageCount,
                       IN BOOLEAN FlushTlb);
 
+XTAPI
+BOOLEAN
+MmZeroPagesOnIdle(VOID);
+
+XTAPI
+PFN_NUMBER
+MmpAllocateBootstrapPages(IN PFN_NUMBER PageCount);
+
+XTAPI
+XTSTATUS
+MmpAllocateBuddyBlock(IN ULONG NodeNumber,
+                      IN ULONG Order,
+                      IN PFN_NUMBER HighestPage,
+                      OUT PPFN_NUMBER PageFrameNumber);
+
+XTAPI
+XTSTATUS
+MmpAllocateBuddyBlockNearNode(IN ULONG NodeNumber,
+                              IN ULONG Order,
+                              IN PFN_NUMBER HighestPage,
+                              OUT PPFN_NUMBER PageFrameNumber);
+
+XTAPI
+XTSTATUS
+MmpAllocateSystemPage(OUT PPFN_NUMBER PageFrameNumber);
+
+XTAPI
+VOID
+MmpBuildNodeFallbackOrder(VOID);
+
+XTAPI
+VOID
+MmpDrainColorLists(VOID);
+
+XTAPI
+VOID
+MmpDrainPageMagazine(IN PMMPAGE_MAGAZINE Magazine,
+                     IN ULONG PageCount);
+
+XTAPI
+ULONG_PTR
+MmpFindLargeHardwareSlots(IN ULONG_PTR SlotCount,
+                          IN ULONG_PTR Alignment,
+                          IN ULONG_PTR PhysicalSlot);
+
+XTAPI
+PMMMEMORY_DESCRIPTOR
+MmpFindMemoryDescriptor(IN PFN_NUMBER PageFrameNumber);
+
+XTAPI
+VOID
+MmpFreeBuddyBlock(IN PFN_NUMBER PageFrameNumber,
+                  IN ULONG Order);
+
+XTAPI
+VOID
+MmpFreeBuddyRange(IN PFN_NUMBER PageFrameNumber,
+                  IN PFN_NUMBER PageCount);
+
+XTAPI
+VOID
+MmpFreeKernelStackPages(IN PVOID BaseAddress,
+                        IN PFN_NUMBER MappedPages,
+                        IN PFN_NUMBER StackPages);
+
+XTAPI
+MMBUDDY_ZONE
+MmpGetBuddyZone(IN PFN_NUMBER PageFrameNumber);
+
+XTAPI
+ULONG
+MmpGetMemoryDescriptorIndex(IN PFN_NUMBER PageFrameNumber);
+
+XTAPI
+ULONG
+MmpGetNodeColor(IN ULONG NodeNumber,
+                IN ULONG Color);
+
+XTAPI
+ULONG
+MmpGetNodeFromProximityDomain(IN ULONG ProximityDomain);
+
+XTAPI
+ULONG
+MmpGetPageColor(IN PFN_NUMBER PageFrameNumber);
+
+XTAPI
+ULONG
+MmpGetPhysicalPageNode(IN PFN_NUMBER PageFrameNumber);
+
+XTAPI
+ULONG
+MmpGetProcessorNode(IN ULONG CpuNumber);
+
+XTAPI
+VOID
+MmpInitializeBuddyAllocator(VOID);
+
+XTAPI
+VOID
+MmpInitializeHardwareVaBitmap(VOID);
+
+XTAPI
+VOID
+MmpInitializeMemoryDescriptors(VOID);
+
+XTAPI
+VOID
+MmpInitializeNumaTopology(VOID);
+
+XTAPI
+VOID
+MmpInitializePfnDatabase(VOID);
+
+XTAPI
+VOID
+MmpInsertBuddyBlock(IN PFN_NUMBER PageFrameNumber,
+                    IN ULONG Order);
+
+XTAPI
+XTSTATUS
+MmpInsertMemoryDescriptor(IN ULONG Index,
+                          IN PFN_NUMBER BasePage,
+                          IN PFN_NUMBER PageCount,
+                          IN LOADER_MEMORY_TYPE MemoryType);
+
+XTAPI
+VOID
+MmpInsertPageInColorList(IN PFN_NUMBER PageFrameNumber,
+                         IN MMPAGE_LIST ListName);
+
+XTAPI
+VOID
+MmpInvalidateTlbBatch(IN PMMTLB_FLUSH_BATCH Batch);
+
+XTAPI
+BOOLEAN
+MmpIsLargeHardwareAddress(IN PVOID VirtualAddress);
+
+XTAPI
+VOID
+MmpMapBootstrapMemory(IN PVOID VirtualAddress,
+                      IN PFN_NUMBER PageCount);
+
+XTAPI
+XTSTATUS
+MmpMapLargeHardwareMemory(IN PHYSICAL_ADDRESS PhysicalAddress,
+                          IN PFN_NUMBER PageCount,
+                          IN MEMORY_CACHING_TYPE CacheType,
+                          IN BOOLEAN FlushTlb,
+                          OUT PVOID *VirtualAddress);
+
+XTAPI
+VOID
+MmpMapPfnDatabase(VOID);
+
+XTAPI
+VOID
+MmpParseResourceAffinityTable(IN PACPI_SRAT Srat);
+
+XTAPI
+VOID
+MmpProcessTlbShootdown(VOID);
+
+XTAPI
+XTSTATUS
+MmpRefillColorLists(IN ULONG NodeNumber);
+
+XTAPI
+VOID
+MmpRefillPageMagazine(IN PKPROCESSOR_CONTROL_BLOCK Prcb);
+
+XTAPI
+VOID
+MmpReleasePhysicalPage(IN PFN_NUMBER PageFrameNumber);
+
+XTAPI
+VOID
+MmpRemoveBuddyBlock(IN PFN_NUMBER PageFrameNumber,
+                    IN ULONG Order);
+
+XTAPI
+VOID
+MmpRemoveMemoryDescriptor(IN ULONG Index);
+
+XTAPI
+XTSTATUS
+MmpRemovePageByColor(IN ULONG Color,
+                     IN BOOLEAN ZeroPage,
+                     OUT PPFN_NUMBER PageFrameNumber,
+                     OUT PMMPAGE_LIST PageList);
+
+XTAPI
+VOID
+MmpRemovePageFromColorList(IN PFN_NUMBER PageFrameNumber);
+
+XTAPI
+XTSTATUS
+MmpRemovePageFromColorTables(IN ULONG Color,
+                             IN PMMPAGE_LIST ListOrder,
+                             OUT PPFN_NUMBER PageFrameNumber,
+                             OUT PMMPAGE_LIST PageList);
+
+XTAPI
+VOID
+MmpRequestPageZeroing(VOID);
+
 XTAPI
 VOID
 MmpScanMemoryDescriptors(VOID);
 
+XTAPI
+VOID
+MmpSendTlbShootdown(IN PMMTLB_FLUSH_BATCH Batch,
+                    IN KAFFINITY TargetProcessors);
+
+XTAPI
+XTSTATUS
+MmpSetMemoryDescriptorType(IN PFN_NUMBER BasePage,
+                           IN PFN_NUMBER PageCount,
+                           IN LOADER_MEMORY_TYPE MemoryType);
+
+XTAPI
+VOID
+MmpSetPteCacheType(IN PMMPTE PointerPte,
+                   IN ULONG_PTR PageSize,
+                   IN MEMORY_CACHING_TYPE CacheType);
+
+XTAPI
+XTSTATUS
+MmpSplitLargePage(IN PMMPTE PointerPte,
+                  IN ULONG_PTR PageSize);
+
+XTAPI
+XTSTATUS
+MmpUnmapLargeHardwareMemory(IN PVOID VirtualAddress,
+                            IN PFN_NUMBER PageCount);
+
 XTAPI
 BOOLEAN
 MmpVerifyMemoryTypeFree(LOADER_MEMORY_TYPE MemoryType);
@@ -83,4 +378,13 @@ XTAPI
 BOOLEAN
 MmpVerifyMemoryTypeInvisible(LOADER_MEMORY_TYPE MemoryType);
 
+XTAPI
+ULONG
+MmpZeroFreePages(VOID);
+
+XTAPI
+XTSTATUS
+MmpZeroPhysicalPage(IN PFN_NUMBER PageFrameNumber,
+                    IN BOOLEAN NonTemporal);
+
 #endif /* __XTOSKRNL_MMI_H */
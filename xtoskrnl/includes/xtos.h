@@ -14,6 +14,7 @@
 
 /* Kernel specific headers */
 #include "globals.h"
+#include "exi.h"
 #include "hli.h"
 #include "kei.h"
 #include "mmi.h"
@@ -27,11 +27,17 @@ KSERVICE_DESCRIPTOR_TABLE KeServiceDescriptorTable[KSERVICE_TABLES_COUNT];
 /* Kernel process list */
 LIST_ENTRY KepProcessListHead;
 
+/* Processor control blocks of all processors registered with the scheduler */
+PKPROCESSOR_CONTROL_BLOCK KepProcessorControlBlocks[MAXIMUM_PROCESSORS];
+
+/* Kernel queued spinlocks */
+KSPIN_LOCK KepQueuedSpinLocks[MaximumLock];
+
 /* Kernel system resources list */
 LIST_ENTRY KepSystemResourcesListHead;
 
 /* Kernel system resources lock */
-KSPIN_LOCK KepSystemResourcesLock;
+KSHARED_SPIN_LOCK KepSystemResourcesLock;
 
 /* Kernel UBSAN active frame flag */
 BOOLEAN KepUbsanActiveFrame = FALSE;
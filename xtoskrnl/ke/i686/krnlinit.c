@@ -30,6 +30,12 @@ KepInitializeKernel(VOID)
         DebugPrint(L"Failed to initialize hardware layer subsystem!\n");
         KePanic(0);
     }
+
+    /* Initialize memory manager */
+    MmInitializeMemoryManager();
+
+    /* Initialize kernel executive */
+    ExInitializeExecutive();
 }
 
 /**
@@ -80,6 +86,9 @@ KepStartKernel(VOID)
     /* Initialize CPU power state structures */
     PoInitializeProcessorControlBlock(Prcb);
 
+    /* Initialize processor ready queues */
+    KepInitializeScheduler(Prcb);
+
     /* Save processor state */
     KepSaveProcessorState(&Prcb->ProcessorState);
 
@@ -91,13 +100,13 @@ KepStartKernel(VOID)
 
     /* Initialize Idle process */
     RtlInitializeListHead(&KepProcessListHead);
-    PageDirectory[0] = 0;
+    PageDirectory[0] = ArReadControlRegister(3);
     PageDirectory[1] = 0;
     KeInitializeProcess(CurrentProcess, 0, 0xFFFFFFFF, PageDirectory, FALSE);
     CurrentProcess->Quantum = MAXCHAR;
 
     /* Initialize Idle thread */
-    KeInitializeThread(CurrentProcess, CurrentThread, NULL, NULL, NULL, NULL, NULL, ArKernelBootStack, TRUE);
+    KeInitializeThread(CurrentProcess, CurrentThread, NULL, NULL, NULL, NULL, NULL, ArKernelBootStack, FALSE);
     CurrentThread->NextProcessor = Prcb->CpuNumber;
     CurrentThread->Priority = THREAD_HIGH_PRIORITY;
     CurrentThread->State = Running;
@@ -105,9 +114,16 @@ KepStartKernel(VOID)
     CurrentThread->WaitRunLevel = DISPATCH_LEVEL;
     CurrentProcess->ActiveProcessors |= (ULONG_PTR)1 << Prcb->CpuNumber;
 
-    /* Enter infinite loop */
-    DebugPrint(L"KepStartKernel() finished. Entering infinite loop.\n");
-    for(;;);
+    /* Enter idle loop */
+    DebugPrint(L"KepStartKernel() finished. Entering idle loop.\n");
+    for(;;)
+    {
+        /* Zero free pages when there is nothing else to do, halt otherwise */
+        if(!MmZeroPagesOnIdle())
+        {
+            ArHalt();
+        }
+    }
 }
 
 /**
@@ -50,6 +50,9 @@ KeInitializeProcess(IN OUT PKPROCESS Process,
     RtlInitializeListHead(&Process->ReadyListHead);
     RtlInitializeListHead(&Process->ThreadListHead);
 
+    /* Initialize process lock */
+    KeInitializeSpinLock(&Process->ProcessLock);
+
     /* Set base process properties */
     Process->BasePriority = Priority;
     Process->Affinity = Affinity;
@@ -57,6 +60,12 @@ KeInitializeProcess(IN OUT PKPROCESS Process,
     Process->DirectoryTable[0] = DirectoryTable[0];
     Process->DirectoryTable[1] = DirectoryTable[1];
     Process->StackCount = MAXSHORT;
+    Process->ThreadSeed = 0;
+
+    /* Process Context Identifier gets assigned on first address space switch */
+    Process->Pcid = 0;
+    Process->PcidGeneration = 0;
+    Process->PcidStaleProcessors = 0;
 
     /* Set thread quantum */
     Process->Quantum = THREAD_QUANTUM;
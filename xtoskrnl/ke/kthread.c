@@ -85,6 +85,11 @@ KeInitializeThread(IN PKPROCESS Process,
     /* Set priority adjustment reason */
     Thread->AdjustReason = AdjustNone;
 
+    /* Inherit priority and quantum from the process */
+    Thread->BasePriority = Process->BasePriority;
+    Thread->Priority = Process->BasePriority;
+    Thread->Quantum = Process->Quantum;
+
     /* Initialize thread lock */
     KeInitializeSpinLock(&Thread->ThreadLock);
 
@@ -191,7 +196,57 @@ XTAPI
 VOID
 KeStartThread(IN PKTHREAD Thread)
 {
-    UNIMPLEMENTED;
+    KAFFINITY Processors;
+    KRUNLEVEL OldRunLevel;
+    PKPROCESS Process;
+    ULONG Processor;
+
+    /* Get thread's process */
+    Process = Thread->ApcState.Process;
+
+    /* Raise runlevel and acquire process lock */
+    OldRunLevel = KeRaiseRunLevel(DISPATCH_LEVEL);
+    KeAcquireSpinLock(&Process->ProcessLock);
+
+    /* Inherit affinity and boost settings from the process */
+    Thread->Affinity = Process->Affinity;
+    Thread->UserAffinity = Process->Affinity;
+    Thread->DisableBoost = Process->DisableBoost;
+    Thread->Iopl = Process->Iopl;
+
+    /* Spread threads of the process across the processors it is allowed to run on */
+    Processors = Process->Affinity & HlpActiveProcessors;
+    if(Processors)
+    {
+        /* Take the first available processor starting from the seed, wrap around if there is none */
+        Processor = Process->ThreadSeed;
+        if(Processor >= sizeof(KAFFINITY) * 8 || !(Processors >> Processor))
+        {
+            Processor = 0;
+        }
+        Processor += RtlCountTrailingZeroes64((ULONGLONG)(Processors >> Processor));
+    }
+    else
+    {
+        /* No processor available yet, stay on the current one */
+        Processor = KeGetCurrentProcessorControlBlock()->CpuNumber;
+    }
+
+    /* Set ideal processor and advance the seed for the next thread */
+    Thread->IdealProcessor = (UCHAR)Processor;
+    Thread->UserIdealProcessor = (UCHAR)Processor;
+    Thread->NextProcessor = (UCHAR)Processor;
+    Process->ThreadSeed = (UCHAR)(Processor + 1);
+
+    /* Insert thread into the process thread list */
+    RtlInsertTailList(&Process->ThreadListHead, &Thread->ThreadListEntry);
+
+    /* Release process lock */
+    KeReleaseSpinLock(&Process->ProcessLock);
+
+    /* Ready the thread and exit the dispatcher */
+    KepReadyThread(Thread);
+    KepExitDispatcher(OldRunLevel);
 }
 
 /**
@@ -208,7 +263,23 @@ XTFASTCALL
 VOID
 KepExitDispatcher(IN KRUNLEVEL OldRunLevel)
 {
-    UNIMPLEMENTED;
+    PKPROCESSOR_CONTROL_BLOCK Prcb;
+
+    /* Get current processor control block */
+    Prcb = KeGetCurrentProcessorControlBlock();
+
+    /* Place all threads readied in the meantime in the ready queues */
+    if(Prcb->DeferredReadyListHead.Next)
+    {
+        KepProcessDeferredReadyList(Prcb);
+    }
+
+    /* Check if another thread has been selected to preempt the current one */
+    if(Prcb->NextThread)
+    {
+        /* Context switch is not supported yet */
+        UNIMPLEMENTED;
+    }
 
     /* Lower runlevel */
     KeLowerRunLevel(OldRunLevel);
@@ -0,0 +1,216 @@
+/**
+ * PROJECT:         ExectOS
+ * COPYRIGHT:       See COPYING.md in the top level directory
+ * FILE:            xtoskrnl/ke/lockprof.c
+ * DESCRIPTION:     Spinlock contention profiling
+ * DEVELOPERS:      Rafal Kupiec <belliash@codingworkshop.eu.org>
+ */
+
+#include <xtos.h>
+
+
+/**
+ * Prints the spinlock profiling statistics gathered by all processors to the debug port.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+KeDumpLockStatistics(VOID)
+{
+#ifdef LOCKPROF
+    PKPROCESSOR_CONTROL_BLOCK Prcb;
+    PKLOCK_STATISTICS Statistics;
+    ULONG Index, Processor;
+
+    /* Iterate through all processors registered with the scheduler */
+    for(Processor = 0; Processor < MAXIMUM_PROCESSORS; Processor++)
+    {
+        /* Skip processors that are not running */
+        Prcb = KepProcessorControlBlocks[Processor];
+        if(!Prcb)
+        {
+            continue;
+        }
+
+        /* Print processor header */
+        DebugPrint(L"CPU%lu spinlock statistics (%zu events dropped):\n",
+                   Processor, Prcb->LockProfile.DroppedEvents);
+
+        /* Iterate through all locks tracked by the processor */
+        for(Index = 0; Index < KLOCK_PROFILE_ENTRIES; Index++)
+        {
+            /* Skip unused entries */
+            Statistics = &Prcb->LockProfile.Locks[Index];
+            if(!Statistics->Lock)
+            {
+                continue;
+            }
+
+            /* Print lock statistics, times are given in TSC cycles */
+            DebugPrint(L"   Lock=%P, Acquired=%zu, Contended=%zu, Spin=%llu (Max=%llu at %P), Hold=%llu (Max=%llu)\n",
+                       Statistics->Lock, Statistics->Acquisitions, Statistics->ContendedAcquisitions,
+                       Statistics->SpinCycles, Statistics->MaximumSpinCycles, Statistics->MaximumSpinCallSite,
+                       Statistics->HoldCycles, Statistics->MaximumHoldCycles);
+        }
+    }
+#else
+    /* Spinlock profiling buffers are not compiled in, print a hint only */
+    DebugPrint(L"Spinlock profiling not enabled in this build\n");
+#endif
+}
+
+/**
+ * Looks up the profiling statistics entry of the given spinlock in the per-processor buffer, claiming a new entry
+ * when the lock is seen for the first time.
+ *
+ * @param Profile
+ *        Supplies a pointer to the per-processor spinlock profiling buffer.
+ *
+ * @param Lock
+ *        Supplies a pointer to the spinlock.
+ *
+ * @return This routine returns a pointer to the statistics entry, or NULL if the buffer is full.
+ *
+ * @since XT 1.0
+ */
+XTFASTCALL
+PKLOCK_STATISTICS
+KepGetLockStatistics(IN PKLOCK_PROFILE Profile,
+                     IN PVOID Lock)
+{
+    PKLOCK_STATISTICS Statistics;
+    ULONG Index, Probe;
+
+    /* Hash the lock address, dropping the bits that are always zero due to alignment */
+    Index = (ULONG)((ULONG_PTR)Lock >> 3) & (KLOCK_PROFILE_ENTRIES - 1);
+
+    /* Probe the buffer linearly */
+    for(Probe = 0; Probe < KLOCK_PROFILE_ENTRIES; Probe++)
+    {
+        /* Check if the entry describes the lock */
+        Statistics = &Profile->Locks[(Index + Probe) & (KLOCK_PROFILE_ENTRIES - 1)];
+        if(Statistics->Lock == Lock)
+        {
+            /* Return existing entry */
+            return Statistics;
+        }
+
+        /* Check if the entry is unused */
+        if(!Statistics->Lock)
+        {
+            /* Claim the entry for the lock */
+            Statistics->Lock = Lock;
+            return Statistics;
+        }
+    }
+
+    /* Buffer is full */
+    return NULL;
+}
+
+/**
+ * Accounts a spinlock acquisition in the current processor's profiling buffer.
+ *
+ * @param Lock
+ *        Supplies a pointer to the acquired spinlock.
+ *
+ * @param StartTime
+ *        Supplies the time stamp counter value read before the first attempt to acquire the lock.
+ *
+ * @param Contended
+ *        Specifies whether the lock was owned by another processor on the first attempt.
+ *
+ * @param CallSite
+ *        Supplies the address the lock has been acquired from.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTFASTCALL
+VOID
+KepProfileLockAcquired(IN PVOID Lock,
+                       IN ULONGLONG StartTime,
+                       IN BOOLEAN Contended,
+                       IN PVOID CallSite)
+{
+#ifdef LOCKPROF
+    PKPROCESSOR_CONTROL_BLOCK Prcb;
+    PKLOCK_STATISTICS Statistics;
+    ULONGLONG CurrentTime, SpinTime;
+
+    /* Get the time spent on spinning */
+    CurrentTime = ArReadTimeStampCounter();
+    SpinTime = CurrentTime - StartTime;
+
+    /* Get lock statistics from the current processor's buffer, so no synchronization is needed */
+    Prcb = KeGetCurrentProcessorControlBlock();
+    Statistics = KepGetLockStatistics(&Prcb->LockProfile, Lock);
+    if(!Statistics)
+    {
+        /* Too many locks tracked, drop the event */
+        Prcb->LockProfile.DroppedEvents++;
+        return;
+    }
+
+    /* Account the acquisition */
+    Statistics->Acquisitions++;
+    Statistics->AcquireTime = CurrentTime;
+
+    /* Check if the lock was contended */
+    if(Contended)
+    {
+        /* Account the time spent on spinning */
+        Statistics->ContendedAcquisitions++;
+        Statistics->SpinCycles += SpinTime;
+        if(SpinTime > Statistics->MaximumSpinCycles)
+        {
+            /* Remember the worst case along with its call site */
+            Statistics->MaximumSpinCycles = SpinTime;
+            Statistics->MaximumSpinCallSite = CallSite;
+        }
+    }
+#endif
+}
+
+/**
+ * Accounts a spinlock release in the current processor's profiling buffer.
+ *
+ * @param Lock
+ *        Supplies a pointer to the released spinlock.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTFASTCALL
+VOID
+KepProfileLockReleased(IN PVOID Lock)
+{
+#ifdef LOCKPROF
+    PKLOCK_STATISTICS Statistics;
+    ULONGLONG HoldTime;
+
+    /* Get lock statistics from the current processor's buffer */
+    Statistics = KepGetLockStatistics(&KeGetCurrentProcessorControlBlock()->LockProfile, Lock);
+    if(!Statistics || !Statistics->AcquireTime)
+    {
+        /* Acquisition has not been accounted on this processor */
+        return;
+    }
+
+    /* Account the time the lock has been held */
+    HoldTime = ArReadTimeStampCounter() - Statistics->AcquireTime;
+    Statistics->HoldCycles += HoldTime;
+    if(HoldTime > Statistics->MaximumHoldCycles)
+    {
+        Statistics->MaximumHoldCycles = HoldTime;
+    }
+
+    /* Mark the lock as released */
+    Statistics->AcquireTime = 0;
+#endif
+}
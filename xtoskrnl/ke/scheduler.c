@@ -0,0 +1,243 @@
+/**
+ * PROJECT:         ExectOS
+ * COPYRIGHT:       See COPYING.md in the top level directory
+ * FILE:            xtoskrnl/ke/scheduler.c
+ * DESCRIPTION:     Per-processor priority ready queues
+ * DEVELOPERS:      Rafal Kupiec <belliash@codingworkshop.eu.org>
+ */
+
+#include <xtos.h>
+
+
+/**
+ * Places the deferred ready thread either on standby or in the ready queue of the processor it is going to run on.
+ *
+ * @param Thread
+ *        Supplies a pointer to the thread in the deferred ready state.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTFASTCALL
+VOID
+KepDeferredReadyThread(IN PKTHREAD Thread)
+{
+    PKPROCESSOR_CONTROL_BLOCK Prcb;
+    PKTHREAD NextThread;
+    KAFFINITY Processors;
+    ULONG Processor;
+    BOOLEAN Preempt;
+
+    /* Get processors the thread is allowed to run on */
+    Processors = Thread->Affinity & HlpActiveProcessors;
+    Processor = Thread->NextProcessor;
+
+    /* Check if the thread can stay on the processor it ran on last time */
+    if(!(Processors & ((KAFFINITY)1 << Processor)) || !KepProcessorControlBlocks[Processor])
+    {
+        /* Check if any processor is available to the thread */
+        if(Processors)
+        {
+            /* Pick the first processor allowed by the affinity */
+            Processor = RtlCountTrailingZeroes64((ULONGLONG)Processors);
+        }
+
+        /* Fall back to the current processor if the chosen one is not registered with the scheduler */
+        if(!KepProcessorControlBlocks[Processor])
+        {
+            Processor = KeGetCurrentProcessorControlBlock()->CpuNumber;
+        }
+    }
+
+    /* Get target processor control block and remember the choice */
+    Prcb = KepProcessorControlBlocks[Processor];
+    Thread->NextProcessor = (UCHAR)Processor;
+
+    /* Acquire processor control block lock */
+    KeAcquireSpinLock(&Prcb->PrcbLock);
+
+    /* Check if the thread should run right after the current thread */
+    Preempt = FALSE;
+    NextThread = Prcb->NextThread;
+    if(!NextThread)
+    {
+        /* Check if the thread has a higher priority than the thread currently running */
+        if(Prcb->CurrentThread && Thread->Priority > Prcb->CurrentThread->Priority)
+        {
+            /* Put the thread on standby, it preempts the current thread on next dispatch */
+            Thread->State = Standby;
+            Prcb->NextThread = Thread;
+            Preempt = TRUE;
+        }
+    }
+    else if(Thread->Priority > NextThread->Priority)
+    {
+        /* Replace the standby thread, which goes back to the front of its ready queue */
+        Thread->State = Standby;
+        Prcb->NextThread = Thread;
+        NextThread->Preempted = TRUE;
+        KepInsertReadyThread(Prcb, NextThread);
+        Preempt = TRUE;
+    }
+
+    /* Check if the thread has been put on standby */
+    if(!Preempt)
+    {
+        /* Insert the thread into the ready queue */
+        KepInsertReadyThread(Prcb, Thread);
+    }
+
+    /* Release processor control block lock */
+    KeReleaseSpinLock(&Prcb->PrcbLock);
+
+    /* Check if another processor has to preempt its current thread */
+    if(Preempt && Prcb != KeGetCurrentProcessorControlBlock())
+    {
+        /* Send IPI to the processor, so it leaves the idle loop and dispatches the standby thread */
+        HlpSendIpi(HlpSystemInfo.CpuInfo[Prcb->CpuNumber].ApicId, APIC_VECTOR_IPI);
+    }
+}
+
+/**
+ * Initializes the ready queues of the processor and registers it with the scheduler.
+ *
+ * @param Prcb
+ *        Supplies a pointer to the processor control block.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+KepInitializeScheduler(IN PKPROCESSOR_CONTROL_BLOCK Prcb)
+{
+    ULONG Priority;
+
+    /* Initialize processor control block lock */
+    KeInitializeSpinLock(&Prcb->PrcbLock);
+
+    /* Initialize deferred ready list */
+    Prcb->DeferredReadyListHead.Next = NULL;
+
+    /* Initialize ready queues, all of them are empty */
+    for(Priority = 0; Priority < THREAD_MAXIMUM_PRIORITY; Priority++)
+    {
+        RtlInitializeListHead(&Prcb->DispatcherReadyListHead[Priority]);
+    }
+    Prcb->ReadySummary = 0;
+
+    /* Register processor with the scheduler */
+    KepProcessorControlBlocks[Prcb->CpuNumber] = Prcb;
+}
+
+/**
+ * Inserts the thread into the ready queue of the given processor and marks the queue as non-empty.
+ *
+ * @param Prcb
+ *        Supplies a pointer to the processor control block owning the ready queue.
+ *
+ * @param Thread
+ *        Supplies a pointer to the thread to be inserted.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ *
+ * @note The caller must hold the processor control block lock.
+ */
+XTFASTCALL
+VOID
+KepInsertReadyThread(IN PKPROCESSOR_CONTROL_BLOCK Prcb,
+                     IN PKTHREAD Thread)
+{
+    KPRIORITY Priority;
+
+    /* Mark thread as ready */
+    Priority = Thread->Priority;
+    Thread->State = Ready;
+
+    /* Check if the thread has been preempted */
+    if(Thread->Preempted)
+    {
+        /* Preempted thread did not consume its quantum, let it run first */
+        Thread->Preempted = FALSE;
+        RtlInsertHeadList(&Prcb->DispatcherReadyListHead[Priority], &Thread->WaitListEntry);
+    }
+    else
+    {
+        /* Append thread to the end of the ready queue */
+        RtlInsertTailList(&Prcb->DispatcherReadyListHead[Priority], &Thread->WaitListEntry);
+    }
+
+    /* Mark ready queue as non-empty */
+    Prcb->ReadySummary |= (1UL << Priority);
+}
+
+/**
+ * Processes all threads queued on the deferred ready list of the given processor.
+ *
+ * @param Prcb
+ *        Supplies a pointer to the processor control block.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTFASTCALL
+VOID
+KepProcessDeferredReadyList(IN PKPROCESSOR_CONTROL_BLOCK Prcb)
+{
+    PSINGLE_LIST_ENTRY Entry;
+    PKTHREAD Thread;
+
+    /* Detach the whole deferred ready list at once */
+    Entry = RtlAtomicExchangePointer((PVOID*)&Prcb->DeferredReadyListHead.Next, NULL);
+
+    /* Iterate through all deferred ready threads */
+    while(Entry)
+    {
+        /* Get thread and advance to the next entry before the list entry gets reused */
+        Thread = CONTAIN_RECORD(Entry, KTHREAD, SwapListEntry);
+        Entry = Entry->Next;
+
+        /* Place thread on the target processor */
+        KepDeferredReadyThread(Thread);
+    }
+}
+
+/**
+ * Readies the thread by queueing it on the deferred ready list of the current processor. No lock gets acquired,
+ * thus this routine can be called from interrupt service routines.
+ *
+ * @param Thread
+ *        Supplies a pointer to the thread to be readied.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTFASTCALL
+VOID
+KepReadyThread(IN PKTHREAD Thread)
+{
+    PKPROCESSOR_CONTROL_BLOCK Prcb;
+    PSINGLE_LIST_ENTRY Head;
+
+    /* Get current processor control block */
+    Prcb = KeGetCurrentProcessorControlBlock();
+
+    /* Mark thread as deferred ready */
+    Thread->State = DeferredReady;
+    Thread->DeferredProcessor = Prcb->CpuNumber;
+
+    /* Push thread onto the deferred ready list, it might be interrupted by another push or the list detach */
+    do
+    {
+        Head = Prcb->DeferredReadyListHead.Next;
+        Thread->SwapListEntry.Next = Head;
+    }
+    while(RtlAtomicCompareExchangePointer((PVOID*)&Prcb->DeferredReadyListHead.Next,
+                                          Head, &Thread->SwapListEntry) != Head);
+}
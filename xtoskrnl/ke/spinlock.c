@@ -9,6 +9,33 @@
 #include <xtos.h>
 
 
+/**
+ * Acquires a specified spinlock as a queued spinlock, using a lock queue entry supplied by the caller, usually
+ * allocated on the stack. Raises the runlevel to DISPATCH_LEVEL.
+ *
+ * @param SpinLock
+ *        Supplies a pointer to the kernel spin lock.
+ *
+ * @param LockHandle
+ *        Supplies a pointer to the lock queue handle, that has to be passed to the release routine.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since NT 5.1
+ */
+XTFASTCALL
+VOID
+KeAcquireInStackQueuedSpinLock(IN OUT PKSPIN_LOCK SpinLock,
+                               OUT PKLOCK_QUEUE_HANDLE LockHandle)
+{
+    /* Set the lock the queue entry waits for */
+    LockHandle->LockQueue.Lock = SpinLock;
+
+    /* Raise runlevel and acquire the queued spinlock */
+    LockHandle->OldRunLevel = KeRaiseRunLevel(DISPATCH_LEVEL);
+    KepAcquireQueuedSpinLock(&LockHandle->LockQueue, __builtin_return_address(0));
+}
+
 /**
  * Acquires a specified queued spinlock.
  *
@@ -23,8 +50,8 @@ XTFASTCALL
 VOID
 KeAcquireQueuedSpinLock(IN KSPIN_LOCK_QUEUE_LEVEL LockLevel)
 {
-    /* Acquire the queued spinlock */
-    KeAcquireSpinLock(KeGetCurrentProcessorControlBlock()->LockQueue[LockLevel].Lock);
+    /* Acquire the queued spinlock using current processor's lock queue entry */
+    KepAcquireQueuedSpinLock(&KeGetCurrentProcessorControlBlock()->LockQueue[LockLevel], __builtin_return_address(0));
 }
 
 /**
@@ -41,9 +68,19 @@ XTFASTCALL
 VOID
 KeAcquireSpinLock(IN OUT PKSPIN_LOCK SpinLock)
 {
+    ULONGLONG StartTime;
+    BOOLEAN Contended;
+
+    /* Store the time when spinning begins if profiling spinlocks */
+    StartTime = LOCK_PROFILING ? ArReadTimeStampCounter() : 0;
+    Contended = FALSE;
+
     /* Try to acquire the lock */
     while(RtlAtomicBitTestAndSet((PLONG)SpinLock, 0))
     {
+        /* Lock owned by someone else */
+        Contended = TRUE;
+
         /* Wait until locked is cleared */
         while(*(VOLATILE PKSPIN_LOCK)SpinLock & 1)
         {
@@ -54,6 +91,117 @@ KeAcquireSpinLock(IN OUT PKSPIN_LOCK SpinLock)
 
     /* Add an explicit memory barrier */
     ArReadWriteBarrier();
+
+    /* Check if spinlock profiling is enabled */
+    if(LOCK_PROFILING)
+    {
+        /* Account the acquisition */
+        KepProfileLockAcquired(SpinLock, StartTime, Contended, __builtin_return_address(0));
+    }
+}
+
+/**
+ * Acquires a shared spinlock for exclusive (write) access. A waiting writer blocks new readers, so it cannot starve.
+ *
+ * @param SpinLock
+ *        Supplies a pointer to the shared spinlock.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTFASTCALL
+VOID
+KeAcquireSpinLockExclusive(IN OUT PKSHARED_SPIN_LOCK SpinLock)
+{
+    LONG Value;
+
+    /* Keep trying until the lock gets acquired */
+    while(TRUE)
+    {
+        /* Check if neither a writer nor any reader holds the lock */
+        Value = *(VOLATILE PKSHARED_SPIN_LOCK)SpinLock;
+        if(!(Value & ~SHARED_SPIN_LOCK_WAITING))
+        {
+            /* Try to take the lock, clearing the waiting flag */
+            if(RtlAtomicCompareExchange32(SpinLock, Value, (LONG)SHARED_SPIN_LOCK_EXCLUSIVE) == Value)
+            {
+                /* Lock acquired */
+                break;
+            }
+            continue;
+        }
+
+        /* Announce a waiting writer to stop new readers from entering */
+        if(!(Value & SHARED_SPIN_LOCK_WAITING))
+        {
+            RtlAtomicOr32(SpinLock, SHARED_SPIN_LOCK_WAITING);
+        }
+
+        /* Yield processor and keep waiting */
+        ArYieldProcessor();
+    }
+
+    /* Add an explicit memory barrier */
+    ArReadWriteBarrier();
+}
+
+/**
+ * Acquires a shared spinlock for shared (read) access. Any number of readers can hold the lock at the same time.
+ *
+ * @param SpinLock
+ *        Supplies a pointer to the shared spinlock.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTFASTCALL
+VOID
+KeAcquireSpinLockShared(IN OUT PKSHARED_SPIN_LOCK SpinLock)
+{
+    LONG Value;
+
+    /* Keep trying until the lock gets acquired */
+    while(TRUE)
+    {
+        /* Check if the lock is neither owned by a writer nor awaited by one */
+        Value = *(VOLATILE PKSHARED_SPIN_LOCK)SpinLock;
+        if(!(Value & (SHARED_SPIN_LOCK_EXCLUSIVE | SHARED_SPIN_LOCK_WAITING)))
+        {
+            /* Try to increment the readers count */
+            if(RtlAtomicCompareExchange32(SpinLock, Value, Value + 1) == Value)
+            {
+                /* Lock acquired */
+                break;
+            }
+            continue;
+        }
+
+        /* Yield processor and keep waiting */
+        ArYieldProcessor();
+    }
+
+    /* Add an explicit memory barrier */
+    ArReadWriteBarrier();
+}
+
+/**
+ * Initializes a shared (reader-writer) spinlock object.
+ *
+ * @param SpinLock
+ *        Supplies a pointer to the shared spinlock.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+KeInitializeSharedSpinLock(IN PKSHARED_SPIN_LOCK SpinLock)
+{
+    /* Zero initialize spinlock */
+    *SpinLock = 0;
 }
 
 /**
@@ -74,6 +222,25 @@ KeInitializeSpinLock(IN PKSPIN_LOCK SpinLock)
     *SpinLock = 0;
 }
 
+/**
+ * Releases a queued spinlock acquired with KeAcquireInStackQueuedSpinLock() and restores the original runlevel.
+ *
+ * @param LockHandle
+ *        Supplies a pointer to the lock queue handle.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since NT 5.1
+ */
+XTFASTCALL
+VOID
+KeReleaseInStackQueuedSpinLock(IN PKLOCK_QUEUE_HANDLE LockHandle)
+{
+    /* Release the queued spinlock and lower runlevel */
+    KepReleaseQueuedSpinLock(&LockHandle->LockQueue);
+    KeLowerRunLevel(LockHandle->OldRunLevel);
+}
+
 /**
  * Releases a queued spinlock.
  *
@@ -88,8 +255,8 @@ XTFASTCALL
 VOID
 KeReleaseQueuedSpinLock(IN KSPIN_LOCK_QUEUE_LEVEL LockLevel)
 {
-    /* Clear the lock */
-    KeReleaseSpinLock(KeGetCurrentProcessorControlBlock()->LockQueue[LockLevel].Lock);
+    /* Release the queued spinlock, handing it over to the next waiter */
+    KepReleaseQueuedSpinLock(&KeGetCurrentProcessorControlBlock()->LockQueue[LockLevel]);
 }
 
 /**
@@ -106,9 +273,210 @@ XTFASTCALL
 VOID
 KeReleaseSpinLock(IN OUT PKSPIN_LOCK SpinLock)
 {
+    /* Check if spinlock profiling is enabled */
+    if(LOCK_PROFILING)
+    {
+        /* Account the time the lock has been held */
+        KepProfileLockReleased(SpinLock);
+    }
+
     /* Clear the lock */
     RtlAtomicAnd32((PLONG)SpinLock, 0);
 
     /* Add an explicit memory barrier */
     ArReadWriteBarrier();
 }
+
+/**
+ * Releases a shared spinlock acquired for exclusive access.
+ *
+ * @param SpinLock
+ *        Supplies a pointer to the shared spinlock.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTFASTCALL
+VOID
+KeReleaseSpinLockExclusive(IN OUT PKSHARED_SPIN_LOCK SpinLock)
+{
+    /* Add an explicit memory barrier */
+    ArReadWriteBarrier();
+
+    /* Clear the owner flag, leaving the waiting flag set by other writers */
+    RtlAtomicAnd32(SpinLock, ~(LONG)SHARED_SPIN_LOCK_EXCLUSIVE);
+}
+
+/**
+ * Releases a shared spinlock acquired for shared access.
+ *
+ * @param SpinLock
+ *        Supplies a pointer to the shared spinlock.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTFASTCALL
+VOID
+KeReleaseSpinLockShared(IN OUT PKSHARED_SPIN_LOCK SpinLock)
+{
+    /* Add an explicit memory barrier */
+    ArReadWriteBarrier();
+
+    /* Decrement the readers count */
+    RtlAtomicDecrement32(SpinLock);
+}
+
+/**
+ * Attempts to convert a shared spinlock held for shared access into exclusive access. This succeeds only if the
+ * caller is the only reader holding the lock.
+ *
+ * @param SpinLock
+ *        Supplies a pointer to the shared spinlock.
+ *
+ * @return This routine returns TRUE if the lock has been converted, or FALSE if it is still held shared.
+ *
+ * @since XT 1.0
+ */
+XTFASTCALL
+BOOLEAN
+KeTryConvertSharedSpinLockExclusive(IN OUT PKSHARED_SPIN_LOCK SpinLock)
+{
+    LONG Value;
+
+    /* Check if the caller is the only reader */
+    Value = *(VOLATILE PKSHARED_SPIN_LOCK)SpinLock;
+    if((Value & (SHARED_SPIN_LOCK_EXCLUSIVE | SHARED_SPIN_LOCK_SHARED_MASK)) != 1)
+    {
+        /* Other readers hold the lock, conversion not possible */
+        return FALSE;
+    }
+
+    /* Try to replace the only reader with the writer, preserving the waiting flag */
+    if(RtlAtomicCompareExchange32(SpinLock, Value,
+                                  (Value & SHARED_SPIN_LOCK_WAITING) | (LONG)SHARED_SPIN_LOCK_EXCLUSIVE) != Value)
+    {
+        /* Lock state changed in the meantime, conversion failed */
+        return FALSE;
+    }
+
+    /* Add an explicit memory barrier and return success */
+    ArReadWriteBarrier();
+    return TRUE;
+}
+
+/**
+ * Acquires a queued (MCS) spinlock. The lock word holds the last entry of the waiters queue, while every waiter spins
+ * only on its own queue entry, until the previous owner hands the lock over in FIFO order.
+ *
+ * @param LockQueue
+ *        Supplies a pointer to the lock queue entry of the acquiring processor.
+ *
+ * @param CallSite
+ *        Supplies the address the lock is acquired from, used by spinlock profiling only.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTFASTCALL
+VOID
+KepAcquireQueuedSpinLock(IN OUT PKSPIN_LOCK_QUEUE LockQueue,
+                         IN PVOID CallSite)
+{
+    PKSPIN_LOCK_QUEUE Tail;
+    ULONGLONG StartTime;
+
+    /* Store the time when spinning begins if profiling spinlocks */
+    StartTime = LOCK_PROFILING ? ArReadTimeStampCounter() : 0;
+
+    /* Make the entry the new tail of the waiters queue */
+    LockQueue->Next = NULL;
+    Tail = RtlAtomicExchangePointer((PVOID*)LockQueue->Lock, LockQueue);
+
+    /* Check if the lock is already owned */
+    if(Tail)
+    {
+        /* Mark the entry as waiting before linking it, so the owner cannot hand the lock over too early */
+        LockQueue->Lock = (PKSPIN_LOCK)((ULONG_PTR)LockQueue->Lock | LOCK_QUEUE_WAIT);
+        ArReadWriteBarrier();
+        Tail->Next = LockQueue;
+
+        /* Spin on the own entry until the lock is handed over */
+        while((ULONG_PTR)(*(VOLATILE PKSPIN_LOCK *)&LockQueue->Lock) & LOCK_QUEUE_WAIT)
+        {
+            /* Yield processor and keep waiting */
+            ArYieldProcessor();
+        }
+    }
+
+    /* Mark the entry as the lock owner */
+    LockQueue->Lock = (PKSPIN_LOCK)((ULONG_PTR)LockQueue->Lock | LOCK_QUEUE_OWNER);
+
+    /* Add an explicit memory barrier */
+    ArReadWriteBarrier();
+
+    /* Check if spinlock profiling is enabled */
+    if(LOCK_PROFILING)
+    {
+        /* Account the acquisition, lock is contended if there was a queue already */
+        KepProfileLockAcquired((PVOID)((ULONG_PTR)LockQueue->Lock & ~(LOCK_QUEUE_OWNER | LOCK_QUEUE_WAIT)),
+                               StartTime, (BOOLEAN)(Tail != NULL), CallSite);
+    }
+}
+
+/**
+ * Releases a queued (MCS) spinlock, handing it over to the next waiter if there is any.
+ *
+ * @param LockQueue
+ *        Supplies a pointer to the lock queue entry of the owning processor.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTFASTCALL
+VOID
+KepReleaseQueuedSpinLock(IN OUT PKSPIN_LOCK_QUEUE LockQueue)
+{
+    PKSPIN_LOCK_QUEUE Next;
+    PKSPIN_LOCK SpinLock;
+
+    /* Add an explicit memory barrier */
+    ArReadWriteBarrier();
+
+    /* Clear the owner flag */
+    SpinLock = (PKSPIN_LOCK)((ULONG_PTR)LockQueue->Lock & ~(LOCK_QUEUE_OWNER | LOCK_QUEUE_WAIT));
+    LockQueue->Lock = SpinLock;
+
+    /* Check if spinlock profiling is enabled */
+    if(LOCK_PROFILING)
+    {
+        /* Account the time the lock has been held */
+        KepProfileLockReleased(SpinLock);
+    }
+
+    /* Check if any waiter is linked behind this entry */
+    Next = *(VOLATILE PKSPIN_LOCK_QUEUE *)&LockQueue->Next;
+    if(!Next)
+    {
+        /* Try to free the lock, what succeeds if this entry is still the tail of the queue */
+        if(RtlAtomicCompareExchangePointer((PVOID*)SpinLock, LockQueue, NULL) == LockQueue)
+        {
+            /* Lock released */
+            return;
+        }
+
+        /* Another processor is just enqueuing, wait until it links its entry */
+        while(!(Next = *(VOLATILE PKSPIN_LOCK_QUEUE *)&LockQueue->Next))
+        {
+            /* Yield processor and keep waiting */
+            ArYieldProcessor();
+        }
+    }
+
+    /* Hand the lock over to the next waiter */
+    Next->Lock = (PKSPIN_LOCK)((ULONG_PTR)Next->Lock & ~LOCK_QUEUE_WAIT);
+}
@@ -68,15 +68,15 @@ XTAPI
 VOID
 KeReleaseSystemResource(IN PSYSTEM_RESOURCE_HEADER ResourceHeader)
 {
-    /* Disable interrupts and acquire a spinlock */
+    /* Disable interrupts and acquire a spinlock in shared mode, the list itself does not change */
     ArClearInterruptFlag();
-    KeAcquireSpinLock(&KepSystemResourcesLock);
+    KeAcquireSpinLockShared(&KepSystemResourcesLock);
 
     /* Release resource lock */
     ResourceHeader->ResourceLocked = FALSE;
 
     /* Release spinlock and enable interrupts */
-    KeReleaseSpinLock(&KepSystemResourcesLock);
+    KeReleaseSpinLockShared(&KepSystemResourcesLock);
     ArSetInterruptFlag();
 }
 
@@ -113,9 +113,9 @@ KepGetSystemResource(IN SYSTEM_RESOURCE_TYPE ResourceType,
     /* Check if interrupts are enabled */
     Interrupts = ArInterruptsEnabled();
 
-    /* Disable interrupts and acquire a spinlock */
+    /* Disable interrupts and acquire a spinlock in shared mode, so lookups can run concurrently */
     ArClearInterruptFlag();
-    KeAcquireSpinLock(&KepSystemResourcesLock);
+    KeAcquireSpinLockShared(&KepSystemResourcesLock);
 
     /* Iterate through system resources list */
     ListEntry = KepSystemResourcesListHead.Flink;
@@ -127,19 +127,20 @@ KepGetSystemResource(IN SYSTEM_RESOURCE_TYPE ResourceType,
         /* Check if resource type matches */
         if(Resource->ResourceType == ResourceType)
         {
-            /* Check if resource is locked */
-            if(Resource->ResourceLocked)
-            {
-                /* Resource locked, set status code and stop browsing a list */
-                Status = STATUS_RESOURCE_LOCKED;
-                break;
-            }
-
             /* Check if resource lock should be acquired */
             if(ResourceLock)
             {
-                /* Acquire resource lock */
-                Resource->ResourceLocked = TRUE;
+                /* Acquire resource lock atomically, as other readers might try to acquire it as well */
+                if(RtlAtomicCompareExchange8((PCHAR)&Resource->ResourceLocked, FALSE, TRUE) != FALSE)
+                {
+                    /* Resource already locked by someone else, set status code */
+                    Status = STATUS_RESOURCE_LOCKED;
+                }
+            }
+            else if(Resource->ResourceLocked)
+            {
+                /* Resource locked, set status code */
+                Status = STATUS_RESOURCE_LOCKED;
             }
 
             /* Stop browsing a list */
@@ -159,7 +160,7 @@ KepGetSystemResource(IN SYSTEM_RESOURCE_TYPE ResourceType,
     }
 
     /* Release spinlock and re-enable interrupts if necessary */
-    KeReleaseSpinLock(&KepSystemResourcesLock);
+    KeReleaseSpinLockShared(&KepSystemResourcesLock);
     if(Interrupts)
     {
         /* Re-enable interrupts */
@@ -187,7 +188,7 @@ KepInitializeSystemResources(VOID)
     ULONG ResourceSize;
 
     /* Initialize system resources spin lock and resource list */
-    KeInitializeSpinLock(&KepSystemResourcesLock);
+    KeInitializeSharedSpinLock(&KepSystemResourcesLock);
     RtlInitializeListHead(&KepSystemResourcesListHead);
 
     /* Make sure there are some system resources available */
@@ -85,10 +85,28 @@ MmpGetPxeAddress(PVOID Address)
 {
     ULONGLONG Offset;
 
-    Offset = (((ULONGLONG)Address >> MM_PXI_SHIFT) & (MM_PXE_PER_PAGE - 1));
+    Offset = ((((ULONGLONG)Address >> MM_PXI_SHIFT) & (MM_PXE_PER_PAGE - 1)) << MM_PTE_SHIFT);
     return (PMMPTE)(MM_PXE_BASE + Offset);
 }
 
+/**
+ * Gets the virtual address, that is mapped by the given PTE (or any higher level paging structure entry).
+ *
+ * @param PointerPte
+ *        Specifies the address of the paging structure entry within the self-mapped page tables.
+ *
+ * @return This routine returns the virtual address mapped by the given entry.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+PVOID
+MmpGetVirtualAddressFromPte(IN PMMPTE PointerPte)
+{
+    /* Calculate the mapped address and sign-extend it to the canonical form */
+    return (PVOID)((LONGLONG)(((ULONGLONG)PointerPte - MM_PTE_BASE) << 25) >> 16);
+}
+
 /**
  * Performs architecture specific initialization of the XTOS Memory Manager.
  *
@@ -100,7 +118,54 @@ XTAPI
 VOID
 MmpInitializeArchitecture(VOID)
 {
-    UNIMPLEMENTED;
+    CPUID_REGISTERS CpuRegisters;
+    ULONG MaximumLeaf;
+
+    /* SSE2 is architectural on AMD64, so non-temporal stores are always available */
+    MmpPageZeroingMethod = PageZeroingNonTemporal;
+
+    /* Check if Process Context Identifiers are supported and boot page map uses PCID 0 */
+    if((KeGetCurrentProcessorControlBlock()->CpuId.FeatureBits & KF_PCID) &&
+       !(ArReadControlRegister(3) & MM_CR3_PCID_MASK))
+    {
+        /* Enable PCIDs, so address space switches do not have to flush the whole TLB */
+        ArWriteControlRegister(4, ArReadControlRegister(4) | CR4_PCIDE);
+        MmpPcidEnabled = TRUE;
+    }
+
+    /* Get highest supported extended CPUID leaf */
+    CpuRegisters.Leaf = CPUID_GET_EXTENDED_MAXIMUM;
+    CpuRegisters.SubLeaf = 0;
+    ArCpuId(&CpuRegisters);
+    MaximumLeaf = CpuRegisters.Eax;
+
+    /* Check if extended features are reported */
+    if(MaximumLeaf >= CPUID_GET_EXTENDED_FEATURES)
+    {
+        /* Check if 1GB pages are supported */
+        CpuRegisters.Leaf = CPUID_GET_EXTENDED_FEATURES;
+        CpuRegisters.SubLeaf = 0;
+        ArCpuId(&CpuRegisters);
+        if(CpuRegisters.Edx & CPUID_FEATURES_EXTENDED_EDX_PAGE1GB)
+        {
+            /* Allow mapping memory with 1GB pages */
+            MmpLargestPageSize = MM_HUGE_PAGE_SIZE;
+        }
+    }
+
+    /* Check if extended address sizes are reported */
+    if(MaximumLeaf >= CPUID_GET_EXTENDED_ADDRESS_SIZES)
+    {
+        /* Check if CLZERO instruction is supported */
+        CpuRegisters.Leaf = CPUID_GET_EXTENDED_ADDRESS_SIZES;
+        CpuRegisters.SubLeaf = 0;
+        ArCpuId(&CpuRegisters);
+        if(CpuRegisters.Ebx & CPUID_FEATURES_EXTENDED_EBX_CLZERO)
+        {
+            /* Zero whole cache lines without reading them first */
+            MmpPageZeroingMethod = PageZeroingCacheLineZero;
+        }
+    }
 }
 
 /**
@@ -9,6 +9,85 @@
 #include <xtos.h>
 
 
+/**
+ * Switches the current processor to the address space of the given process.
+ *
+ * @param OldProcess
+ *        Supplies a pointer to the process, that the current processor is leaving, or NULL.
+ *
+ * @param NewProcess
+ *        Supplies a pointer to the process, that the current processor is switching to.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmSwitchAddressSpace(IN PKPROCESS OldProcess,
+                     IN PKPROCESS NewProcess)
+{
+    PKPROCESSOR_CONTROL_BLOCK Prcb;
+    KAFFINITY Processor;
+    BOOLEAN NoFlush;
+
+    /* Get current processor control block and its affinity */
+    Prcb = KeGetCurrentProcessorControlBlock();
+    Processor = (KAFFINITY)1 << Prcb->CpuNumber;
+
+    /* Update sets of processors running both processes */
+    if(OldProcess)
+    {
+        RtlAtomicAnd64((PLONG_PTR)&OldProcess->ActiveProcessors, ~Processor);
+    }
+    RtlAtomicOr64((PLONG_PTR)&NewProcess->ActiveProcessors, Processor);
+
+    /* Check if Process Context Identifiers are in use */
+    if(!MmpPcidEnabled)
+    {
+        /* Load new page map, this flushes all non-global TLB entries */
+        ArWriteControlRegister(3, NewProcess->DirectoryTable[0]);
+        return;
+    }
+
+    /* Make sure the process owns a PCID from the current generation */
+    if(NewProcess->PcidGeneration != MmpPcidGeneration)
+    {
+        /* Assign new PCID to the process */
+        MmpAllocateProcessContextId(NewProcess);
+    }
+
+    /* Check if PCIDs have been recycled since this processor last synchronized with the allocator */
+    if(Prcb->PcidGeneration != NewProcess->PcidGeneration)
+    {
+        /* Entries tagged with recycled PCIDs might be cached, invalidate all contexts */
+        if(Prcb->CpuId.FeatureBits & KF_INVPCID)
+        {
+            /* Invalidate all non-global entries of all PCIDs */
+            ArInvalidatePcid(InvpcidAllContexts, 0, NULL);
+        }
+        else
+        {
+            /* Flush the whole TLB */
+            MmFlushTlb();
+        }
+
+        /* Processor is in sync with the current generation and the new PCID is clean */
+        Prcb->PcidGeneration = NewProcess->PcidGeneration;
+        RtlAtomicAnd64((PLONG_PTR)&NewProcess->PcidStaleProcessors, ~Processor);
+        NoFlush = TRUE;
+    }
+    else
+    {
+        /* PCID entries can be kept, unless the process page tables changed since it last ran here */
+        NoFlush = (RtlAtomicAnd64((PLONG_PTR)&NewProcess->PcidStaleProcessors, ~Processor) & Processor) ? FALSE : TRUE;
+    }
+
+    /* Load new page map tagged with the PCID, without flushing its TLB entries if they are still valid */
+    ArWriteControlRegister(3, (NewProcess->DirectoryTable[0] & ~(ULONG_PTR)MM_CR3_PCID_MASK) | NewProcess->Pcid |
+                              (NoFlush ? MM_CR3_NO_FLUSH : 0));
+}
+
 /**
  * Fills a section of memory with zeroes like RtlZeroMemory(), but in more efficient way.
  *
@@ -40,3 +119,481 @@ MmZeroPages(IN PVOID Address,
                    "ecx",
                    "memory");
 }
+
+/**
+ * Fills a section of memory with zeroes using non-temporal stores, bypassing the processor caches. This is intended
+ * for zeroing pages, that are not going to be accessed soon, like these zeroed in the background.
+ *
+ * @param Address
+ *        Supplies an address of the page to be filled with zeroes.
+ *
+ * @param Size
+ *        Number of bytes to be filled with zeros. This always should be a multiply of page size.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTFASTCALL
+VOID
+MmZeroPagesNonTemporal(IN PVOID Address,
+                       IN ULONG Size)
+{
+    PUCHAR CacheLine;
+
+    /* Check which zeroing method is supported by the processor */
+    switch(MmpPageZeroingMethod)
+    {
+        case PageZeroingCacheLineZero:
+            /* Zero memory one cache line at a time */
+            for(CacheLine = (PUCHAR)Address; CacheLine < (PUCHAR)Address + Size; CacheLine += 64)
+            {
+                asm volatile("clzero"
+                             :
+                             : "a" (CacheLine)
+                             : "memory");
+            }
+
+            /* Make sure all stores are globally visible */
+            asm volatile("sfence" ::: "memory");
+            break;
+        case PageZeroingNonTemporal:
+            /* Zero memory using non-temporal stores */
+            asm volatile("xor %%rax, %%rax\n"
+                         "1:\n"
+                         "movnti %%rax, 0(%0)\n"
+                         "movnti %%rax, 8(%0)\n"
+                         "movnti %%rax, 16(%0)\n"
+                         "movnti %%rax, 24(%0)\n"
+                         "movnti %%rax, 32(%0)\n"
+                         "movnti %%rax, 40(%0)\n"
+                         "movnti %%rax, 48(%0)\n"
+                         "movnti %%rax, 56(%0)\n"
+                         "add $64, %0\n"
+                         "sub $64, %1\n"
+                         "jnz 1b\n"
+                         "sfence\n"
+                         : "+r" (Address),
+                           "+r" (Size)
+                         :
+                         : "rax",
+                           "memory");
+            break;
+        default:
+            /* Non-temporal stores not supported, fall back to standard routine */
+            MmZeroPages(Address, Size);
+            break;
+    }
+}
+
+/**
+ * Allocates a new page table and links it into the given paging structure entry.
+ *
+ * @param PointerPte
+ *        Supplies a pointer to the paging structure entry, that will map the new page table.
+ *
+ * @return This routine returns a status code.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+XTSTATUS
+MmpAllocatePageTable(IN PMMPTE PointerPte)
+{
+    PFN_NUMBER PageFrameNumber;
+    PVOID PageTable;
+    XTSTATUS Status;
+
+    /* Allocate physical page for the new page table */
+    Status = MmpAllocateSystemPage(&PageFrameNumber);
+    if(Status != STATUS_SUCCESS)
+    {
+        /* Failed to allocate page, return error */
+        return Status;
+    }
+
+    /* Link the page table into the paging structure */
+    PointerPte->Long = 0;
+    PointerPte->Hardware.PageFrameNumber = PageFrameNumber;
+    PointerPte->Hardware.Valid = 1;
+    PointerPte->Hardware.Writable = 1;
+
+    /* Get the page table address within the self-mapped page tables */
+    PageTable = MmpGetVirtualAddressFromPte(PointerPte);
+
+    /* Make sure no stale translation exists and zero the new page table */
+    ArInvalidateTlbEntry(PageTable);
+    MmZeroPages(PageTable, MM_PAGE_SIZE);
+
+    /* Return success */
+    return STATUS_SUCCESS;
+}
+
+/**
+ * Assigns a Process Context Identifier (PCID) from the current generation to the given process.
+ *
+ * @param Process
+ *        Supplies a pointer to the process.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmpAllocateProcessContextId(IN PKPROCESS Process)
+{
+    KRUNLEVEL OldRunLevel;
+
+    /* Raise runlevel and acquire PCID lock */
+    OldRunLevel = KeRaiseRunLevel(DISPATCH_LEVEL);
+    KeAcquireSpinLock(&MmpPcidLock);
+
+    /* Make sure PCID has not been assigned in the meantime */
+    if(Process->PcidGeneration != MmpPcidGeneration)
+    {
+        /* Check if all PCIDs are in use */
+        if(MmpNextPcid >= MM_PCID_COUNT)
+        {
+            /* Start new generation, each processor flushes all PCIDs once it notices the change */
+            MmpPcidGeneration++;
+            MmpNextPcid = 1;
+        }
+
+        /* Assign next PCID, PCID 0 is left for the boot page map */
+        Process->Pcid = MmpNextPcid++;
+        Process->PcidGeneration = MmpPcidGeneration;
+    }
+
+    /* Release PCID lock and lower runlevel */
+    KeReleaseSpinLock(&MmpPcidLock);
+    KeLowerRunLevel(OldRunLevel);
+}
+
+/**
+ * Frees paging structures mapping the large page sized region containing the given address, if they do not map
+ * anything anymore.
+ *
+ * @param VirtualAddress
+ *        Supplies a virtual address within the region.
+ *
+ * @return This routine returns TRUE if the region is not mapped anymore, or FALSE otherwise.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+BOOLEAN
+MmpFreeEmptyPageTables(IN PVOID VirtualAddress)
+{
+    PMMPTE PointerPde, PointerPpe, PointerPte;
+    PFN_NUMBER PageFrameNumber;
+    ULONG Index;
+
+    /* Check if PML4 and PML3 entries are present */
+    PointerPpe = MmpGetPpeAddress(VirtualAddress);
+    if(!MmpGetPxeAddress(VirtualAddress)->Hardware.Valid || !PointerPpe->Hardware.Valid)
+    {
+        /* Region is not mapped */
+        return TRUE;
+    }
+
+    /* Check if region is a part of 1GB page */
+    if(PointerPpe->Hardware.LargePage)
+    {
+        /* Region is still mapped */
+        return FALSE;
+    }
+
+    /* Check if PML2 entry is present */
+    PointerPde = MmpGetPdeAddress(VirtualAddress);
+    if(PointerPde->Hardware.Valid)
+    {
+        /* Check if region is mapped by 2MB page */
+        if(PointerPde->Hardware.LargePage)
+        {
+            /* Region is still mapped */
+            return FALSE;
+        }
+
+        /* Check if any page in the page table is still mapped */
+        PointerPte = MmpGetPteAddress((PVOID)ROUND_DOWN((ULONG_PTR)VirtualAddress, MM_LARGE_PAGE_SIZE));
+        for(Index = 0; Index < MM_PTE_PER_PAGE; Index++)
+        {
+            if(PointerPte[Index].Hardware.Valid)
+            {
+                /* Region is still mapped */
+                return FALSE;
+            }
+        }
+
+        /* Free the page table */
+        PageFrameNumber = PointerPde->Hardware.PageFrameNumber;
+        PointerPde->Long = 0;
+        ArInvalidateTlbEntry(PointerPte);
+        MmFreePhysicalPage(PageFrameNumber);
+    }
+
+    /* Check if any entry in the page directory is still present */
+    PointerPde = MmpGetPdeAddress((PVOID)ROUND_DOWN((ULONG_PTR)VirtualAddress, MM_HUGE_PAGE_SIZE));
+    for(Index = 0; Index < MM_PDE_PER_PAGE; Index++)
+    {
+        if(PointerPde[Index].Hardware.Valid)
+        {
+            /* Page directory is still in use, but the region itself is not mapped */
+            return TRUE;
+        }
+    }
+
+    /* Free the page directory */
+    PageFrameNumber = PointerPpe->Hardware.PageFrameNumber;
+    PointerPpe->Long = 0;
+    ArInvalidateTlbEntry(PointerPde);
+    MmFreePhysicalPage(PageFrameNumber);
+
+    /* Region is not mapped anymore */
+    return TRUE;
+}
+
+/**
+ * Looks up the paging structure entry, that maps the given virtual address, regardless of the page size.
+ *
+ * @param VirtualAddress
+ *        Supplies the virtual address to look up.
+ *
+ * @param PageSize
+ *        Supplies a pointer to the variable that receives the size of the memory mapped by the entry. If address
+ *        is not mapped, it receives the size of the region described by the missing entry.
+ *
+ * @return This routine returns a pointer to the paging structure entry, or NULL if the address is not mapped.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+PMMPTE
+MmpGetMappingEntry(IN PVOID VirtualAddress,
+                   OUT PULONG_PTR PageSize)
+{
+    PMMPTE PointerPte;
+
+    /* Check PML4 entry */
+    PointerPte = MmpGetPxeAddress(VirtualAddress);
+    if(!PointerPte->Hardware.Valid)
+    {
+        /* Address is not mapped */
+        *PageSize = (ULONG_PTR)1 << MM_PXI_SHIFT;
+        return NULL;
+    }
+
+    /* Check PML3 entry */
+    PointerPte = MmpGetPpeAddress(VirtualAddress);
+    if(!PointerPte->Hardware.Valid || PointerPte->Hardware.LargePage)
+    {
+        /* Address is either not mapped or mapped by 1GB page */
+        *PageSize = MM_HUGE_PAGE_SIZE;
+        return PointerPte->Hardware.Valid ? PointerPte : NULL;
+    }
+
+    /* Check PML2 entry */
+    PointerPte = MmpGetPdeAddress(VirtualAddress);
+    if(!PointerPte->Hardware.Valid || PointerPte->Hardware.LargePage)
+    {
+        /* Address is either not mapped or mapped by 2MB page */
+        *PageSize = MM_LARGE_PAGE_SIZE;
+        return PointerPte->Hardware.Valid ? PointerPte : NULL;
+    }
+
+    /* Check PML1 entry */
+    PointerPte = MmpGetPteAddress(VirtualAddress);
+    *PageSize = MM_PAGE_SIZE;
+    return PointerPte->Hardware.Valid ? PointerPte : NULL;
+}
+
+/**
+ * Maps the given physical address using the largest page, that the alignment of both addresses and the size of
+ * the remaining range allow.
+ *
+ * @param VirtualAddress
+ *        Supplies the page aligned virtual address to be mapped.
+ *
+ * @param PhysicalAddress
+ *        Supplies the page aligned physical address to be mapped.
+ *
+ * @param Size
+ *        Supplies the size of the remaining range to be mapped, in bytes.
+ *
+ * @param MappedSize
+ *        Supplies a pointer to the variable that receives the size of the page used.
+ *
+ * @return This routine returns a status code.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+XTSTATUS
+MmpMapLargestPage(IN PVOID VirtualAddress,
+                  IN PHYSICAL_ADDRESS PhysicalAddress,
+                  IN ULONG_PTR Size,
+                  OUT PULONG_PTR MappedSize)
+{
+    PMMPTE PointerPte;
+    XTSTATUS Status;
+
+    /* Make sure PML4 entry is present */
+    PointerPte = MmpGetPxeAddress(VirtualAddress);
+    if(!PointerPte->Hardware.Valid)
+    {
+        /* Allocate new page directory pointer table */
+        Status = MmpAllocatePageTable(PointerPte);
+        if(Status != STATUS_SUCCESS)
+        {
+            /* Failed to allocate page table, return error */
+            return Status;
+        }
+    }
+
+    /* Check if 1GB page can be used */
+    PointerPte = MmpGetPpeAddress(VirtualAddress);
+    if(!PointerPte->Hardware.Valid && MmpLargestPageSize >= MM_HUGE_PAGE_SIZE && Size >= MM_HUGE_PAGE_SIZE &&
+       !((ULONG_PTR)VirtualAddress & (MM_HUGE_PAGE_SIZE - 1)) && !(PhysicalAddress.QuadPart & (MM_HUGE_PAGE_SIZE - 1)))
+    {
+        /* Map 1GB page */
+        PointerPte->Long = 0;
+        PointerPte->Hardware.PageFrameNumber = (PFN_NUMBER)(PhysicalAddress.QuadPart >> MM_PAGE_SHIFT);
+        PointerPte->Hardware.LargePage = 1;
+        PointerPte->Hardware.Valid = 1;
+        PointerPte->Hardware.Writable = 1;
+        *MappedSize = MM_HUGE_PAGE_SIZE;
+        return STATUS_SUCCESS;
+    }
+
+    /* Make sure PML3 entry is present */
+    if(!PointerPte->Hardware.Valid)
+    {
+        /* Allocate new page directory */
+        Status = MmpAllocatePageTable(PointerPte);
+        if(Status != STATUS_SUCCESS)
+        {
+            /* Failed to allocate page table, return error */
+            return Status;
+        }
+    }
+
+    /* Check if 2MB page can be used */
+    PointerPte = MmpGetPdeAddress(VirtualAddress);
+    if(!PointerPte->Hardware.Valid && Size >= MM_LARGE_PAGE_SIZE &&
+       !((ULONG_PTR)VirtualAddress & (MM_LARGE_PAGE_SIZE - 1)) && !(PhysicalAddress.QuadPart & (MM_LARGE_PAGE_SIZE - 1)))
+    {
+        /* Map 2MB page */
+        PointerPte->Long = 0;
+        PointerPte->Hardware.PageFrameNumber = (PFN_NUMBER)(PhysicalAddress.QuadPart >> MM_PAGE_SHIFT);
+        PointerPte->Hardware.LargePage = 1;
+        PointerPte->Hardware.Valid = 1;
+        PointerPte->Hardware.Writable = 1;
+        *MappedSize = MM_LARGE_PAGE_SIZE;
+        return STATUS_SUCCESS;
+    }
+
+    /* Make sure PML2 entry is present */
+    if(!PointerPte->Hardware.Valid)
+    {
+        /* Allocate new page table */
+        Status = MmpAllocatePageTable(PointerPte);
+        if(Status != STATUS_SUCCESS)
+        {
+            /* Failed to allocate page table, return error */
+            return Status;
+        }
+    }
+
+    /* Map 4KB page */
+    PointerPte = MmpGetPteAddress(VirtualAddress);
+    PointerPte->Long = 0;
+    PointerPte->Hardware.PageFrameNumber = (PFN_NUMBER)(PhysicalAddress.QuadPart >> MM_PAGE_SHIFT);
+    PointerPte->Hardware.Valid = 1;
+    PointerPte->Hardware.Writable = 1;
+    *MappedSize = MM_PAGE_SIZE;
+    return STATUS_SUCCESS;
+}
+
+/**
+ * Makes sure that all paging structures needed to map the given virtual address range are present.
+ *
+ * @param VirtualAddress
+ *        Supplies the base virtual address of the range.
+ *
+ * @param PageCount
+ *        Supplies the number of pages in the range.
+ *
+ * @return This routine returns a status code.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+XTSTATUS
+MmpMapPageTables(IN PVOID VirtualAddress,
+                 IN PFN_NUMBER PageCount)
+{
+    ULONG_PTR Address, LastAddress;
+    PMMPTE PointerPte;
+    XTSTATUS Status;
+
+    /* Calculate the first and the last address of the range */
+    Address = (ULONG_PTR)PAGE_ALIGN(VirtualAddress);
+    LastAddress = Address + (PageCount << MM_PAGE_SHIFT) - 1;
+
+    /* Iterate through all page directory entries covering the range */
+    while(TRUE)
+    {
+        /* Make sure PML4 entry is present */
+        PointerPte = MmpGetPxeAddress((PVOID)Address);
+        if(!PointerPte->Hardware.Valid)
+        {
+            /* Allocate new page directory pointer table */
+            Status = MmpAllocatePageTable(PointerPte);
+            if(Status != STATUS_SUCCESS)
+            {
+                /* Failed to allocate page table, return error */
+                return Status;
+            }
+        }
+
+        /* Make sure PML3 entry is present */
+        PointerPte = MmpGetPpeAddress((PVOID)Address);
+        if(!PointerPte->Hardware.Valid)
+        {
+            /* Allocate new page directory */
+            Status = MmpAllocatePageTable(PointerPte);
+            if(Status != STATUS_SUCCESS)
+            {
+                /* Failed to allocate page table, return error */
+                return Status;
+            }
+        }
+
+        /* Make sure PML2 entry is present */
+        PointerPte = MmpGetPdeAddress((PVOID)Address);
+        if(!PointerPte->Hardware.Valid)
+        {
+            /* Allocate new page table */
+            Status = MmpAllocatePageTable(PointerPte);
+            if(Status != STATUS_SUCCESS)
+            {
+                /* Failed to allocate page table, return error */
+                return Status;
+            }
+        }
+
+        /* Advance to the next page directory entry */
+        Address = ROUND_DOWN(Address, ((ULONG_PTR)1 << MM_PDI_SHIFT)) + ((ULONG_PTR)1 << MM_PDI_SHIFT);
+
+        /* Check if the whole range has been covered or the address wrapped around */
+        if(Address == 0 || Address > LastAddress)
+        {
+            /* All paging structures are present */
+            break;
+        }
+    }
+
+    /* Return success */
+    return STATUS_SUCCESS;
+}
@@ -0,0 +1,635 @@
+/**
+ * PROJECT:         ExectOS
+ * COPYRIGHT:       See COPYING.md in the top level directory
+ * FILE:            xtoskrnl/mm/buddy.c
+ * DESCRIPTION:     Binary buddy allocator for physically contiguous memory
+ * DEVELOPERS:      Rafal Kupiec <belliash@codingworkshop.eu.org>
+ */
+
+#include <xtos.h>
+
+
+/**
+ * Allocates a range of physically contiguous memory.
+ *
+ * @param PageCount
+ *        Supplies the number of pages to be allocated.
+ *
+ * @param Alignment
+ *        Supplies the required alignment of the physical address in bytes. It has to be a power of two. Any value
+ *        lower than the page size results in page alignment.
+ *
+ * @param HighestAddress
+ *        Supplies the highest physical address, the allocated memory can reside at.
+ *
+ * @param PhysicalAddress
+ *        Supplies a pointer to the variable that receives the physical address of the allocated memory.
+ *
+ * @return This routine returns a status code.
+ *
+ * @note If no block is available, pages cached in the page magazine of the current processor are returned to the
+ *       buddy allocator before retrying. Page magazines of other processors are accessed by their owners without
+ *       any lock, so they cannot be drained from here. They hold at most MM_PAGE_MAGAZINE_SIZE pages each.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+XTSTATUS
+MmAllocateContiguousMemory(IN PFN_NUMBER PageCount,
+                           IN ULONG_PTR Alignment,
+                           IN PHYSICAL_ADDRESS HighestAddress,
+                           OUT PPHYSICAL_ADDRESS PhysicalAddress)
+{
+    PFN_NUMBER AlignmentPages, BlockPages, HighestPage, Page, PageFrameNumber;
+    PKPROCESSOR_CONTROL_BLOCK Prcb;
+    KRUNLEVEL OldRunLevel;
+    ULONG Order;
+    XTSTATUS Status;
+
+    /* Assume failure */
+    PhysicalAddress->QuadPart = 0;
+
+    /* Calculate alignment in pages */
+    AlignmentPages = Alignment >> MM_PAGE_SHIFT;
+    if(AlignmentPages == 0)
+    {
+        /* Use page alignment */
+        AlignmentPages = 1;
+    }
+
+    /* Validate parameters */
+    if(PageCount == 0 || (AlignmentPages & (AlignmentPages - 1)))
+    {
+        /* Invalid page count or alignment is not a power of two, return error */
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    /* Buddy blocks are naturally aligned, so the block has to be at least as big as the requested alignment */
+    BlockPages = (PageCount > AlignmentPages) ? PageCount : AlignmentPages;
+
+    /* Find the smallest order covering the block */
+    Order = 0;
+    while(((PFN_NUMBER)1 << Order) < BlockPages)
+    {
+        /* Try next order */
+        Order++;
+    }
+
+    /* Make sure the requested block is not too big */
+    if(Order > MM_MAXIMUM_BUDDY_ORDER)
+    {
+        /* Requested block exceeds the maximum block size, return error */
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    /* Raise runlevel and acquire PFN database lock */
+    OldRunLevel = KeRaiseRunLevel(DISPATCH_LEVEL);
+    KeAcquireSpinLock(&MmpPfnLock);
+
+    /* Get current processor control block and the highest allowed page */
+    Prcb = KeGetCurrentProcessorControlBlock();
+    HighestPage = (PFN_NUMBER)(HighestAddress.QuadPart >> MM_PAGE_SHIFT);
+
+    /* Allocate block from the buddy allocator, preferring nodes closest to the current processor */
+    Status = MmpAllocateBuddyBlockNearNode(Prcb->NodeNumber, Order, HighestPage, &PageFrameNumber);
+    if(Status != STATUS_SUCCESS)
+    {
+        /* Pages cached on this processor and on the colored lists might prevent coalescing, return them */
+        MmpDrainPageMagazine(&Prcb->PageMagazine, Prcb->PageMagazine.Count);
+        MmpDrainColorLists();
+
+        /* Try again */
+        Status = MmpAllocateBuddyBlockNearNode(Prcb->NodeNumber, Order, HighestPage, &PageFrameNumber);
+    }
+
+    /* Check if block has been allocated */
+    if(Status == STATUS_SUCCESS)
+    {
+        /* Mark requested pages as in use */
+        for(Page = PageFrameNumber; Page < PageFrameNumber + PageCount; Page++)
+        {
+            MmPfnDatabase[Page].u1.Flink = 0;
+            MmPfnDatabase[Page].u2.ShareCount = 1;
+            MmPfnDatabase[Page].u3.e1.PageLocation = ActiveAndValid;
+            MmPfnDatabase[Page].u3.e2.ReferenceCount = 1;
+        }
+
+        /* Give back the unused tail of the block */
+        if(((PFN_NUMBER)1 << Order) > PageCount)
+        {
+            MmpFreeBuddyRange(PageFrameNumber + PageCount, ((PFN_NUMBER)1 << Order) - PageCount);
+        }
+    }
+
+    /* Release PFN database lock and lower runlevel */
+    KeReleaseSpinLock(&MmpPfnLock);
+    KeLowerRunLevel(OldRunLevel);
+
+    /* Check if allocation succeeded */
+    if(Status != STATUS_SUCCESS)
+    {
+        /* Not enough contiguous memory, return error */
+        return Status;
+    }
+
+    /* Return physical address */
+    PhysicalAddress->QuadPart = (ULONGLONG)PageFrameNumber << MM_PAGE_SHIFT;
+    return STATUS_SUCCESS;
+}
+
+/**
+ * Frees a range of physically contiguous memory.
+ *
+ * @param PhysicalAddress
+ *        Supplies the physical address of the memory to be freed.
+ *
+ * @param PageCount
+ *        Supplies the number of pages to be freed.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmFreeContiguousMemory(IN PHYSICAL_ADDRESS PhysicalAddress,
+                       IN PFN_NUMBER PageCount)
+{
+    KRUNLEVEL OldRunLevel;
+
+    /* Raise runlevel and acquire PFN database lock */
+    OldRunLevel = KeRaiseRunLevel(DISPATCH_LEVEL);
+    KeAcquireSpinLock(&MmpPfnLock);
+
+    /* Return pages to the buddy allocator */
+    MmpFreeBuddyRange((PFN_NUMBER)(PhysicalAddress.QuadPart >> MM_PAGE_SHIFT), PageCount);
+
+    /* Release PFN database lock and lower runlevel */
+    KeReleaseSpinLock(&MmpPfnLock);
+    KeLowerRunLevel(OldRunLevel);
+}
+
+/**
+ * Allocates a single block of the given order from the buddy allocator. PFN database lock must be held by the caller.
+ *
+ * @param NodeNumber
+ *        Supplies the node number, the block has to be allocated from.
+ *
+ * @param Order
+ *        Specifies the order of the block to be allocated.
+ *
+ * @param HighestPage
+ *        Supplies the highest page frame number, the block can contain.
+ *
+ * @param PageFrameNumber
+ *        Supplies a pointer to the variable that receives the first page frame number of the allocated block.
+ *
+ * @return This routine returns a status code.
+ *
+ * @note Free blocks are kept in separate lists for memory below and above MM_MAXIMUM_PHYSICAL_ADDRESS, so a block
+ *       gets found in constant time, if the highest page is unlimited or matches the zone boundary. Only a limit
+ *       lying inside of a zone requires walking through its list, which takes time linear in the number of blocks.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+XTSTATUS
+MmpAllocateBuddyBlock(IN ULONG NodeNumber,
+                      IN ULONG Order,
+                      IN PFN_NUMBER HighestPage,
+                      OUT PPFN_NUMBER PageFrameNumber)
+{
+    PFN_NUMBER Block;
+    ULONG Area;
+    LONG Zone;
+
+    /* Look for the smallest free block, that is big enough */
+    Block = MM_PFN_LIST_END;
+    for(Area = Order; Area <= MM_MAXIMUM_BUDDY_ORDER; Area++)
+    {
+        /* Prefer the high zone if allowed, leaving low memory for callers that cannot use anything else */
+        for(Zone = (HighestPage > (MM_MAXIMUM_PHYSICAL_ADDRESS >> MM_PAGE_SHIFT)) ? MmBuddyHighZone : MmBuddyLowZone;
+            Zone >= MmBuddyLowZone && Block == MM_PFN_LIST_END;
+            Zone--)
+        {
+            /* Walk through the blocks of this order in the zone */
+            Block = MmpBuddyFreeArea[NodeNumber][Area].ListHead[Zone];
+            while(Block != MM_PFN_LIST_END)
+            {
+                /* Check if the requested pages, taken from the beginning of the block, fit below the highest page */
+                if(Block + ((PFN_NUMBER)1 << Order) - 1 <= HighestPage)
+                {
+                    /* Suitable block found */
+                    break;
+                }
+
+                /* Go to the next block */
+                Block = MmPfnDatabase[Block].u1.Flink;
+            }
+        }
+
+        /* Check if block has been found */
+        if(Block != MM_PFN_LIST_END)
+        {
+            /* Stop searching */
+            break;
+        }
+    }
+
+    /* Make sure a block has been found */
+    if(Area > MM_MAXIMUM_BUDDY_ORDER)
+    {
+        /* No suitable block available, return error */
+        *PageFrameNumber = 0;
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    /* Take the block off its free list */
+    MmpRemoveBuddyBlock(Block, Area);
+
+    /* Split the block until it matches the requested order, giving back the upper halves */
+    while(Area > Order)
+    {
+        Area--;
+        MmpInsertBuddyBlock(Block + ((PFN_NUMBER)1 << Area), Area);
+    }
+
+    /* Return first page frame number of the block */
+    *PageFrameNumber = Block;
+    return STATUS_SUCCESS;
+}
+
+/**
+ * Allocates a single block of the given order from the buddy allocator, trying the given node first and then all
+ * other nodes ordered by their distance. PFN database lock must be held by the caller.
+ *
+ * @param NodeNumber
+ *        Supplies the preferred node number.
+ *
+ * @param Order
+ *        Specifies the order of the block to be allocated.
+ *
+ * @param HighestPage
+ *        Supplies the highest page frame number, the block can contain.
+ *
+ * @param PageFrameNumber
+ *        Supplies a pointer to the variable that receives the first page frame number of the allocated block.
+ *
+ * @return This routine returns a status code.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+XTSTATUS
+MmpAllocateBuddyBlockNearNode(IN ULONG NodeNumber,
+                              IN ULONG Order,
+                              IN PFN_NUMBER HighestPage,
+                              OUT PPFN_NUMBER PageFrameNumber)
+{
+    XTSTATUS Status;
+    ULONG Index;
+
+    /* Try all nodes, nearest first */
+    for(Index = 0; Index < MmpNodeCount; Index++)
+    {
+        /* Allocate block from this node */
+        Status = MmpAllocateBuddyBlock(MmpNodeFallbackOrder[NodeNumber][Index], Order, HighestPage, PageFrameNumber);
+        if(Status == STATUS_SUCCESS)
+        {
+            /* Block allocated */
+            return STATUS_SUCCESS;
+        }
+    }
+
+    /* No suitable block available on any node */
+    *PageFrameNumber = 0;
+    return STATUS_INSUFFICIENT_RESOURCES;
+}
+
+/**
+ * Returns all pages cached on the colored lists to the buddy allocator, so they can be coalesced into bigger
+ * blocks. PFN database lock must be held by the caller.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmpDrainColorLists(VOID)
+{
+    PFN_NUMBER PageFrameNumber;
+    ULONG Color, List;
+
+    /* Iterate through all colored lists */
+    for(List = ZeroedPageList; List <= StandbyPageList; List++)
+    {
+        for(Color = 0; Color < MM_DEFAULT_SECONDARY_COLORS; Color++)
+        {
+            /* Move all pages from this list to the buddy allocator */
+            while(MmpFreePagesByColor[List][Color].Flink != MM_PFN_LIST_END)
+            {
+                PageFrameNumber = MmpFreePagesByColor[List][Color].Flink;
+                MmpRemovePageFromColorList(PageFrameNumber);
+                MmpFreeBuddyRange(PageFrameNumber, 1);
+            }
+        }
+    }
+}
+
+/**
+ * Frees a single naturally aligned block to the buddy allocator, coalescing it with its free buddies. PFN database
+ * lock must be held by the caller.
+ *
+ * @param PageFrameNumber
+ *        Supplies the first page frame number of the block.
+ *
+ * @param Order
+ *        Specifies the order of the block.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmpFreeBuddyBlock(IN PFN_NUMBER PageFrameNumber,
+                  IN ULONG Order)
+{
+    PFN_NUMBER Buddy;
+
+    /* Coalesce with free buddies as long as possible */
+    while(Order < MM_MAXIMUM_BUDDY_ORDER)
+    {
+        /* Check if buddy block is free and belongs to the same node */
+        Buddy = PageFrameNumber ^ ((PFN_NUMBER)1 << Order);
+        if(!RtlTestBit(&MmpBuddyBitmap[Order], Buddy >> Order) ||
+           MmPfnDatabase[Buddy].u4.NodeNumber != MmPfnDatabase[PageFrameNumber].u4.NodeNumber)
+        {
+            /* Buddy is in use or resides on another node, stop coalescing */
+            break;
+        }
+
+        /* Merge both blocks into a bigger one */
+        MmpRemoveBuddyBlock(Buddy, Order);
+        PageFrameNumber &= ~((PFN_NUMBER)1 << Order);
+        Order++;
+    }
+
+    /* Insert the resulting block into the free area */
+    MmpInsertBuddyBlock(PageFrameNumber, Order);
+}
+
+/**
+ * Frees an arbitrary range of pages to the buddy allocator. PFN database lock must be held by the caller.
+ *
+ * @param PageFrameNumber
+ *        Supplies the first page frame number of the range.
+ *
+ * @param PageCount
+ *        Supplies the number of pages in the range.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmpFreeBuddyRange(IN PFN_NUMBER PageFrameNumber,
+                  IN PFN_NUMBER PageCount)
+{
+    PFN_NUMBER Page;
+    ULONG Order;
+
+    /* Mark all pages as free */
+    for(Page = PageFrameNumber; Page < PageFrameNumber + PageCount; Page++)
+    {
+        MmPfnDatabase[Page].u3.e1.PageLocation = FreePageList;
+        MmPfnDatabase[Page].u3.e2.ReferenceCount = 0;
+        MmPfnDatabase[Page].PteAddress = NULL;
+    }
+
+    /* Split the range into naturally aligned blocks */
+    while(PageCount)
+    {
+        /* Find the biggest block, that starts at this page, fits in the range and does not span multiple nodes */
+        Order = 0;
+        while(Order < MM_MAXIMUM_BUDDY_ORDER && !(PageFrameNumber & ((PFN_NUMBER)1 << Order)) &&
+              ((PFN_NUMBER)2 << Order) <= PageCount &&
+              MmPfnDatabase[PageFrameNumber + ((PFN_NUMBER)2 << Order) - 1].u4.NodeNumber ==
+              MmPfnDatabase[PageFrameNumber].u4.NodeNumber)
+        {
+            /* Try next order */
+            Order++;
+        }
+
+        /* Free the block */
+        MmpFreeBuddyBlock(PageFrameNumber, Order);
+
+        /* Advance to the next block */
+        PageFrameNumber += (PFN_NUMBER)1 << Order;
+        PageCount -= (PFN_NUMBER)1 << Order;
+    }
+}
+
+/**
+ * Gets the zone of the buddy allocator, the block starting at the given page belongs to. Zone boundary is aligned
+ * to the biggest block size, thus a block never spans both zones.
+ *
+ * @param PageFrameNumber
+ *        Supplies the first page frame number of the block.
+ *
+ * @return This routine returns the zone of the block.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+MMBUDDY_ZONE
+MmpGetBuddyZone(IN PFN_NUMBER PageFrameNumber)
+{
+    /* Blocks below the maximum physical address belong to the low zone */
+    return (PageFrameNumber > (MM_MAXIMUM_PHYSICAL_ADDRESS >> MM_PAGE_SHIFT)) ? MmBuddyHighZone : MmBuddyLowZone;
+}
+
+/**
+ * Initializes the buddy allocator free areas. Bitmaps tracking free blocks are placed right after the PFN database.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmpInitializeBuddyAllocator(VOID)
+{
+    ULONG_PTR BitmapAddress, BitmapSize;
+    ULONG BlockCount, Node, Order;
+
+    /* Bitmaps start right after the PFN database */
+    BitmapAddress = ROUND_UP((ULONG_PTR)&MmPfnDatabase[MmHighestPhysicalPage + 1], MM_PAGE_SIZE);
+    BitmapSize = 0;
+
+    /* Calculate the size of all bitmaps */
+    for(Order = 0; Order <= MM_MAXIMUM_BUDDY_ORDER; Order++)
+    {
+        BlockCount = (ULONG)(MmHighestPhysicalPage >> Order) + 1;
+        BitmapSize += ROUND_UP(BlockCount, BITS_PER_LONG) / BITS_PER_BYTE;
+    }
+
+    /* Map memory for the bitmaps */
+    MmpMapBootstrapMemory((PVOID)BitmapAddress, SIZE_TO_PAGES(BitmapSize));
+
+    /* Initialize bitmaps, shared by all nodes */
+    for(Order = 0; Order <= MM_MAXIMUM_BUDDY_ORDER; Order++)
+    {
+        /* Initialize bitmap, memory is already zeroed */
+        BlockCount = (ULONG)(MmHighestPhysicalPage >> Order) + 1;
+        RtlInitializeBitMap(&MmpBuddyBitmap[Order], (PULONG_PTR)BitmapAddress, BlockCount);
+        BitmapAddress += ROUND_UP(BlockCount, BITS_PER_LONG) / BITS_PER_BYTE;
+    }
+
+    /* Initialize free areas of all nodes */
+    for(Node = 0; Node < MM_MAXIMUM_NUMA_NODES; Node++)
+    {
+        for(Order = 0; Order <= MM_MAXIMUM_BUDDY_ORDER; Order++)
+        {
+            /* Initialize the list of free blocks */
+            MmpBuddyFreeArea[Node][Order].ListHead[MmBuddyLowZone] = MM_PFN_LIST_END;
+            MmpBuddyFreeArea[Node][Order].ListHead[MmBuddyHighZone] = MM_PFN_LIST_END;
+            MmpBuddyFreeArea[Node][Order].BlockCount = 0;
+        }
+    }
+}
+
+/**
+ * Inserts a free block into the free area of the given order. PFN database lock must be held by the caller.
+ *
+ * @param PageFrameNumber
+ *        Supplies the first page frame number of the block.
+ *
+ * @param Order
+ *        Specifies the order of the block.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmpInsertBuddyBlock(IN PFN_NUMBER PageFrameNumber,
+                    IN ULONG Order)
+{
+    PMMBUDDY_FREE_AREA FreeArea;
+    MMBUDDY_ZONE Zone;
+
+    /* Get free area of the node the block belongs to and zone of the block */
+    FreeArea = &MmpBuddyFreeArea[MmPfnDatabase[PageFrameNumber].u4.NodeNumber][Order];
+    Zone = MmpGetBuddyZone(PageFrameNumber);
+
+    /* Insert the block at the head of the list */
+    MmPfnDatabase[PageFrameNumber].u1.Flink = FreeArea->ListHead[Zone];
+    MmPfnDatabase[PageFrameNumber].u2.Blink = MM_PFN_LIST_END;
+    if(FreeArea->ListHead[Zone] != MM_PFN_LIST_END)
+    {
+        /* Link the old head back to the new block */
+        MmPfnDatabase[FreeArea->ListHead[Zone]].u2.Blink = PageFrameNumber;
+    }
+    FreeArea->ListHead[Zone] = PageFrameNumber;
+
+    /* Mark the block as free and update counters */
+    RtlSetBit(&MmpBuddyBitmap[Order], PageFrameNumber >> Order);
+    FreeArea->BlockCount++;
+    MmAvailablePages += (PFN_NUMBER)1 << Order;
+}
+
+/**
+ * Removes a free block from the free area of the given order. PFN database lock must be held by the caller.
+ *
+ * @param PageFrameNumber
+ *        Supplies the first page frame number of the block.
+ *
+ * @param Order
+ *        Specifies the order of the block.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmpRemoveBuddyBlock(IN PFN_NUMBER PageFrameNumber,
+                    IN ULONG Order)
+{
+    PMMBUDDY_FREE_AREA FreeArea;
+    PFN_NUMBER Flink, Blink;
+
+    /* Get free area of the node the block belongs to and block links */
+    FreeArea = &MmpBuddyFreeArea[MmPfnDatabase[PageFrameNumber].u4.NodeNumber][Order];
+    Flink = MmPfnDatabase[PageFrameNumber].u1.Flink;
+    Blink = MmPfnDatabase[PageFrameNumber].u2.Blink;
+
+    /* Unlink the block */
+    if(Blink == MM_PFN_LIST_END)
+    {
+        /* Block was the list head */
+        FreeArea->ListHead[MmpGetBuddyZone(PageFrameNumber)] = Flink;
+    }
+    else
+    {
+        /* Link previous block with the next one */
+        MmPfnDatabase[Blink].u1.Flink = Flink;
+    }
+
+    /* Check if there is a next block */
+    if(Flink != MM_PFN_LIST_END)
+    {
+        /* Link next block with the previous one */
+        MmPfnDatabase[Flink].u2.Blink = Blink;
+    }
+
+    /* Mark the block as used and update counters */
+    RtlClearBit(&MmpBuddyBitmap[Order], PageFrameNumber >> Order);
+    FreeArea->BlockCount--;
+    MmAvailablePages -= (PFN_NUMBER)1 << Order;
+}
+
+/**
+ * Refills the colored free lists with a batch of pages from the buddy allocator. A batch is a contiguous block, so
+ * it contains pages of consecutive colors. PFN database lock must be held by the caller.
+ *
+ * @param NodeNumber
+ *        Supplies the node number, the pages have to be taken from.
+ *
+ * @return This routine returns a status code.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+XTSTATUS
+MmpRefillColorLists(IN ULONG NodeNumber)
+{
+    PFN_NUMBER Page, PageFrameNumber;
+    XTSTATUS Status;
+    LONG Order;
+
+    /* Try to get a full batch first, then fall back to smaller blocks */
+    for(Order = MM_REFILL_BUDDY_ORDER; Order >= 0; Order--)
+    {
+        /* Allocate block from the buddy allocator */
+        Status = MmpAllocateBuddyBlock(NodeNumber, Order, MAXULONG_PTR, &PageFrameNumber);
+        if(Status == STATUS_SUCCESS)
+        {
+            /* Move all pages of the block to the colored free lists */
+            for(Page = PageFrameNumber; Page < PageFrameNumber + ((PFN_NUMBER)1 << Order); Page++)
+            {
+                MmpInsertPageInColorList(Page, FreePageList);
+            }
+
+            /* Return success */
+            return STATUS_SUCCESS;
+        }
+    }
+
+    /* Buddy allocator has no free memory on this node */
+    return STATUS_INSUFFICIENT_RESOURCES;
+}
@@ -0,0 +1,142 @@
+/**
+ * PROJECT:         ExectOS
+ * COPYRIGHT:       See COPYING.md in the top level directory
+ * FILE:            xtoskrnl/mm/fault.c
+ * DESCRIPTION:     Page fault handling
+ * DEVELOPERS:      Rafal Kupiec <belliash@codingworkshop.eu.org>
+ */
+
+#include <xtos.h>
+
+
+/**
+ * Resolves a page fault caused by an access to reserved, but not yet committed kernel memory. The faulting page
+ * gets backed by a zeroed physical page of the current processor's node, and so do the other reserved pages within
+ * the aligned fault-around window, saving subsequent faults on sequential access.
+ *
+ * @param FaultCode
+ *        Supplies the page fault error code pushed by the processor.
+ *
+ * @param VirtualAddress
+ *        Supplies the faulting virtual address.
+ *
+ * @return This routine returns a status code. STATUS_SUCCESS means the faulting instruction can be restarted.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+XTSTATUS
+MmAccessFault(IN ULONG_PTR FaultCode,
+              IN PVOID VirtualAddress)
+{
+    PMMPTE PointerPte, WindowPte;
+    PFN_NUMBER PageFrameNumber;
+    KRUNLEVEL OldRunLevel;
+    ULONGLONG StartTime;
+    ULONG_PTR PageSize;
+    MMPTE DemandZeroPte;
+    ULONG NodeNumber;
+    XTSTATUS Status;
+    ULONG Page;
+
+    /* Store the time when the fault handling begins */
+    StartTime = ArReadTimeStampCounter();
+
+    /* Only kernel mode data accesses to not present pages in the system pages pool can be resolved */
+    if((FaultCode & (X86_PF_PRESENT_MASK | X86_PF_USER_MASK | X86_PF_RESERVED_MASK | X86_PF_INSTRUCTION_MASK)) ||
+       ((ULONG_PTR)VirtualAddress < MM_SYSTEM_VA_START) ||
+       ((ULONG_PTR)VirtualAddress >= MM_SYSTEM_VA_START + MM_SYSTEM_VA_SIZE))
+    {
+        /* Not a demand-zero fault, return error */
+        return STATUS_ACCESS_VIOLATION;
+    }
+
+    /* Page faults cannot be resolved above DISPATCH level */
+    if(KeGetCurrentRunLevel() > DISPATCH_LEVEL)
+    {
+        /* Fault raised by an interrupt service routine, return error */
+        return STATUS_ACCESS_VIOLATION;
+    }
+
+    /* Prepare the software PTE describing reserved memory */
+    DemandZeroPte.Long = 0;
+    DemandZeroPte.Software.Protection = MM_DEMAND_ZERO_PROTECTION;
+
+    /* Raise runlevel and acquire page fault lock */
+    OldRunLevel = KeRaiseRunLevel(DISPATCH_LEVEL);
+    KeAcquireSpinLock(&MmpPageFaultLock);
+
+    /* Check if the page got mapped by another processor in the meantime */
+    if(MmpGetMappingEntry(VirtualAddress, &PageSize))
+    {
+        /* Fault already resolved, release lock, lower runlevel and return success */
+        KeReleaseSpinLock(&MmpPageFaultLock);
+        KeLowerRunLevel(OldRunLevel);
+        return STATUS_SUCCESS;
+    }
+
+    /* Make sure the page table is present and the PTE describes reserved memory */
+    PointerPte = MmpGetPteAddress(VirtualAddress);
+    if(PageSize != MM_PAGE_SIZE || PointerPte->Long != DemandZeroPte.Long)
+    {
+        /* Access to memory that has never been reserved, release lock, lower runlevel and return error */
+        MmpPageFaultStatistics.FailedFaults++;
+        KeReleaseSpinLock(&MmpPageFaultLock);
+        KeLowerRunLevel(OldRunLevel);
+        return STATUS_ACCESS_VIOLATION;
+    }
+
+    /* Back the faulting page with a zeroed page local to the current processor */
+    NodeNumber = KeGetCurrentProcessorControlBlock()->NodeNumber;
+    Status = MmAllocatePhysicalPageOnNode(NodeNumber, TRUE, &PageFrameNumber);
+    if(Status != STATUS_SUCCESS)
+    {
+        /* Out of physical memory, release lock, lower runlevel and return error */
+        MmpPageFaultStatistics.FailedFaults++;
+        KeReleaseSpinLock(&MmpPageFaultLock);
+        KeLowerRunLevel(OldRunLevel);
+        return Status;
+    }
+
+    /* Fill the PTE, not present entries are never cached in TLB so no flush is needed */
+    PointerPte->Long = 0;
+    PointerPte->Hardware.PageFrameNumber = PageFrameNumber;
+    PointerPte->Hardware.Valid = 1;
+    PointerPte->Hardware.Writable = 1;
+    MmpPageFaultStatistics.DemandZeroFaults++;
+
+    /* Commit the remaining reserved pages in the fault-around window, that never crosses a page table */
+    WindowPte = MmpGetPteAddress((PVOID)ROUND_DOWN((ULONG_PTR)VirtualAddress, MM_FAULT_AROUND_PAGES * MM_PAGE_SIZE));
+    for(Page = 0; Page < MM_FAULT_AROUND_PAGES; Page++)
+    {
+        /* Skip pages that are either committed or not reserved at all */
+        if(WindowPte[Page].Long != DemandZeroPte.Long)
+        {
+            continue;
+        }
+
+        /* Allocate a zeroed page for the neighbour */
+        if(MmAllocatePhysicalPageOnNode(NodeNumber, TRUE, &PageFrameNumber) != STATUS_SUCCESS)
+        {
+            /* Memory is short, leave the remaining pages to be faulted in on demand */
+            break;
+        }
+
+        /* Fill the PTE, leaving the accessed bit clear so unused pages can be accounted when freed */
+        WindowPte[Page].Long = 0;
+        WindowPte[Page].Hardware.PageFrameNumber = PageFrameNumber;
+        WindowPte[Page].Hardware.Valid = 1;
+        WindowPte[Page].Hardware.Writable = 1;
+        MmpPageFaultStatistics.FaultAroundPages++;
+    }
+
+    /* Account the time spent on resolving the fault */
+    MmpPageFaultStatistics.FaultCycles += (ULONG_PTR)(ArReadTimeStampCounter() - StartTime);
+
+    /* Release page fault lock and lower runlevel */
+    KeReleaseSpinLock(&MmpPageFaultLock);
+    KeLowerRunLevel(OldRunLevel);
+
+    /* Return success */
+    return STATUS_SUCCESS;
+}
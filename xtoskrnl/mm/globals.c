@@ -9,8 +9,11 @@
 #include <xtos.h>
 
 
+/* Number of pages available on the zeroed, free and standby lists */
+PFN_NUMBER MmAvailablePages;
+
 /* Biggest free memory descriptor */
-PLOADER_MEMORY_DESCRIPTOR MmFreeDescriptor;
+PMMMEMORY_DESCRIPTOR MmFreeDescriptor;
 
 /* Highest physical page number */
 ULONG_PTR MmHighestPhysicalPage;
@@ -22,22 +25,145 @@ ULONG_PTR MmLowestPhysicalPage = -1;
 ULONG MmNumberOfPhysicalPages;
 
 /* Old biggest free memory descriptor */
-LOADER_MEMORY_DESCRIPTOR MmOldFreeDescriptor;
+MMMEMORY_DESCRIPTOR MmOldFreeDescriptor;
 
 /* Page Map Level */
 ULONG MmPageMapLevel;
 
-/* Processor structures data (THIS IS A TEMPORARY HACK) */
-UCHAR MmProcessorStructuresData[MAXIMUM_PROCESSORS][KPROCESSOR_STRUCTURES_SIZE] = {0};
+/* PFN database */
+PMMPFN MmPfnDatabase = (PMMPFN)MM_PFN_DATABASE_ADDRESS;
+
+/* Buddy allocator bitmaps of free blocks, shared by all NUMA nodes */
+RTL_BITMAP MmpBuddyBitmap[MM_MAXIMUM_BUDDY_ORDER + 1];
+
+/* Buddy allocator free areas, one per NUMA node and block order */
+MMBUDDY_FREE_AREA MmpBuddyFreeArea[MM_MAXIMUM_NUMA_NODES][MM_MAXIMUM_BUDDY_ORDER + 1];
+
+/* Zeroed, free and standby page lists split by page color */
+MMCOLOR_TABLES MmpFreePagesByColor[StandbyPageList + 1][MM_DEFAULT_SECONDARY_COLORS];
+
+/* Hardware layer large page pool slots bitmap */
+RTL_BITMAP MmpHardwareLargeBitmap;
+
+/* Hardware layer large page pool slots bitmap buffer */
+ULONG_PTR MmpHardwareLargeBitmapBuffer[ROUND_UP(MM_HARDWARE_LARGE_VA_SIZE >> MM_LARGE_PAGE_SHIFT, BITS_PER_LONG) / BITS_PER_LONG];
+
+/* Number of pages of each size used to map hardware memory */
+MMHARDWARE_MAPPING_STATISTICS MmpHardwareMappingStatistics;
+
+/* Hardware layer memory pool pages bitmap */
+RTL_BITMAP MmpHardwareVaBitmap;
+
+/* Hardware layer memory pool pages bitmap buffer */
+ULONG_PTR MmpHardwareVaBitmapBuffer[ROUND_UP(MM_HARDWARE_VA_SIZE >> MM_PAGE_SHIFT, BITS_PER_LONG) / BITS_PER_LONG];
+
+/* Next-fit hint, the page in hardware layer memory pool where the next search starts */
+ULONG_PTR MmpHardwareVaHint;
+
+/* Hardware layer memory pool lock */
+KSPIN_LOCK MmpHardwareVaLock;
 
-/* Allocation descriptors dedicated for hardware layer */
-LOADER_MEMORY_DESCRIPTOR MmpHardwareAllocationDescriptors[MM_HARDWARE_ALLOCATION_DESCRIPTORS];
+/* Kernel stacks pool bitmap */
+RTL_BITMAP MmpKernelStackVaBitmap;
 
-/* Live address of kernel's hardware heap */
-PVOID MmpHardwareHeapStart = MM_HARDWARE_HEAP_START_ADDRESS;
+/* Kernel stacks pool bitmap buffer */
+ULONG_PTR MmpKernelStackVaBitmapBuffer[ROUND_UP(MM_KERNEL_STACK_VA_SIZE >> MM_PAGE_SHIFT, BITS_PER_LONG) / BITS_PER_LONG];
+
+/* Next-fit hint for kernel stacks pool allocations */
+ULONG_PTR MmpKernelStackVaHint;
+
+/* Kernel stacks pool lock */
+KSPIN_LOCK MmpKernelStackVaLock;
+
+/* Largest page size supported by the processor */
+ULONG_PTR MmpLargestPageSize = MM_LARGE_PAGE_SIZE;
+
+/* Number of physical memory descriptors */
+ULONG MmpMemoryDescriptorCount;
+
+/* Physical memory descriptors, sorted by base page and coalesced */
+MMMEMORY_DESCRIPTOR MmpMemoryDescriptors[MM_MAXIMUM_MEMORY_DESCRIPTORS];
 
 /* Architecture-specific memory extension */
 BOOLEAN MmpMemoryExtension;
 
-/* Number of used hardware allocation descriptors */
-ULONG MmpUsedHardwareAllocationDescriptors = 0;
+/* Next Process Context Identifier to be assigned */
+ULONG MmpNextPcid = 1;
+
+/* Number of NUMA nodes */
+ULONG MmpNodeCount = 1;
+
+/* Distances between NUMA nodes */
+UCHAR MmpNodeDistance[MM_MAXIMUM_NUMA_NODES][MM_MAXIMUM_NUMA_NODES];
+
+/* NUMA nodes ordered by their distance from each node */
+UCHAR MmpNodeFallbackOrder[MM_MAXIMUM_NUMA_NODES][MM_MAXIMUM_NUMA_NODES];
+
+/* ACPI proximity domains of NUMA nodes */
+ULONG MmpNodeProximityDomain[MM_MAXIMUM_NUMA_NODES];
+
+/* Number of NUMA memory ranges */
+ULONG MmpNumaMemoryRangeCount = 0;
+
+/* Physical memory ranges of NUMA nodes */
+MMNUMA_MEMORY_RANGE MmpNumaMemoryRanges[MM_MAXIMUM_NUMA_RANGES];
+
+/* Demand-zero page faults lock */
+KSPIN_LOCK MmpPageFaultLock;
+
+/* Demand-zero page faults statistics */
+MMPAGE_FAULT_STATISTICS MmpPageFaultStatistics;
+
+/* Instruction set used to zero pages in the background */
+MMPAGE_ZEROING_METHOD MmpPageZeroingMethod = PageZeroingStandard;
+
+/* Number of pages on the zeroed, free and standby lists */
+PFN_NUMBER MmpPageListCount[StandbyPageList + 1];
+
+/* Indicates whether Process Context Identifiers are in use */
+BOOLEAN MmpPcidEnabled;
+
+/* Current Process Context Identifiers generation, bumped each time all identifiers get recycled */
+ULONGLONG MmpPcidGeneration = 1;
+
+/* Process Context Identifiers allocation lock */
+KSPIN_LOCK MmpPcidLock;
+
+/* PFN database initialization flag */
+BOOLEAN MmpPfnDatabaseInitialized = FALSE;
+
+/* PFN database lock */
+KSPIN_LOCK MmpPfnLock;
+
+/* Mask of page colors within a single NUMA node */
+ULONG MmpSecondaryColorMask = MM_DEFAULT_SECONDARY_COLORS - 1;
+
+/* Position of NUMA node number in page color */
+ULONG MmpSecondaryColorNodeShift = 6;
+
+/* Number of zeroed page requests, that had to be zeroed synchronously */
+ULONG_PTR MmpSynchronousZeroCount = 0;
+
+/* System pages pool bitmap */
+RTL_BITMAP MmpSystemVaBitmap;
+
+/* System pages pool bitmap buffer */
+ULONG_PTR MmpSystemVaBitmapBuffer[ROUND_UP(MM_SYSTEM_VA_SIZE >> MM_PAGE_SHIFT, BITS_PER_LONG) / BITS_PER_LONG];
+
+/* Next-fit hint for system pages pool allocations */
+ULONG_PTR MmpSystemVaHint;
+
+/* System pages pool lock */
+KSPIN_LOCK MmpSystemVaLock;
+
+/* Batch of TLB entries being invalidated by the TLB shootdown in progress */
+PMMTLB_FLUSH_BATCH MmpTlbShootdownBatch;
+
+/* TLB shootdown lock */
+KSPIN_LOCK MmpTlbShootdownLock;
+
+/* Processors, that have not yet acknowledged the TLB shootdown in progress */
+VOLATILE KAFFINITY MmpTlbShootdownTargets;
+
+/* Request to zero free pages in the idle loop */
+VOLATILE LONG MmpZeroPageRequest = TRUE;
@@ -31,111 +31,74 @@ MmAllocateHardwareMemory(IN PFN_NUMBER PageCount,
                          IN BOOLEAN Aligned,
                          OUT PPHYSICAL_ADDRESS Buffer)
 {
-    PLOADER_MEMORY_DESCRIPTOR Descriptor, ExtraDescriptor, HardwareDescriptor;
-    PFN_NUMBER Alignment, MaxPage;
-    ULONGLONG PhysicalAddress;
-    PLIST_ENTRY ListEntry;
+    PHYSICAL_ADDRESS HighestAddress;
+    PFN_NUMBER Alignment, BasePage;
+    PMMMEMORY_DESCRIPTOR Descriptor;
+    ULONG Index, LastIndex;
+    XTSTATUS Status;
 
     /* Assume failure */
     (*Buffer).QuadPart = 0;
 
-    /* Calculate maximum page address */
-    MaxPage = MM_MAXIMUM_PHYSICAL_ADDRESS >> MM_PAGE_SHIFT;
+    /* Check if PFN database is already initialized */
+    if(MmpPfnDatabaseInitialized)
+    {
+        /* Memory descriptors are owned by the PFN database now, allocate pages from the buddy allocator */
+        HighestAddress.QuadPart = MM_MAXIMUM_PHYSICAL_ADDRESS - 1;
+        return MmAllocateContiguousMemory(PageCount, Aligned ? 0x10000 : 0, HighestAddress, Buffer);
+    }
 
-    /* Make sure there are at least 2 descriptors available */
-    if((MmpUsedHardwareAllocationDescriptors + 2) > MM_HARDWARE_ALLOCATION_DESCRIPTORS)
+    /* Build memory descriptors array on first use */
+    if(!MmpMemoryDescriptorCount)
     {
-        /* Not enough descriptors, return error */
-        return STATUS_INSUFFICIENT_RESOURCES;
+        MmpInitializeMemoryDescriptors();
     }
 
-    /* Scan memory descriptors provided by the boot loader */
-    ListEntry = KeInitializationBlock->MemoryDescriptorListHead.Flink;
-    while(ListEntry != &KeInitializationBlock->MemoryDescriptorListHead)
+    /* Only descriptors starting below the maximum physical address can satisfy the request */
+    LastIndex = MmpGetMemoryDescriptorIndex((MM_MAXIMUM_PHYSICAL_ADDRESS >> MM_PAGE_SHIFT) - 1);
+
+    /* Scan memory descriptors in ascending physical address order */
+    for(Index = 0; Index < LastIndex; Index++)
     {
-        Descriptor = CONTAIN_RECORD(ListEntry, LOADER_MEMORY_DESCRIPTOR, ListEntry);
+        Descriptor = &MmpMemoryDescriptors[Index];
+
+        /* Ensure that memory type is free for this descriptor and skip the first page of physical memory */
+        if(Descriptor->MemoryType != LoaderFree || !Descriptor->BasePage)
+        {
+            /* Move to next descriptor */
+            continue;
+        }
 
         /* Align memory to 64KB if needed */
         Alignment = Aligned ? (((Descriptor->BasePage + 0x0F) & ~0x0F) - Descriptor->BasePage) : 0;
 
-        /* Ensure that memory type is free for this descriptor */
-        if(Descriptor->MemoryType == LoaderFree)
+        /* Check if descriptor is big enough and if allocated pages end at or below the maximum physical address */
+        if(((Descriptor->BasePage + PageCount + Alignment) <= (MM_MAXIMUM_PHYSICAL_ADDRESS >> MM_PAGE_SHIFT)) &&
+           (Descriptor->PageCount >= (PageCount + Alignment)))
         {
-            /* Check if descriptor is big enough and if it fits under the maximum physical address */
-            if(Descriptor->BasePage &&
-               ((Descriptor->BasePage + PageCount + Alignment) < MaxPage) &&
-               (Descriptor->PageCount >= (PageCount + Alignment)))
-            {
-                /* Set physical address */
-                PhysicalAddress = (Descriptor->BasePage + Alignment) << MM_PAGE_SHIFT;
-                break;
-            }
+            /* Suitable descriptor found */
+            break;
         }
-
-        /* Move to next descriptor */
-        ListEntry = ListEntry->Flink;
     }
 
     /* Make sure we found a descriptor */
-    if(ListEntry == &KeInitializationBlock->MemoryDescriptorListHead)
+    if(Index == LastIndex)
     {
         /* Descriptor not found, return error */
         return STATUS_INSUFFICIENT_RESOURCES;
     }
 
-    /* Allocate new descriptor */
-    HardwareDescriptor = &MmpHardwareAllocationDescriptors[MmpUsedHardwareAllocationDescriptors];
-    HardwareDescriptor->BasePage = Descriptor->BasePage + Alignment;
-    HardwareDescriptor->MemoryType = LoaderHardwareCachedMemory;
-    HardwareDescriptor->PageCount = PageCount;
-
-    /* Update hardware allocation descriptors count */
-    MmpUsedHardwareAllocationDescriptors++;
-
-    /* Check if alignment was done */
-    if(Alignment)
+    /* Mark allocated pages as used by the hardware layer */
+    BasePage = Descriptor->BasePage + Alignment;
+    Status = MmpSetMemoryDescriptorType(BasePage, PageCount, LoaderHardwareCachedMemory);
+    if(Status != STATUS_SUCCESS)
     {
-        /* Check if extra descriptor is needed to describe the allocation */
-        if(Descriptor->PageCount > (PageCount + Alignment))
-        {
-            /* Initialize extra descriptor */
-            ExtraDescriptor = &MmpHardwareAllocationDescriptors[MmpUsedHardwareAllocationDescriptors];
-            ExtraDescriptor->BasePage = Descriptor->BasePage + Alignment + (ULONG)PageCount;
-            ExtraDescriptor->MemoryType = LoaderFree;
-            ExtraDescriptor->PageCount = Descriptor->PageCount - (Alignment + (ULONG)PageCount);
-
-            /* Update hardware allocation descriptors count */
-            MmpUsedHardwareAllocationDescriptors++;
-
-            /* Insert extra descriptor in the list */
-            RtlInsertHeadList(&Descriptor->ListEntry, &ExtraDescriptor->ListEntry);
-        }
-
-        /* Trim source descriptor to the alignment */
-        Descriptor->PageCount = Alignment;
-
-        /* Insert new descriptor in the list */
-        RtlInsertHeadList(&Descriptor->ListEntry, &HardwareDescriptor->ListEntry);
-    }
-    else
-    {
-        /* Consume pages from the source descriptor */
-        Descriptor->BasePage += (ULONG)PageCount;
-        Descriptor->PageCount -= (ULONG)PageCount;
-
-        /* Insert new descriptor in the list */
-        RtlInsertTailList(&Descriptor->ListEntry, &HardwareDescriptor->ListEntry);
-
-        /* Check if source descriptor is fully consumed */
-        if(Descriptor->PageCount == 0)
-        {
-            /* Remove descriptor from the list */
-            RtlRemoveEntryList(&Descriptor->ListEntry);
-        }
+        /* Failed to describe the allocation, return error */
+        return Status;
     }
 
     /* Return physical address */
-    (*Buffer).QuadPart = PhysicalAddress;
+    (*Buffer).QuadPart = (ULONGLONG)BasePage << MM_PAGE_SHIFT;
     return STATUS_SUCCESS;
 }
 
@@ -148,6 +111,9 @@ MmAllocateHardwareMemory(IN PFN_NUMBER PageCount,
  * @param PageCount
  *        Supplies the number of pages to be mapped.
  *
+ * @param CacheType
+ *        Specifies the caching type of the mapping.
+ *
  * @param FlushTlb
  *        Specifies whether to flush the TLB or not.
  *
@@ -162,56 +128,79 @@ XTAPI
 XTSTATUS
 MmMapHardwareMemory(IN PHYSICAL_ADDRESS PhysicalAddress,
                     IN PFN_NUMBER PageCount,
+                    IN MEMORY_CACHING_TYPE CacheType,
                     IN BOOLEAN FlushTlb,
                     OUT PVOID *VirtualAddress)
 {
     PVOID BaseAddress, ReturnAddress;
+    ULONGLONG PhysicalStart;
     PFN_NUMBER MappedPages;
     PHARDWARE_PTE PtePointer;
+    KRUNLEVEL OldRunLevel;
+    ULONG_PTR Index;
 
     /* Initialize variables */
-    BaseAddress = MmpHardwareHeapStart;
-    MappedPages = 0;
-    ReturnAddress = BaseAddress;
     *VirtualAddress = NULL;
 
-    /* Iterate through all pages */
-    while(MappedPages < PageCount)
+    /* Large pages need page tables allocated on demand, so check if memory manager is ready */
+    if(MmpPfnDatabaseInitialized)
     {
-        /* Check if address overflows */
-        if(BaseAddress == NULL)
+        /* Check if the range contains at least one naturally aligned large page */
+        PhysicalStart = PhysicalAddress.QuadPart & ~(ULONGLONG)MM_PAGE_MASK;
+        if(ROUND_UP(PhysicalStart, (ULONGLONG)MM_LARGE_PAGE_SIZE) + MM_LARGE_PAGE_SIZE <=
+           PhysicalStart + ((ULONGLONG)PageCount << MM_PAGE_SHIFT))
         {
-            /* Not enough free pages, return error */
-            return STATUS_INSUFFICIENT_RESOURCES;
+            /* Map memory in the large page pool, falling back to small pages on failure */
+            if(MmpMapLargeHardwareMemory(PhysicalAddress, PageCount, CacheType,
+                                         FlushTlb, VirtualAddress) == STATUS_SUCCESS)
+            {
+                /* Memory mapped successfully */
+                return STATUS_SUCCESS;
+            }
         }
+    }
 
-        /* Get PTE pointer and advance to next page */
-        PtePointer = (PHARDWARE_PTE)MmpGetPteAddress(ReturnAddress);
-        ReturnAddress = (PVOID)(ULONG_PTR)ReturnAddress + MM_PAGE_SIZE;
+    /* Make sure hardware layer memory pool bitmap is initialized */
+    if(!MmpHardwareVaBitmap.Buffer)
+    {
+        /* Initialize bitmap on first use */
+        MmpInitializeHardwareVaBitmap();
+    }
 
-        /* Check if PTE is valid */
-        if(PtePointer->Valid)
-        {
-            /* PTE is not available, go to the next one */
-            BaseAddress = ReturnAddress;
-            MappedPages = 0;
-            continue;
-        }
+    /* Raise runlevel and acquire hardware layer memory pool lock */
+    OldRunLevel = KeRaiseRunLevel(DISPATCH_LEVEL);
+    KeAcquireSpinLock(&MmpHardwareVaLock);
 
-        /* Increase number of mapped pages */
-        MappedPages++;
+    /* Look for free pages, starting at the next-fit hint */
+    Index = RtlFindClearBits(&MmpHardwareVaBitmap, PageCount, MmpHardwareVaHint);
+    if(Index == MAXULONG_PTR && MmpHardwareVaHint != 0)
+    {
+        /* Search the whole pool, as a free range could cross the hint */
+        Index = RtlFindClearBits(&MmpHardwareVaBitmap, PageCount, 0);
     }
 
-    /* Take the actual base address with an offset */
-    ReturnAddress = (PVOID)(ULONG_PTR)(BaseAddress + PAGE_OFFSET(PhysicalAddress.LowPart));
-
-    /* Check if base address starts at the beginning of the heap */
-    if(BaseAddress == MmpHardwareHeapStart)
+    /* Make sure free pages have been found */
+    if(Index == MAXULONG_PTR)
     {
-        /* Move heap beyond base address */
-        MmpHardwareHeapStart = (PVOID)((ULONG_PTR)BaseAddress + ((ULONG_PTR)PageCount << MM_PAGE_SHIFT));
+        /* Not enough free pages, release lock, lower runlevel and return error */
+        KeReleaseSpinLock(&MmpHardwareVaLock);
+        KeLowerRunLevel(OldRunLevel);
+        return STATUS_INSUFFICIENT_RESOURCES;
     }
 
+    /* Mark pages as used and move the hint beyond them */
+    RtlSetBits(&MmpHardwareVaBitmap, Index, PageCount);
+    MmpHardwareVaHint = Index + PageCount;
+
+    /* Release hardware layer memory pool lock and lower runlevel */
+    KeReleaseSpinLock(&MmpHardwareVaLock);
+    KeLowerRunLevel(OldRunLevel);
+
+    /* Get base address and take the actual return address with an offset */
+    BaseAddress = (PVOID)(MM_HARDWARE_VA_START + (Index << MM_PAGE_SHIFT));
+    ReturnAddress = (PVOID)((ULONG_PTR)BaseAddress + PAGE_OFFSET(PhysicalAddress.LowPart));
+    MappedPages = PageCount;
+
     /* Iterate through mapped pages */
     while(MappedPages--)
     {
@@ -222,6 +211,7 @@ MmMapHardwareMemory(IN PHYSICAL_ADDRESS PhysicalAddress,
         PtePointer->PageFrameNumber = (PFN_NUMBER)(PhysicalAddress.QuadPart >> MM_PAGE_SHIFT);
         PtePointer->Valid = 1;
         PtePointer->Writable = 1;
+        MmpSetPteCacheType((PMMPTE)PtePointer, MM_PAGE_SIZE, CacheType);
 
         /* Advance to the next address */
         PhysicalAddress.QuadPart += MM_PAGE_SIZE;
@@ -231,8 +221,8 @@ MmMapHardwareMemory(IN PHYSICAL_ADDRESS PhysicalAddress,
     /* Check if TLB needs to be flushed */
     if(FlushTlb)
     {
-        /* Flush the TLB */
-        MmFlushTlb();
+        /* Invalidate TLB entries for the range */
+        MmFlushTlbRange(PAGE_ALIGN(ReturnAddress), PageCount);
     }
 
     /* Return virtual address */
@@ -241,77 +231,114 @@ MmMapHardwareMemory(IN PHYSICAL_ADDRESS PhysicalAddress,
 }
 
 /**
- * Marks existing mapping as CD/WT to avoid delays in write-back cache.
+ * Changes the caching type of an existing kernel mapping. Large pages covering the range only partially get split
+ * first, so the caching type of memory outside the range stays intact.
  *
  * @param VirtualAddress
- *        Supplies the virtual address region to mark as CD/WT.
+ *        Supplies the virtual address of the mapped memory.
  *
  * @param PageCount
  *        Supplies the number of mapped pages.
  *
- * @return This routine does not return any value.
+ * @param CacheType
+ *        Specifies the new caching type of the mapping.
+ *
+ * @return This routine returns a status code.
  *
  * @since XT 1.0
  */
 XTAPI
-VOID
-MmMarkHardwareMemoryWriteThrough(IN PVOID VirtualAddress,
-                                 IN PFN_NUMBER PageCount)
+XTSTATUS
+MmSetHardwareMemoryCacheType(IN PVOID VirtualAddress,
+                             IN PFN_NUMBER PageCount,
+                             IN MEMORY_CACHING_TYPE CacheType)
 {
-    PHARDWARE_PTE PtePointer;
-    PFN_NUMBER Page;
+    ULONG_PTR Address, EndAddress, FlushAddress, FlushSize, PageSize;
+    MMTLB_FLUSH_BATCH Batch;
+    PMMPTE PointerPte;
+    XTSTATUS Status;
 
-    /* Get PTE address from virtual address */
-    PtePointer = (PHARDWARE_PTE)MmpGetPteAddress(VirtualAddress);
+    /* Get the cache line size used to flush caches, zero if CLFLUSH is not supported */
+    FlushSize = (KeGetCurrentProcessorControlBlock()->CpuId.FeatureBits & KF_CLFLUSH) ?
+                KeGetCurrentProcessorControlBlock()->CpuId.CacheFlushSize : 0;
 
-    /* Iterate through mapped pages */
-    for(Page = 0; Page < PageCount; Page++)
+    /* Make sure caching type is valid */
+    if(CacheType >= MmMaximumCacheType)
     {
-        /* Mark pages as CD/WT */
-        PtePointer->CacheDisable = 1;
-        PtePointer->WriteThrough = 1;
-        PtePointer++;
+        /* Invalid caching type, return error */
+        return STATUS_INVALID_PARAMETER;
     }
-}
 
-/**
- * Remaps the PTE to new physical address.
- *
- * @param VirtualAddress
- *        Supplies the virtual address to remap.
- *
- * @param PhysicalAddress
- *        Supplies a new physical address.
- *
- * @param FlushTlb
- *        Specifies whether to flush the TLB or not.
- *
- * @return This routine does not return any value.
- *
- * @since XT 1.0
- */
-XTAPI
-VOID
-MmRemapHardwareMemory(IN PVOID VirtualAddress,
-                      IN PHYSICAL_ADDRESS PhysicalAddress,
-                      IN BOOLEAN FlushTlb)
-{
-    PHARDWARE_PTE PtePointer;
+    /* Iterate through all pages, regardless of their size */
+    Address = (ULONG_PTR)PAGE_ALIGN(VirtualAddress);
+    EndAddress = Address + (PageCount << MM_PAGE_SHIFT);
+    while(Address < EndAddress)
+    {
+        /* Get the paging structure entry mapping the address */
+        PointerPte = MmpGetMappingEntry((PVOID)Address, &PageSize);
+        if(!PointerPte)
+        {
+            /* Address is not mapped, skip the region described by the missing entry */
+            Address = ROUND_DOWN(Address, PageSize) + PageSize;
+            continue;
+        }
 
-    /* Get PTE address from virtual address */
-    PtePointer = (PHARDWARE_PTE)MmpGetPteAddress(VirtualAddress);
+        /* Check if large page exceeds the range */
+        if(PageSize > MM_PAGE_SIZE && (ROUND_DOWN(Address, PageSize) < (ULONG_PTR)PAGE_ALIGN(VirtualAddress) ||
+                                       ROUND_DOWN(Address, PageSize) + PageSize > EndAddress))
+        {
+            /* Split the large page and look the address up again */
+            Status = MmpSplitLargePage(PointerPte, PageSize);
+            if(Status != STATUS_SUCCESS)
+            {
+                /* Failed to split large page, return error */
+                return Status;
+            }
+            continue;
+        }
 
-    /* Remap the PTE */
-    PtePointer->PageFrameNumber = (PFN_NUMBER)(PhysicalAddress.QuadPart >> MM_PAGE_SHIFT);
-    PtePointer->Valid = 1;
-    PtePointer->Writable = 1;
+        /* Set caching type and go to the next page */
+        MmpSetPteCacheType(PointerPte, PageSize, CacheType);
+        Address = ROUND_DOWN(Address, PageSize) + PageSize;
+    }
 
-    /* Check if TLB needs to be flushed */
-    if(FlushTlb)
+    /* Check if CLFLUSH is supported */
+    if(!FlushSize)
+    {
+        /* Invalidate TLB entries on all processors, each of them writes back and invalidates its caches afterwards */
+        MmInitializeTlbFlushBatch(&Batch, NULL);
+        MmQueueTlbFlush(&Batch, PAGE_ALIGN(VirtualAddress), PageCount);
+        Batch.FlushCaches = TRUE;
+        MmFlushTlbBatch(&Batch);
+        return STATUS_SUCCESS;
+    }
+
+    /* Make sure no processor uses the old caching type anymore, before any cache line gets flushed */
+    MmFlushTlbRange(PAGE_ALIGN(VirtualAddress), PageCount);
+
+    /* Iterate through all mapped pages again, as CLFLUSH faults on addresses that are not mapped */
+    Address = (ULONG_PTR)PAGE_ALIGN(VirtualAddress);
+    while(Address < EndAddress)
     {
-        /* Flush the TLB */
-        MmFlushTlb();
+        /* Check if address is mapped, regions without paging structure entries are skipped */
+        if(MmpGetMappingEntry((PVOID)Address, &PageSize))
+        {
+            /* Write back and invalidate all cache lines of the page, that might have been filled before */
+            for(FlushAddress = ROUND_DOWN(Address, PageSize);
+                FlushAddress < ROUND_DOWN(Address, PageSize) + PageSize;
+                FlushAddress += FlushSize)
+            {
+                ArFlushCacheLine((PVOID)FlushAddress);
+            }
+        }
+
+        /* Go to the next page */
+        Address = ROUND_DOWN(Address, PageSize) + PageSize;
     }
+
+    /* Make sure all cache lines got flushed */
+    ArMemoryBarrier();
+    return STATUS_SUCCESS;
 }
 
 /**
@@ -337,10 +364,20 @@ MmUnmapHardwareMemory(IN PVOID VirtualAddress,
                       IN BOOLEAN FlushTlb)
 {
     PHARDWARE_PTE PtePointer;
+    KRUNLEVEL OldRunLevel;
     PFN_NUMBER Page;
 
+    /* Check if memory is mapped in the large page pool */
+    if(MmpIsLargeHardwareAddress(VirtualAddress))
+    {
+        /* Unmap memory from the large page pool, TLB gets flushed regardless of the FlushTlb parameter */
+        return MmpUnmapLargeHardwareMemory(VirtualAddress, PageCount);
+    }
+
     /* Check if address is valid hardware memory */
-    if(VirtualAddress < (PVOID)MM_HARDWARE_VA_START)
+    if(VirtualAddress < (PVOID)MM_HARDWARE_VA_START ||
+       ((((ULONG_PTR)VirtualAddress - MM_HARDWARE_VA_START) >> MM_PAGE_SHIFT) + PageCount) >
+       (MM_HARDWARE_VA_SIZE >> MM_PAGE_SHIFT))
     {
         /* Invalid address, return error */
         return STATUS_INVALID_PARAMETER;
@@ -357,6 +394,7 @@ MmUnmapHardwareMemory(IN PVOID VirtualAddress,
     {
         /* Unmap the PTE and get the next one */
         PtePointer->CacheDisable = 0;
+        PtePointer->LargePage = 0;
         PtePointer->Valid = 0;
         PtePointer->Writable = 0;
         PtePointer->WriteThrough = 0;
@@ -367,15 +405,520 @@ MmUnmapHardwareMemory(IN PVOID VirtualAddress,
     /* Check if TLB needs to be flushed */
     if(FlushTlb)
     {
-        /* Flush the TLB */
-        MmFlushTlb();
+        /* Invalidate TLB entries for the range */
+        MmFlushTlbRange(VirtualAddress, PageCount);
+    }
+
+    /* Check if hardware layer memory pool bitmap is initialized */
+    if(MmpHardwareVaBitmap.Buffer)
+    {
+        /* Give pages back to the hardware layer memory pool */
+        OldRunLevel = KeRaiseRunLevel(DISPATCH_LEVEL);
+        KeAcquireSpinLock(&MmpHardwareVaLock);
+        RtlClearBits(&MmpHardwareVaBitmap, ((ULONG_PTR)VirtualAddress - MM_HARDWARE_VA_START) >> MM_PAGE_SHIFT,
+                     PageCount);
+        KeReleaseSpinLock(&MmpHardwareVaLock);
+        KeLowerRunLevel(OldRunLevel);
+    }
+
+    /* Return success */
+    return STATUS_SUCCESS;
+}
+
+/**
+ * Looks for a run of free large page slots in the large page pool, starting at a slot with the given alignment.
+ *
+ * @param SlotCount
+ *        Supplies the number of large page slots needed.
+ *
+ * @param Alignment
+ *        Supplies the alignment of the first slot, in slots. It has to be a power of two.
+ *
+ * @param PhysicalSlot
+ *        Supplies the physical address of the mapped memory, in slots. The first slot will have the same offset
+ *        within the alignment, so both addresses can be mapped by the same page size.
+ *
+ * @return This routine returns the index of the first slot, or MAXULONG_PTR if no suitable slots are available.
+ *
+ * @note Caller must hold the hardware layer memory pool lock, so the slots can be reserved atomically.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+ULONG_PTR
+MmpFindLargeHardwareSlots(IN ULONG_PTR SlotCount,
+                          IN ULONG_PTR Alignment,
+                          IN ULONG_PTR PhysicalSlot)
+{
+    ULONG_PTR Index, Slot;
+
+    /* Iterate through all slots with matching alignment */
+    for(Slot = PhysicalSlot & (Alignment - 1);
+        Slot + SlotCount <= (MM_HARDWARE_LARGE_VA_SIZE >> MM_LARGE_PAGE_SHIFT);
+        Slot += Alignment)
+    {
+        /* Check if all needed slots are free */
+        for(Index = 0; Index < SlotCount; Index++)
+        {
+            if(RtlTestBit(&MmpHardwareLargeBitmap, Slot + Index))
+            {
+                /* Slot in use */
+                break;
+            }
+        }
+
+        /* Check if free slots have been found */
+        if(Index == SlotCount)
+        {
+            /* Return first slot */
+            return Slot;
+        }
     }
 
-    /* Check if heap can be reused */
-    if(MmpHardwareHeapStart > VirtualAddress)
+    /* No suitable slots available */
+    return MAXULONG_PTR;
+}
+
+/**
+ * Initializes the bitmap describing pages used in the hardware layer memory pool.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmpInitializeHardwareVaBitmap(VOID)
+{
+    ULONG_PTR Index, PageCount, ReservedPages;
+    PHARDWARE_PTE PtePointer;
+
+    /* Calculate number of pages in the pool and number of pages reserved below the heap */
+    PageCount = MM_HARDWARE_VA_SIZE >> MM_PAGE_SHIFT;
+    ReservedPages = ((ULONG_PTR)MM_HARDWARE_HEAP_START_ADDRESS - MM_HARDWARE_VA_START) >> MM_PAGE_SHIFT;
+
+    /* Initialize bitmap and mark reserved pages as used */
+    RtlInitializeBitMap(&MmpHardwareVaBitmap, MmpHardwareVaBitmapBuffer, PageCount);
+    RtlClearAllBits(&MmpHardwareVaBitmap);
+    RtlSetBits(&MmpHardwareVaBitmap, 0, ReservedPages);
+
+    /* Mark pages already mapped by the boot loader as used */
+    PtePointer = (PHARDWARE_PTE)MmpGetPteAddress((PVOID)MM_HARDWARE_VA_START);
+    for(Index = ReservedPages; Index < PageCount; Index++)
     {
-        /* Free VA space */
-        MmpHardwareHeapStart = VirtualAddress;
+        /* Check if PTE is valid */
+        if(PtePointer[Index].Valid)
+        {
+            /* Page is in use */
+            RtlSetBit(&MmpHardwareVaBitmap, Index);
+        }
+    }
+
+    /* Start searching at the beginning of the heap */
+    MmpHardwareVaHint = ReservedPages;
+}
+
+/**
+ * Checks whether the given virtual address belongs to the hardware layer large page pool.
+ *
+ * @param VirtualAddress
+ *        Supplies the virtual address to check.
+ *
+ * @return This routine returns TRUE if address belongs to the large page pool, or FALSE otherwise.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+BOOLEAN
+MmpIsLargeHardwareAddress(IN PVOID VirtualAddress)
+{
+    /* Check if address lies within the large page pool */
+    return ((ULONG_PTR)VirtualAddress >= MM_HARDWARE_LARGE_VA_START &&
+            (ULONG_PTR)VirtualAddress - MM_HARDWARE_LARGE_VA_START < MM_HARDWARE_LARGE_VA_SIZE) ? TRUE : FALSE;
+}
+
+/**
+ * Maps physical address to the hardware layer large page pool, using the largest pages possible.
+ *
+ * @param PhysicalAddress
+ *        Supplies the physical address to map.
+ *
+ * @param PageCount
+ *        Supplies the number of pages to be mapped.
+ *
+ * @param CacheType
+ *        Specifies the caching type of the mapping.
+ *
+ * @param FlushTlb
+ *        Specifies whether to flush the TLB or not.
+ *
+ * @param VirtualAddress
+ *        Supplies a buffer that receives the virtual address of the mapped pages.
+ *
+ * @return This routine returns a status code.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+XTSTATUS
+MmpMapLargeHardwareMemory(IN PHYSICAL_ADDRESS PhysicalAddress,
+                          IN PFN_NUMBER PageCount,
+                          IN MEMORY_CACHING_TYPE CacheType,
+                          IN BOOLEAN FlushTlb,
+                          OUT PVOID *VirtualAddress)
+{
+    ULONG_PTR Address, BaseAddress, MappedSize, PageSize, Slot, SlotCount;
+    ULONGLONG PhysicalBase, PhysicalEnd, PhysicalStart;
+    MMHARDWARE_MAPPING_STATISTICS PagesUsed;
+    PHYSICAL_ADDRESS CurrentAddress;
+    KRUNLEVEL OldRunLevel;
+    XTSTATUS Status;
+
+    /* Calculate physical range and the number of large page slots covering it */
+    PhysicalStart = PhysicalAddress.QuadPart & ~(ULONGLONG)MM_PAGE_MASK;
+    PhysicalEnd = PhysicalStart + ((ULONGLONG)PageCount << MM_PAGE_SHIFT);
+    PhysicalBase = ROUND_DOWN(PhysicalStart, (ULONGLONG)MM_LARGE_PAGE_SIZE);
+    SlotCount = (ULONG_PTR)((ROUND_UP(PhysicalEnd, (ULONGLONG)MM_LARGE_PAGE_SIZE) - PhysicalBase) >> MM_LARGE_PAGE_SHIFT);
+
+    /* Raise runlevel and acquire hardware layer memory pool lock, so slots cannot be taken in the meantime */
+    OldRunLevel = KeRaiseRunLevel(DISPATCH_LEVEL);
+    KeAcquireSpinLock(&MmpHardwareVaLock);
+
+    /* Check if the range contains a naturally aligned page of the largest supported size */
+    Slot = MAXULONG_PTR;
+    if(MmpLargestPageSize > MM_LARGE_PAGE_SIZE &&
+       ROUND_UP(PhysicalStart, (ULONGLONG)MmpLargestPageSize) + MmpLargestPageSize <= PhysicalEnd)
+    {
+        /* Try to find slots, that allow mapping the largest pages */
+        Slot = MmpFindLargeHardwareSlots(SlotCount, MmpLargestPageSize >> MM_LARGE_PAGE_SHIFT,
+                                         (ULONG_PTR)(PhysicalBase >> MM_LARGE_PAGE_SHIFT));
+    }
+
+    /* Check if slots have been found already */
+    if(Slot == MAXULONG_PTR)
+    {
+        /* Find any free slots */
+        Slot = MmpFindLargeHardwareSlots(SlotCount, 1, 0);
+        if(Slot == MAXULONG_PTR)
+        {
+            /* Large page pool exhausted, release lock and return error */
+            KeReleaseSpinLock(&MmpHardwareVaLock);
+            KeLowerRunLevel(OldRunLevel);
+            return STATUS_INSUFFICIENT_RESOURCES;
+        }
+    }
+
+    /* Reserve the slots */
+    RtlSetBits(&MmpHardwareLargeBitmap, Slot, SlotCount);
+
+    /* Release hardware layer memory pool lock and lower runlevel */
+    KeReleaseSpinLock(&MmpHardwareVaLock);
+    KeLowerRunLevel(OldRunLevel);
+    BaseAddress = MM_HARDWARE_LARGE_VA_START + (Slot << MM_LARGE_PAGE_SHIFT) + (ULONG_PTR)(PhysicalStart - PhysicalBase);
+
+    /* Map the whole range, using the largest possible pages */
+    RtlZeroMemory(&PagesUsed, sizeof(MMHARDWARE_MAPPING_STATISTICS));
+    Address = BaseAddress;
+    CurrentAddress.QuadPart = PhysicalStart;
+    while((ULONGLONG)CurrentAddress.QuadPart < PhysicalEnd)
+    {
+        /* Map next page */
+        Status = MmpMapLargestPage((PVOID)Address, CurrentAddress,
+                                   (ULONG_PTR)(PhysicalEnd - CurrentAddress.QuadPart), &MappedSize);
+        if(Status != STATUS_SUCCESS)
+        {
+            /* Failed to map the page, unmap what has been mapped so far and release the slots */
+            if(Address != BaseAddress)
+            {
+                MmpUnmapLargeHardwareMemory((PVOID)BaseAddress, (Address - BaseAddress) >> MM_PAGE_SHIFT);
+            }
+
+            /* Release the slots */
+            OldRunLevel = KeRaiseRunLevel(DISPATCH_LEVEL);
+            KeAcquireSpinLock(&MmpHardwareVaLock);
+            RtlClearBits(&MmpHardwareLargeBitmap, Slot, SlotCount);
+            KeReleaseSpinLock(&MmpHardwareVaLock);
+            KeLowerRunLevel(OldRunLevel);
+            return Status;
+        }
+
+        /* Set caching type of the page */
+        MmpSetPteCacheType(MmpGetMappingEntry((PVOID)Address, &PageSize), MappedSize, CacheType);
+
+        /* Count page sizes used */
+        if(MappedSize == MM_PAGE_SIZE)
+        {
+            PagesUsed.SmallPages++;
+        }
+        else if(MappedSize == MM_LARGE_PAGE_SIZE)
+        {
+            PagesUsed.LargePages++;
+        }
+        else
+        {
+            PagesUsed.HugePages++;
+        }
+
+        /* Advance to the next page */
+        Address += MappedSize;
+        CurrentAddress.QuadPart += MappedSize;
+    }
+
+    /* Update statistics */
+    MmpHardwareMappingStatistics.SmallPages += PagesUsed.SmallPages;
+    MmpHardwareMappingStatistics.LargePages += PagesUsed.LargePages;
+    MmpHardwareMappingStatistics.HugePages += PagesUsed.HugePages;
+
+    /* Check if TLB needs to be flushed */
+    if(FlushTlb)
+    {
+        /* Invalidate TLB entries for the range */
+        MmFlushTlbRange((PVOID)BaseAddress, PageCount);
+    }
+
+    /* Return virtual address */
+    *VirtualAddress = (PVOID)(BaseAddress + PAGE_OFFSET(PhysicalAddress.LowPart));
+    return STATUS_SUCCESS;
+}
+
+/**
+ * Sets the caching type of the given paging structure entry, by selecting the Page Attribute Table entry with PAT,
+ * PCD and PWT bits.
+ *
+ * @param PointerPte
+ *        Supplies a pointer to the paging structure entry.
+ *
+ * @param PageSize
+ *        Supplies the size of the page mapped by the entry.
+ *
+ * @param CacheType
+ *        Specifies the caching type to set.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmpSetPteCacheType(IN PMMPTE PointerPte,
+                   IN ULONG_PTR PageSize,
+                   IN MEMORY_CACHING_TYPE CacheType)
+{
+    ULONG PatIndex;
+
+    /* Get the Page Attribute Table entry for the caching type */
+    switch(CacheType)
+    {
+        case MmCached:
+            PatIndex = MM_PAT_INDEX_WRITE_BACK;
+            break;
+        case MmWriteThrough:
+            PatIndex = MM_PAT_INDEX_WRITE_THROUGH;
+            break;
+        case MmUncachedMinus:
+            PatIndex = MM_PAT_INDEX_UNCACHED_MINUS;
+            break;
+        case MmWriteCombined:
+            /* Write-combining is available only with PAT, UC- is the closest legacy type */
+            PatIndex = (KeGetCurrentProcessorControlBlock()->CpuId.FeatureBits & KF_PAT) ?
+                       MM_PAT_INDEX_WRITE_COMBINED : MM_PAT_INDEX_UNCACHED_MINUS;
+            break;
+        default:
+            PatIndex = MM_PAT_INDEX_UNCACHED;
+            break;
+    }
+
+    /* Set PCD and PWT bits */
+    PointerPte->Hardware.WriteThrough = PatIndex & 1;
+    PointerPte->Hardware.CacheDisable = (PatIndex >> 1) & 1;
+
+    /* Check page size, as PAT bit location depends on it */
+    if(PageSize == MM_PAGE_SIZE)
+    {
+        /* Standard pages keep PAT bit in place of the large page bit */
+        PointerPte->Hardware.LargePage = (PatIndex >> 2) & 1;
+    }
+    else
+    {
+        /* Large pages keep PAT bit in the lowest page frame number bit */
+        PointerPte->Hardware.PageFrameNumber = (PointerPte->Hardware.PageFrameNumber & ~1ULL) | ((PatIndex >> 2) & 1);
+    }
+}
+
+/**
+ * Splits the given large page into a page table, mapping the same memory with pages of the next smaller size.
+ *
+ * @param PointerPte
+ *        Supplies a pointer to the paging structure entry mapping the large page.
+ *
+ * @param PageSize
+ *        Supplies the size of the page mapped by the entry.
+ *
+ * @return This routine returns a status code.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+XTSTATUS
+MmpSplitLargePage(IN PMMPTE PointerPte,
+                  IN ULONG_PTR PageSize)
+{
+    PHYSICAL_ADDRESS PhysicalAddress;
+    PFN_NUMBER PageFrameNumber;
+    MMPTE LargePte, TablePte;
+    PMMPTE PageTable;
+    XTSTATUS Status;
+    ULONG Index;
+    ULONG PatBit;
+
+    /* Allocate physical page for the new page table */
+    Status = MmpAllocateSystemPage(&PageFrameNumber);
+    if(Status != STATUS_SUCCESS)
+    {
+        /* Failed to allocate page, return error */
+        return Status;
+    }
+
+    /* Temporarily map the new page table */
+    PhysicalAddress.QuadPart = (ULONGLONG)PageFrameNumber << MM_PAGE_SHIFT;
+    Status = MmMapHardwareMemory(PhysicalAddress, 1, MmCached, TRUE, (PVOID *)&PageTable);
+    if(Status != STATUS_SUCCESS)
+    {
+        /* Failed to map page table, return error */
+        MmFreePhysicalPage(PageFrameNumber);
+        return Status;
+    }
+
+    /* Large pages keep PAT bit in the lowest page frame number bit, while standard pages keep it in place of PS */
+    LargePte = *PointerPte;
+    PatBit = 0;
+    if(PageSize == MM_LARGE_PAGE_SIZE)
+    {
+        /* Move PAT bit out of the page frame number */
+        PatBit = LargePte.Hardware.PageFrameNumber & 1;
+        LargePte.Hardware.PageFrameNumber &= ~1ULL;
+    }
+
+    /* Fill the page table, so it maps exactly the same memory as the large page */
+    for(Index = 0; Index < MM_PTE_PER_PAGE; Index++)
+    {
+        /* Copy attributes and calculate page frame number of the smaller page */
+        PageTable[Index] = LargePte;
+        PageTable[Index].Hardware.PageFrameNumber += Index * ((PageSize / MM_PTE_PER_PAGE) >> MM_PAGE_SHIFT);
+
+        /* Check if the smaller page is a standard 4KB page */
+        if(PageSize == MM_LARGE_PAGE_SIZE)
+        {
+            /* Standard pages do not have the large page bit, it is the PAT bit instead */
+            PageTable[Index].Hardware.LargePage = PatBit;
+        }
+    }
+
+    /* Unmap the page table */
+    MmUnmapHardwareMemory(PageTable, 1, TRUE);
+
+    /* Replace the large page with the page table in a single write, so the memory stays mapped all the time */
+    TablePte.Long = 0;
+    TablePte.Hardware.PageFrameNumber = PageFrameNumber;
+    TablePte.Hardware.Valid = 1;
+    TablePte.Hardware.Writable = 1;
+    *PointerPte = TablePte;
+
+    /* Invalidate the page table within the self-mapped page tables and update statistics */
+    ArInvalidateTlbEntry(MmpGetVirtualAddressFromPte(PointerPte));
+    MmpHardwareMappingStatistics.SplitPages++;
+
+    /* Return success */
+    return STATUS_SUCCESS;
+}
+
+/**
+ * Unmaps memory mapped in the hardware layer large page pool. Large pages covering the range only partially get
+ * split first, so the rest of them stays mapped. TLB is always flushed, as page tables might get freed.
+ *
+ * @param VirtualAddress
+ *        Supplies the virtual address to unmap.
+ *
+ * @param PageCount
+ *        Supplies the number of mapped pages.
+ *
+ * @return This routine returns a status code.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+XTSTATUS
+MmpUnmapLargeHardwareMemory(IN PVOID VirtualAddress,
+                            IN PFN_NUMBER PageCount)
+{
+    ULONG_PTR Address, EndAddress, PageSize, Slot;
+    MMTLB_FLUSH_BATCH Batch;
+    KRUNLEVEL OldRunLevel;
+    PMMPTE PointerPte;
+    XTSTATUS Status;
+
+    /* Calculate the range to unmap */
+    Address = (ULONG_PTR)PAGE_ALIGN(VirtualAddress);
+    EndAddress = Address + (PageCount << MM_PAGE_SHIFT);
+
+    /* Make sure the range fits in the large page pool */
+    if(PageCount == 0 || EndAddress - MM_HARDWARE_LARGE_VA_START > MM_HARDWARE_LARGE_VA_SIZE)
+    {
+        /* Invalid range, return error */
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    /* Initialize TLB flush batch */
+    MmInitializeTlbFlushBatch(&Batch, NULL);
+
+    /* Iterate through all pages, regardless of their size */
+    while(Address < EndAddress)
+    {
+        /* Get paging structure entry mapping the address */
+        PointerPte = MmpGetMappingEntry((PVOID)Address, &PageSize);
+        if(!PointerPte)
+        {
+            /* Address not mapped, skip it */
+            Address = ROUND_DOWN(Address, PageSize) + PageSize;
+            continue;
+        }
+
+        /* Check if only a part of the page is going to be unmapped */
+        if((Address & (PageSize - 1)) || (EndAddress - Address) < PageSize)
+        {
+            /* Split the page and try again */
+            Status = MmpSplitLargePage(PointerPte, PageSize);
+            if(Status != STATUS_SUCCESS)
+            {
+                /* Failed to split the page, return error */
+                return Status;
+            }
+            continue;
+        }
+
+        /* Unmap the page, single TLB entry maps the whole page regardless of its size */
+        PointerPte->Long = 0;
+        MmQueueTlbFlush(&Batch, (PVOID)Address, 1);
+        Address += PageSize;
+    }
+
+    /* Invalidate TLB entries of all unmapped pages on all processors, before the page tables and slots get reused */
+    MmFlushTlbBatch(&Batch);
+
+    /* Release page tables and slots, that are not used anymore */
+    for(Slot = ((ULONG_PTR)PAGE_ALIGN(VirtualAddress) - MM_HARDWARE_LARGE_VA_START) >> MM_LARGE_PAGE_SHIFT;
+        Slot <= (EndAddress - 1 - MM_HARDWARE_LARGE_VA_START) >> MM_LARGE_PAGE_SHIFT;
+        Slot++)
+    {
+        if(MmpFreeEmptyPageTables((PVOID)(MM_HARDWARE_LARGE_VA_START + (Slot << MM_LARGE_PAGE_SHIFT))))
+        {
+            /* Slot can be reused */
+            OldRunLevel = KeRaiseRunLevel(DISPATCH_LEVEL);
+            KeAcquireSpinLock(&MmpHardwareVaLock);
+            RtlClearBit(&MmpHardwareLargeBitmap, Slot);
+            KeReleaseSpinLock(&MmpHardwareVaLock);
+            KeLowerRunLevel(OldRunLevel);
+        }
     }
 
     /* Return success */
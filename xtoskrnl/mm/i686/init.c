@@ -51,6 +51,24 @@ MmpGetPteAddress(PVOID Address)
     return (PMMPTE)(MM_PTE_BASE + Offset);
 }
 
+/**
+ * Gets the virtual address, that is mapped by the given PTE (or PDE).
+ *
+ * @param PointerPte
+ *        Specifies the address of the paging structure entry within the self-mapped page tables.
+ *
+ * @return This routine returns the virtual address mapped by the given entry.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+PVOID
+MmpGetVirtualAddressFromPte(IN PMMPTE PointerPte)
+{
+    /* Calculate and return the mapped address */
+    return (PVOID)(((ULONG)PointerPte - MM_PTE_BASE) << (MM_PTI_SHIFT - MM_PTE_SHIFT));
+}
+
 /**
  * Performs architecture specific initialization of the XTOS Memory Manager.
  *
@@ -62,7 +80,37 @@ XTAPI
 VOID
 MmpInitializeArchitecture(VOID)
 {
-    UNIMPLEMENTED;
+    CPUID_REGISTERS CpuRegisters;
+
+    /* Use string instructions by default */
+    MmpPageZeroingMethod = PageZeroingStandard;
+
+    /* Check if SSE2 is supported */
+    CpuRegisters.Leaf = CPUID_GET_CPU_FEATURES;
+    CpuRegisters.SubLeaf = 0;
+    ArCpuId(&CpuRegisters);
+    if(CpuRegisters.Edx & CPUID_FEATURES_EDX_SSE2)
+    {
+        /* Use non-temporal stores */
+        MmpPageZeroingMethod = PageZeroingNonTemporal;
+    }
+
+    /* Get highest supported extended CPUID leaf */
+    CpuRegisters.Leaf = CPUID_GET_EXTENDED_MAXIMUM;
+    CpuRegisters.SubLeaf = 0;
+    ArCpuId(&CpuRegisters);
+    if(CpuRegisters.Eax >= CPUID_GET_EXTENDED_ADDRESS_SIZES)
+    {
+        /* Check if CLZERO instruction is supported */
+        CpuRegisters.Leaf = CPUID_GET_EXTENDED_ADDRESS_SIZES;
+        CpuRegisters.SubLeaf = 0;
+        ArCpuId(&CpuRegisters);
+        if(CpuRegisters.Ebx & CPUID_FEATURES_EXTENDED_EBX_CLZERO)
+        {
+            /* Zero whole cache lines without reading them first */
+            MmpPageZeroingMethod = PageZeroingCacheLineZero;
+        }
+    }
 }
 
 /**
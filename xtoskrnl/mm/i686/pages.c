@@ -9,6 +9,40 @@
 #include <xtos.h>
 
 
+/**
+ * Switches the current processor to the address space of the given process.
+ *
+ * @param OldProcess
+ *        Supplies a pointer to the process, that the current processor is leaving, or NULL.
+ *
+ * @param NewProcess
+ *        Supplies a pointer to the process, that the current processor is switching to.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmSwitchAddressSpace(IN PKPROCESS OldProcess,
+                     IN PKPROCESS NewProcess)
+{
+    KAFFINITY Processor;
+
+    /* Get current processor affinity */
+    Processor = (KAFFINITY)1 << KeGetCurrentProcessorNumber();
+
+    /* Update sets of processors running both processes */
+    if(OldProcess)
+    {
+        RtlAtomicAnd64((PLONG_PTR)&OldProcess->ActiveProcessors, ~Processor);
+    }
+    RtlAtomicOr64((PLONG_PTR)&NewProcess->ActiveProcessors, Processor);
+
+    /* Process Context Identifiers are not available in legacy mode, load new page directory */
+    ArWriteControlRegister(3, NewProcess->DirectoryTable[0]);
+}
+
 /**
  * Fills a section of memory with zeroes like RtlZeroMemory(), but in more efficient way.
  *
@@ -36,3 +70,327 @@ MmZeroPages(IN PVOID Address,
                    "a"(0)
                  : "memory");
 }
+
+/**
+ * Fills a section of memory with zeroes using non-temporal stores, bypassing the processor caches. This is intended
+ * for zeroing pages, that are not going to be accessed soon, like these zeroed in the background.
+ *
+ * @param Address
+ *        Supplies an address of the page to be filled with zeroes.
+ *
+ * @param Size
+ *        Number of bytes to be filled with zeros. This always should be a multiply of page size.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTFASTCALL
+VOID
+MmZeroPagesNonTemporal(IN PVOID Address,
+                       IN ULONG Size)
+{
+    PUCHAR CacheLine;
+
+    /* Check which zeroing method is supported by the processor */
+    switch(MmpPageZeroingMethod)
+    {
+        case PageZeroingCacheLineZero:
+            /* Zero memory one cache line at a time */
+            for(CacheLine = (PUCHAR)Address; CacheLine < (PUCHAR)Address + Size; CacheLine += 64)
+            {
+                asm volatile("clzero"
+                             :
+                             : "a" (CacheLine)
+                             : "memory");
+            }
+
+            /* Make sure all stores are globally visible */
+            asm volatile("sfence" ::: "memory");
+            break;
+        case PageZeroingNonTemporal:
+            /* Zero memory using non-temporal stores */
+            asm volatile("xor %%eax, %%eax\n"
+                         "1:\n"
+                         "movnti %%eax, 0(%0)\n"
+                         "movnti %%eax, 4(%0)\n"
+                         "movnti %%eax, 8(%0)\n"
+                         "movnti %%eax, 12(%0)\n"
+                         "movnti %%eax, 16(%0)\n"
+                         "movnti %%eax, 20(%0)\n"
+                         "movnti %%eax, 24(%0)\n"
+                         "movnti %%eax, 28(%0)\n"
+                         "add $32, %0\n"
+                         "sub $32, %1\n"
+                         "jnz 1b\n"
+                         "sfence\n"
+                         : "+r" (Address),
+                           "+r" (Size)
+                         :
+                         : "eax",
+                           "memory");
+            break;
+        default:
+            /* Non-temporal stores not supported, fall back to standard routine */
+            MmZeroPages(Address, Size);
+            break;
+    }
+}
+
+/**
+ * Allocates a new page table and links it into the given paging structure entry.
+ *
+ * @param PointerPte
+ *        Supplies a pointer to the paging structure entry, that will map the new page table.
+ *
+ * @return This routine returns a status code.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+XTSTATUS
+MmpAllocatePageTable(IN PMMPTE PointerPte)
+{
+    PFN_NUMBER PageFrameNumber;
+    PVOID PageTable;
+    XTSTATUS Status;
+
+    /* Allocate physical page for the new page table */
+    Status = MmpAllocateSystemPage(&PageFrameNumber);
+    if(Status != STATUS_SUCCESS)
+    {
+        /* Failed to allocate page, return error */
+        return Status;
+    }
+
+    /* Link the page table into the paging structure */
+    PointerPte->Long = 0;
+    PointerPte->Hardware.PageFrameNumber = PageFrameNumber;
+    PointerPte->Hardware.Valid = 1;
+    PointerPte->Hardware.Writable = 1;
+
+    /* Get the page table address within the self-mapped page tables */
+    PageTable = MmpGetVirtualAddressFromPte(PointerPte);
+
+    /* Make sure no stale translation exists and zero the new page table */
+    ArInvalidateTlbEntry(PageTable);
+    MmZeroPages(PageTable, MM_PAGE_SIZE);
+
+    /* Return success */
+    return STATUS_SUCCESS;
+}
+
+/**
+ * Frees the page table mapping the large page sized region containing the given address, if it does not map
+ * anything anymore.
+ *
+ * @param VirtualAddress
+ *        Supplies a virtual address within the region.
+ *
+ * @return This routine returns TRUE if the region is not mapped anymore, or FALSE otherwise.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+BOOLEAN
+MmpFreeEmptyPageTables(IN PVOID VirtualAddress)
+{
+    PMMPTE PointerPde, PointerPte;
+    PFN_NUMBER PageFrameNumber;
+    ULONG Index;
+
+    /* Check if PDE is present */
+    PointerPde = MmpGetPdeAddress(VirtualAddress);
+    if(!PointerPde->Hardware.Valid)
+    {
+        /* Region is not mapped */
+        return TRUE;
+    }
+
+    /* Check if region is mapped by 2MB page */
+    if(PointerPde->Hardware.LargePage)
+    {
+        /* Region is still mapped */
+        return FALSE;
+    }
+
+    /* Check if any page in the page table is still mapped */
+    PointerPte = MmpGetPteAddress((PVOID)ROUND_DOWN((ULONG_PTR)VirtualAddress, MM_LARGE_PAGE_SIZE));
+    for(Index = 0; Index < MM_PTE_PER_PAGE; Index++)
+    {
+        if(PointerPte[Index].Hardware.Valid)
+        {
+            /* Region is still mapped */
+            return FALSE;
+        }
+    }
+
+    /* Free the page table */
+    PageFrameNumber = (PFN_NUMBER)PointerPde->Hardware.PageFrameNumber;
+    PointerPde->Long = 0;
+    ArInvalidateTlbEntry(PointerPte);
+    MmFreePhysicalPage(PageFrameNumber);
+
+    /* Region is not mapped anymore */
+    return TRUE;
+}
+
+/**
+ * Looks up the paging structure entry, that maps the given virtual address, regardless of the page size.
+ *
+ * @param VirtualAddress
+ *        Supplies the virtual address to look up.
+ *
+ * @param PageSize
+ *        Supplies a pointer to the variable that receives the size of the memory mapped by the entry. If address
+ *        is not mapped, it receives the size of the region described by the missing entry.
+ *
+ * @return This routine returns a pointer to the paging structure entry, or NULL if the address is not mapped.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+PMMPTE
+MmpGetMappingEntry(IN PVOID VirtualAddress,
+                   OUT PULONG_PTR PageSize)
+{
+    PMMPTE PointerPte;
+
+    /* Check PDE (all PDPT entries are always present with PAE) */
+    PointerPte = MmpGetPdeAddress(VirtualAddress);
+    if(!PointerPte->Hardware.Valid || PointerPte->Hardware.LargePage)
+    {
+        /* Address is either not mapped or mapped by 2MB page */
+        *PageSize = MM_LARGE_PAGE_SIZE;
+        return PointerPte->Hardware.Valid ? PointerPte : NULL;
+    }
+
+    /* Check PTE */
+    PointerPte = MmpGetPteAddress(VirtualAddress);
+    *PageSize = MM_PAGE_SIZE;
+    return PointerPte->Hardware.Valid ? PointerPte : NULL;
+}
+
+/**
+ * Maps the given physical address using the largest page, that the alignment of both addresses and the size of
+ * the remaining range allow.
+ *
+ * @param VirtualAddress
+ *        Supplies the page aligned virtual address to be mapped.
+ *
+ * @param PhysicalAddress
+ *        Supplies the page aligned physical address to be mapped.
+ *
+ * @param Size
+ *        Supplies the size of the remaining range to be mapped, in bytes.
+ *
+ * @param MappedSize
+ *        Supplies a pointer to the variable that receives the size of the page used.
+ *
+ * @return This routine returns a status code.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+XTSTATUS
+MmpMapLargestPage(IN PVOID VirtualAddress,
+                  IN PHYSICAL_ADDRESS PhysicalAddress,
+                  IN ULONG_PTR Size,
+                  OUT PULONG_PTR MappedSize)
+{
+    PMMPTE PointerPte;
+    XTSTATUS Status;
+
+    /* Check if 2MB page can be used */
+    PointerPte = MmpGetPdeAddress(VirtualAddress);
+    if(!PointerPte->Hardware.Valid && Size >= MM_LARGE_PAGE_SIZE &&
+       !((ULONG_PTR)VirtualAddress & (MM_LARGE_PAGE_SIZE - 1)) && !(PhysicalAddress.QuadPart & (MM_LARGE_PAGE_SIZE - 1)))
+    {
+        /* Map 2MB page */
+        PointerPte->Long = 0;
+        PointerPte->Hardware.PageFrameNumber = (ULONGLONG)(PhysicalAddress.QuadPart >> MM_PAGE_SHIFT);
+        PointerPte->Hardware.LargePage = 1;
+        PointerPte->Hardware.Valid = 1;
+        PointerPte->Hardware.Writable = 1;
+        *MappedSize = MM_LARGE_PAGE_SIZE;
+        return STATUS_SUCCESS;
+    }
+
+    /* Make sure PDE is present */
+    if(!PointerPte->Hardware.Valid)
+    {
+        /* Allocate new page table */
+        Status = MmpAllocatePageTable(PointerPte);
+        if(Status != STATUS_SUCCESS)
+        {
+            /* Failed to allocate page table, return error */
+            return Status;
+        }
+    }
+
+    /* Map 4KB page */
+    PointerPte = MmpGetPteAddress(VirtualAddress);
+    PointerPte->Long = 0;
+    PointerPte->Hardware.PageFrameNumber = (ULONGLONG)(PhysicalAddress.QuadPart >> MM_PAGE_SHIFT);
+    PointerPte->Hardware.Valid = 1;
+    PointerPte->Hardware.Writable = 1;
+    *MappedSize = MM_PAGE_SIZE;
+    return STATUS_SUCCESS;
+}
+
+/**
+ * Makes sure that all page tables needed to map the given virtual address range are present.
+ *
+ * @param VirtualAddress
+ *        Supplies the base virtual address of the range.
+ *
+ * @param PageCount
+ *        Supplies the number of pages in the range.
+ *
+ * @return This routine returns a status code.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+XTSTATUS
+MmpMapPageTables(IN PVOID VirtualAddress,
+                 IN PFN_NUMBER PageCount)
+{
+    ULONG_PTR Address, LastAddress;
+    PMMPTE PointerPte;
+    XTSTATUS Status;
+
+    /* Calculate the first and the last address of the range */
+    Address = (ULONG_PTR)PAGE_ALIGN(VirtualAddress);
+    LastAddress = Address + (PageCount << MM_PAGE_SHIFT) - 1;
+
+    /* Iterate through all page directory entries covering the range */
+    while(TRUE)
+    {
+        /* Make sure PDE is present (all PDPT entries are always present with PAE) */
+        PointerPte = MmpGetPdeAddress((PVOID)Address);
+        if(!PointerPte->Hardware.Valid)
+        {
+            /* Allocate new page table */
+            Status = MmpAllocatePageTable(PointerPte);
+            if(Status != STATUS_SUCCESS)
+            {
+                /* Failed to allocate page table, return error */
+                return Status;
+            }
+        }
+
+        /* Advance to the next page directory entry */
+        Address = ROUND_DOWN(Address, ((ULONG_PTR)1 << MM_PDI_SHIFT)) + ((ULONG_PTR)1 << MM_PDI_SHIFT);
+
+        /* Check if the whole range has been covered or the address wrapped around */
+        if(Address == 0 || Address > LastAddress)
+        {
+            /* All page tables are present */
+            break;
+        }
+    }
+
+    /* Return success */
+    return STATUS_SUCCESS;
+}
@@ -36,6 +36,23 @@ MmInitializeMemoryManager(VOID)
 
     /* Proceed with architecture specific initialization */
     MmpInitializeArchitecture();
+
+    /* Discover NUMA topology before physical pages get assigned to nodes */
+    MmpInitializeNumaTopology();
+
+    /* Build the PFN database */
+    MmpInitializePfnDatabase();
+
+    /* Initialize hardware layer large page pool */
+    RtlInitializeBitMap(&MmpHardwareLargeBitmap, MmpHardwareLargeBitmapBuffer,
+                        MM_HARDWARE_LARGE_VA_SIZE >> MM_LARGE_PAGE_SHIFT);
+
+    /* Initialize kernel stacks pool */
+    RtlInitializeBitMap(&MmpKernelStackVaBitmap, MmpKernelStackVaBitmapBuffer,
+                        MM_KERNEL_STACK_VA_SIZE >> MM_PAGE_SHIFT);
+
+    /* Initialize system pages pool */
+    RtlInitializeBitMap(&MmpSystemVaBitmap, MmpSystemVaBitmapBuffer, MM_SYSTEM_VA_SIZE >> MM_PAGE_SHIFT);
 }
 
 /**
@@ -49,26 +66,30 @@ XTAPI
 VOID
 MmpScanMemoryDescriptors(VOID)
 {
-    PLOADER_MEMORY_DESCRIPTOR MemoryDescriptor;
-    PLIST_ENTRY MemoryMappings;
+    PMMMEMORY_DESCRIPTOR MemoryDescriptor;
     PFN_NUMBER FreePages;
+    ULONG Index;
 
     /* Initially, set number of free pages to 0 */
     FreePages = 0;
 
-    /* Iterate through memory mappings provided by the boot loader */
-    MemoryMappings = KeInitializationBlock->MemoryDescriptorListHead.Flink;
-    while(MemoryMappings != &KeInitializationBlock->MemoryDescriptorListHead)
+    /* Build memory descriptors array, unless hardware layer already did it */
+    if(!MmpMemoryDescriptorCount)
+    {
+        MmpInitializeMemoryDescriptors();
+    }
+
+    /* Iterate through sorted memory descriptors */
+    for(Index = 0; Index < MmpMemoryDescriptorCount; Index++)
     {
         /* Get memory descriptor */
-        MemoryDescriptor = CONTAIN_RECORD(MemoryMappings, LOADER_MEMORY_DESCRIPTOR, ListEntry);
+        MemoryDescriptor = &MmpMemoryDescriptors[Index];
 
         /* Check if memory type is invisible or cached */
         if(MmpVerifyMemoryTypeInvisible(MemoryDescriptor->MemoryType) ||
            (MemoryDescriptor->MemoryType == LoaderHardwareCachedMemory))
         {
             /* Skip this mapping */
-            MemoryMappings = MemoryMappings->Flink;
             continue;
         }
 
@@ -93,8 +114,8 @@ MmpScanMemoryDescriptors(VOID)
             MmHighestPhysicalPage = (MemoryDescriptor->BasePage + MemoryDescriptor->PageCount) - 1;
         }
 
-        /* Check if memory type should be considered as free */
-        if(MmpVerifyMemoryTypeFree(MemoryDescriptor->MemoryType))
+        /* Check if memory is free and not used by the boot loader anymore */
+        if(MemoryDescriptor->MemoryType == LoaderFree)
         {
             /* Check if this descriptor contains more free pages */
             if(MemoryDescriptor->PageCount >= FreePages)
@@ -104,13 +125,10 @@ MmpScanMemoryDescriptors(VOID)
                 MmFreeDescriptor = MemoryDescriptor;
             }
         }
-
-        /* Get next memory descriptor */
-        MemoryMappings = MemoryMappings->Flink;
     }
 
     /* Store original free descriptor */
-    RtlCopyMemory(&MmOldFreeDescriptor, MmFreeDescriptor, sizeof(LOADER_MEMORY_DESCRIPTOR));
+    RtlCopyMemory(&MmOldFreeDescriptor, MmFreeDescriptor, sizeof(MMMEMORY_DESCRIPTOR));
 }
 
 /** Checks whether the specified memory type should be considered as free.
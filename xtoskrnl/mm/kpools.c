@@ -31,12 +31,117 @@ MmAllocateKernelStack(IN PVOID *Stack,
                       IN BOOLEAN LargeStack,
                       IN UCHAR SystemNode)
 {
-    UNIMPLEMENTED;
-    return STATUS_NOT_IMPLEMENTED;
+    PFN_NUMBER MappedPages, PageFrameNumber, StackPages;
+    PKPROCESSOR_CONTROL_BLOCK Prcb;
+    PMMSTACK_CACHE StackCache;
+    KRUNLEVEL OldRunLevel;
+    PMMPTE PointerPte;
+    PVOID BaseAddress;
+    XTSTATUS Status;
+    ULONG_PTR Index;
+
+    /* Initialize variables */
+    *Stack = NULL;
+    StackPages = SIZE_TO_PAGES(LargeStack ? KERNEL_LARGE_STACK_SIZE : KERNEL_STACK_SIZE);
+
+    /* Raise runlevel to DISPATCH level, so the thread cannot be moved to another processor */
+    OldRunLevel = KeRaiseRunLevel(DISPATCH_LEVEL);
+
+    /* Get current processor stack cache */
+    Prcb = KeGetCurrentProcessorControlBlock();
+    StackCache = &Prcb->StackCache;
+
+    /* Check if there is a cached stack of the requested size, backed by memory of the requested node */
+    if(StackCache->Count[LargeStack ? 1 : 0] && (SystemNode == Prcb->NodeNumber || MmpNodeCount == 1))
+    {
+        /* Take the stack from the cache, it is still mapped */
+        *Stack = StackCache->Stacks[LargeStack ? 1 : 0][--StackCache->Count[LargeStack ? 1 : 0]];
+        StackCache->Hits++;
+
+        /* Lower runlevel and return success */
+        KeLowerRunLevel(OldRunLevel);
+        return STATUS_SUCCESS;
+    }
+
+    /* Stack cache miss, lower runlevel */
+    StackCache->Misses++;
+    KeLowerRunLevel(OldRunLevel);
+
+    /* Fall back to the first node if the given one does not exist */
+    if(SystemNode >= MmpNodeCount)
+    {
+        SystemNode = 0;
+    }
+
+    /* Raise runlevel and acquire kernel stacks pool lock */
+    OldRunLevel = KeRaiseRunLevel(DISPATCH_LEVEL);
+    KeAcquireSpinLock(&MmpKernelStackVaLock);
+
+    /* Look for free pages for the stack and its guard pages, starting at the next-fit hint */
+    Index = RtlFindClearBits(&MmpKernelStackVaBitmap, StackPages + KERNEL_STACK_GUARD_PAGES, MmpKernelStackVaHint);
+    if(Index == MAXULONG_PTR && MmpKernelStackVaHint != 0)
+    {
+        /* Search the whole pool, as a free range could cross the hint */
+        Index = RtlFindClearBits(&MmpKernelStackVaBitmap, StackPages + KERNEL_STACK_GUARD_PAGES, 0);
+    }
+
+    /* Make sure free pages have been found */
+    if(Index == MAXULONG_PTR)
+    {
+        /* Not enough free pages, release lock and return error */
+        KeReleaseSpinLock(&MmpKernelStackVaLock);
+        KeLowerRunLevel(OldRunLevel);
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    /* Mark pages as used */
+    RtlSetBits(&MmpKernelStackVaBitmap, Index, StackPages + KERNEL_STACK_GUARD_PAGES);
+    MmpKernelStackVaHint = Index + StackPages + KERNEL_STACK_GUARD_PAGES;
+
+    /* Release kernel stacks pool lock and lower runlevel */
+    KeReleaseSpinLock(&MmpKernelStackVaLock);
+    KeLowerRunLevel(OldRunLevel);
+
+    /* Guard pages stay at the bottom of the range and are never mapped, so stack overflow causes a page fault */
+    BaseAddress = (PVOID)(MM_KERNEL_STACK_VA_START + ((Index + KERNEL_STACK_GUARD_PAGES) << MM_PAGE_SHIFT));
+
+    /* Make sure all page tables are present */
+    Status = MmpMapPageTables(BaseAddress, StackPages);
+    if(Status != STATUS_SUCCESS)
+    {
+        /* Failed to map page tables, give pages back and return error */
+        MmpFreeKernelStackPages(BaseAddress, 0, StackPages);
+        return Status;
+    }
+
+    /* Back the stack with physical pages */
+    PointerPte = MmpGetPteAddress(BaseAddress);
+    for(MappedPages = 0; MappedPages < StackPages; MappedPages++)
+    {
+        /* Allocate physical page on the requested node */
+        Status = MmAllocatePhysicalPageOnNode(SystemNode, FALSE, &PageFrameNumber);
+        if(Status != STATUS_SUCCESS)
+        {
+            /* Out of physical memory, release already mapped pages and return error */
+            MmpFreeKernelStackPages(BaseAddress, MappedPages, StackPages);
+            return Status;
+        }
+
+        /* Fill the PTE */
+        PointerPte[MappedPages].Long = 0;
+        PointerPte[MappedPages].Hardware.PageFrameNumber = PageFrameNumber;
+        PointerPte[MappedPages].Hardware.Valid = 1;
+        PointerPte[MappedPages].Hardware.Writable = 1;
+    }
+
+    /* Stack grows down, so return its top */
+    *Stack = (PVOID)((ULONG_PTR)BaseAddress + (StackPages << MM_PAGE_SHIFT));
+    return STATUS_SUCCESS;
 }
 
 /**
- * Allocates a buffer for structures needed by a processor and assigns it to a corresponding CPU.
+ * Allocates a buffer for structures needed by a processor and assigns it to a corresponding CPU. The buffer is
+ * page aligned, so it never shares a cache line with other processors, and backed by memory of the CPU's NUMA node.
  *
  * @param CpuNumber
  *        Specifies the zero-indexed CPU number as an owner of the allocated structures.
@@ -55,23 +160,34 @@ MmAllocateProcessorStructures(IN ULONG CpuNumber,
 {
     PKPROCESSOR_BLOCK ProcessorBlock;
     PVOID ProcessorStructures;
-    UINT_PTR Address;
+    ULONG NodeNumber;
+    XTSTATUS Status;
 
-    /* Not implemented yet, this is just a hack */
-    UNIMPLEMENTED;
+    /* Make sure the processor has been enumerated in MADT */
+    if(CpuNumber >= HlpSystemInfo.CpuCount)
+    {
+        /* Unknown processor, return error */
+        return STATUS_INVALID_PARAMETER;
+    }
 
-    /* Assign memory for processor structures from preallocated buffer */
-    ProcessorStructures = &MmProcessorStructuresData[CpuNumber - 1];
+    /* Allocate page aligned memory for processor structures on the processor's NUMA node */
+    NodeNumber = MmpGetProcessorNode(CpuNumber);
+    Status = MmAllocateSystemPages(SIZE_TO_PAGES(KPROCESSOR_STRUCTURES_SIZE), 1, NodeNumber, &ProcessorStructures);
+    if(Status != STATUS_SUCCESS)
+    {
+        /* Memory allocation failed, return error */
+        return Status;
+    }
 
     /* Make sure all structures are zeroed */
     RtlZeroMemory(ProcessorStructures, KPROCESSOR_STRUCTURES_SIZE);
 
-    /* Align address to page size boundary and find a space for processor block */
-    Address = ROUND_UP((UINT_PTR)ProcessorStructures, MM_PAGE_SIZE);
-    ProcessorBlock = (PKPROCESSOR_BLOCK)((PUCHAR)Address + (2 * KERNEL_STACK_SIZE) + sizeof(ArInitialGdt));
+    /* Find a space for processor block, no alignment needed as the buffer is page aligned */
+    ProcessorBlock = (PKPROCESSOR_BLOCK)((PUCHAR)ProcessorStructures + (2 * KERNEL_STACK_SIZE) + sizeof(ArInitialGdt));
 
-    /* Store processor number in the processor block */
+    /* Store processor number and its NUMA node in the processor block */
     ProcessorBlock->CpuNumber = CpuNumber;
+    ProcessorBlock->Prcb.NodeNumber = (UCHAR)NodeNumber;
 
     /* Return pointer to the processor structures */
     *StructuresData = ProcessorStructures;
@@ -80,6 +196,131 @@ MmAllocateProcessorStructures(IN ULONG CpuNumber,
     return STATUS_SUCCESS;
 }
 
+/**
+ * Allocates a range of nonpaged system virtual memory, backed by physical pages of the given NUMA node.
+ *
+ * @param PageCount
+ *        Supplies the number of pages to allocate.
+ *
+ * @param Alignment
+ *        Supplies the alignment of the returned address, in pages. It has to be a power of two.
+ *
+ * @param NodeNumber
+ *        Supplies the preferred NUMA node of the physical pages.
+ *
+ * @param VirtualAddress
+ *        Supplies a pointer to the variable that receives the address of the allocated memory.
+ *
+ * @return This routine returns a status code.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+XTSTATUS
+MmAllocateSystemPages(IN PFN_NUMBER PageCount,
+                      IN PFN_NUMBER Alignment,
+                      IN ULONG NodeNumber,
+                      OUT PVOID *VirtualAddress)
+{
+    PFN_NUMBER MappedPages, PageFrameNumber;
+    KRUNLEVEL OldRunLevel;
+    PMMPTE PointerPte;
+    PVOID BaseAddress;
+    XTSTATUS Status;
+    ULONG_PTR Index;
+
+    /* Initialize variables */
+    *VirtualAddress = NULL;
+
+    /* Validate parameters */
+    if(!PageCount || !Alignment || (Alignment & (Alignment - 1)))
+    {
+        /* Invalid parameters, return error */
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    /* Fall back to the first node if the given one does not exist */
+    if(NodeNumber >= MmpNodeCount)
+    {
+        NodeNumber = 0;
+    }
+
+    /* Raise runlevel and acquire system pages pool lock */
+    OldRunLevel = KeRaiseRunLevel(DISPATCH_LEVEL);
+    KeAcquireSpinLock(&MmpSystemVaLock);
+
+    /* Look for free pages with some slack for alignment, starting at the next-fit hint */
+    Index = RtlFindClearBits(&MmpSystemVaBitmap, PageCount + Alignment - 1, MmpSystemVaHint);
+    if(Index == MAXULONG_PTR && MmpSystemVaHint != 0)
+    {
+        /* Search the whole pool, as a free range could cross the hint */
+        Index = RtlFindClearBits(&MmpSystemVaBitmap, PageCount + Alignment - 1, 0);
+    }
+
+    /* Make sure free pages have been found */
+    if(Index == MAXULONG_PTR)
+    {
+        /* Not enough free pages, release lock and return error */
+        KeReleaseSpinLock(&MmpSystemVaLock);
+        KeLowerRunLevel(OldRunLevel);
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    /* Align the range and mark its pages as used */
+    Index = ROUND_UP(Index, Alignment);
+    RtlSetBits(&MmpSystemVaBitmap, Index, PageCount);
+    MmpSystemVaHint = Index + PageCount;
+
+    /* Release system pages pool lock and lower runlevel */
+    KeReleaseSpinLock(&MmpSystemVaLock);
+    KeLowerRunLevel(OldRunLevel);
+
+    /* Get base address and make sure all page tables are present */
+    BaseAddress = (PVOID)(MM_SYSTEM_VA_START + (Index << MM_PAGE_SHIFT));
+    Status = MmpMapPageTables(BaseAddress, PageCount);
+    if(Status != STATUS_SUCCESS)
+    {
+        /* Failed to map page tables, give pages back and return error */
+        KeRaiseRunLevel(DISPATCH_LEVEL);
+        KeAcquireSpinLock(&MmpSystemVaLock);
+        RtlClearBits(&MmpSystemVaBitmap, Index, PageCount);
+        KeReleaseSpinLock(&MmpSystemVaLock);
+        KeLowerRunLevel(OldRunLevel);
+        return Status;
+    }
+
+    /* Back the range with physical pages */
+    PointerPte = MmpGetPteAddress(BaseAddress);
+    for(MappedPages = 0; MappedPages < PageCount; MappedPages++)
+    {
+        /* Allocate physical page on the requested node */
+        Status = MmAllocatePhysicalPageOnNode(NodeNumber, FALSE, &PageFrameNumber);
+        if(Status != STATUS_SUCCESS)
+        {
+            /* Out of physical memory, release already mapped pages */
+            MmFreeSystemPages(BaseAddress, MappedPages);
+
+            /* Give back the part of the range that has not been mapped yet and return error */
+            KeRaiseRunLevel(DISPATCH_LEVEL);
+            KeAcquireSpinLock(&MmpSystemVaLock);
+            RtlClearBits(&MmpSystemVaBitmap, Index + MappedPages, PageCount - MappedPages);
+            KeReleaseSpinLock(&MmpSystemVaLock);
+            KeLowerRunLevel(OldRunLevel);
+            return Status;
+        }
+
+        /* Fill the PTE */
+        PointerPte[MappedPages].Long = 0;
+        PointerPte[MappedPages].Hardware.PageFrameNumber = PageFrameNumber;
+        PointerPte[MappedPages].Hardware.Valid = 1;
+        PointerPte[MappedPages].Hardware.Writable = 1;
+    }
+
+    /* Return virtual address */
+    *VirtualAddress = BaseAddress;
+    return STATUS_SUCCESS;
+}
+
 /**
  * Destroys a kernel stack and frees page table entry.
  *
@@ -98,7 +339,47 @@ VOID
 MmFreeKernelStack(IN PVOID Stack,
                   IN BOOLEAN LargeStack)
 {
-    UNIMPLEMENTED;
+    PFN_NUMBER Page, StackPages;
+    PKPROCESSOR_CONTROL_BLOCK Prcb;
+    PMMSTACK_CACHE StackCache;
+    KRUNLEVEL OldRunLevel;
+    PMMPTE PointerPte;
+
+    /* Get number of pages and the first PTE of the stack */
+    StackPages = SIZE_TO_PAGES(LargeStack ? KERNEL_LARGE_STACK_SIZE : KERNEL_STACK_SIZE);
+    PointerPte = MmpGetPteAddress((PVOID)((ULONG_PTR)Stack - (StackPages << MM_PAGE_SHIFT)));
+
+    /* Raise runlevel to DISPATCH level, so the thread cannot be moved to another processor */
+    OldRunLevel = KeRaiseRunLevel(DISPATCH_LEVEL);
+    Prcb = KeGetCurrentProcessorControlBlock();
+    StackCache = &Prcb->StackCache;
+
+    /* Cached stacks are served only to the allocations on the current node, so check where the stack resides */
+    for(Page = 0; Page < StackPages && MmpNodeCount > 1; Page++)
+    {
+        if(MmPfnDatabase[PointerPte[Page].Hardware.PageFrameNumber].u4.NodeNumber != Prcb->NodeNumber)
+        {
+            /* Stack is backed by memory of another node */
+            break;
+        }
+    }
+
+    /* Check if stack is local and current processor stack cache has room for another stack */
+    if((Page == StackPages || MmpNodeCount == 1) && StackCache->Count[LargeStack ? 1 : 0] < MM_STACK_CACHE_DEPTH)
+    {
+        /* Keep the stack mapped and put it in the cache */
+        StackCache->Stacks[LargeStack ? 1 : 0][StackCache->Count[LargeStack ? 1 : 0]++] = Stack;
+
+        /* Lower runlevel and return */
+        KeLowerRunLevel(OldRunLevel);
+        return;
+    }
+
+    /* Lower runlevel */
+    KeLowerRunLevel(OldRunLevel);
+
+    /* Stack is remote or the cache is full, unmap the stack and give its memory back */
+    MmpFreeKernelStackPages((PVOID)((ULONG_PTR)Stack - (StackPages << MM_PAGE_SHIFT)), StackPages, StackPages);
 }
 
 /**
@@ -115,5 +396,270 @@ XTAPI
 VOID
 MmFreeProcessorStructures(IN PVOID StructuresData)
 {
-    UNIMPLEMENTED;
+    /* Give processor structures memory back to the system pages pool */
+    MmFreeSystemPages(StructuresData, SIZE_TO_PAGES(KPROCESSOR_STRUCTURES_SIZE));
+}
+
+/**
+ * Frees a range of system virtual memory allocated by MmAllocateSystemPages() or reserved by MmReserveSystemPages()
+ * along with all physical pages committed to it.
+ *
+ * @param VirtualAddress
+ *        Supplies the address of the memory to free.
+ *
+ * @param PageCount
+ *        Supplies the number of pages to free.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmFreeSystemPages(IN PVOID VirtualAddress,
+                  IN PFN_NUMBER PageCount)
+{
+    PFN_NUMBER Page, UnusedPages;
+    KRUNLEVEL OldRunLevel;
+    PMMPTE PointerPte;
+    ULONG_PTR Index;
+
+    /* Check if address is valid system pages pool memory */
+    if(VirtualAddress < (PVOID)MM_SYSTEM_VA_START ||
+       ((((ULONG_PTR)VirtualAddress - MM_SYSTEM_VA_START) >> MM_PAGE_SHIFT) + PageCount) >
+       (MM_SYSTEM_VA_SIZE >> MM_PAGE_SHIFT))
+    {
+        /* Invalid address, nothing to free */
+        DebugPrint(L"Attempted to free invalid system pages at %P\n", VirtualAddress);
+        return;
+    }
+
+    /* Nothing to do if range is empty */
+    if(!PageCount)
+    {
+        return;
+    }
+
+    /* Raise runlevel and acquire page fault lock, so fault-around cannot commit pages while PTEs are torn down */
+    OldRunLevel = KeRaiseRunLevel(DISPATCH_LEVEL);
+    KeAcquireSpinLock(&MmpPageFaultLock);
+
+    /* Invalidate all PTEs, leaving page frame numbers in place */
+    VirtualAddress = PAGE_ALIGN(VirtualAddress);
+    PointerPte = MmpGetPteAddress(VirtualAddress);
+    UnusedPages = 0;
+    for(Page = 0; Page < PageCount; Page++)
+    {
+        /* Check if page is committed */
+        if(PointerPte[Page].Hardware.Valid)
+        {
+            /* Count pages that have never been accessed, eg. committed by fault-around but never touched */
+            if(!PointerPte[Page].Hardware.Accessed)
+            {
+                UnusedPages++;
+            }
+
+            /* Invalidate the PTE */
+            PointerPte[Page].Hardware.Valid = 0;
+        }
+        else
+        {
+            /* Reserved page has never been committed, just clear the PTE */
+            PointerPte[Page].Long = 0;
+        }
+    }
+
+    /* Release page fault lock and lower runlevel, as TLB flush cannot be done with page faults blocked */
+    KeReleaseSpinLock(&MmpPageFaultLock);
+    KeLowerRunLevel(OldRunLevel);
+
+    /* Account pages committed in vain */
+    if(UnusedPages)
+    {
+        RtlAtomicExchangeAdd64((PLONG_PTR)&MmpPageFaultStatistics.FaultAroundUnusedPages, UnusedPages);
+    }
+
+    /* Make sure no processor can access the pages anymore */
+    MmFlushTlbRange(VirtualAddress, PageCount);
+
+    /* Give physical pages back to the PFN database, first physical page is never handed out */
+    for(Page = 0; Page < PageCount; Page++)
+    {
+        /* Check if page is backed by physical memory */
+        if(PointerPte[Page].Hardware.PageFrameNumber)
+        {
+            /* Free the page and clear the PTE */
+            MmFreePhysicalPage(PointerPte[Page].Hardware.PageFrameNumber);
+            PointerPte[Page].Long = 0;
+        }
+    }
+
+    /* Raise runlevel and acquire system pages pool lock */
+    OldRunLevel = KeRaiseRunLevel(DISPATCH_LEVEL);
+    KeAcquireSpinLock(&MmpSystemVaLock);
+
+    /* Give virtual address range back to the system pages pool */
+    Index = ((ULONG_PTR)VirtualAddress - MM_SYSTEM_VA_START) >> MM_PAGE_SHIFT;
+    RtlClearBits(&MmpSystemVaBitmap, Index, PageCount);
+
+    /* Release system pages pool lock and lower runlevel */
+    KeReleaseSpinLock(&MmpSystemVaLock);
+    KeLowerRunLevel(OldRunLevel);
+}
+
+/**
+ * Reserves a range of system virtual memory without committing any physical memory to it. Pages get backed by
+ * zeroed physical memory of the accessing processor's node on first touch, so large reservations only cost memory
+ * that is actually used.
+ *
+ * @param PageCount
+ *        Supplies the number of pages to reserve.
+ *
+ * @param VirtualAddress
+ *        Supplies a pointer to the variable that receives the address of the reserved memory.
+ *
+ * @return This routine returns a status code.
+ *
+ * @note Reserved memory must not be accessed above DISPATCH level, where page faults cannot be resolved.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+XTSTATUS
+MmReserveSystemPages(IN PFN_NUMBER PageCount,
+                     OUT PVOID *VirtualAddress)
+{
+    KRUNLEVEL OldRunLevel;
+    PMMPTE PointerPte;
+    PVOID BaseAddress;
+    PFN_NUMBER Page;
+    XTSTATUS Status;
+    ULONG_PTR Index;
+
+    /* Initialize variables */
+    *VirtualAddress = NULL;
+
+    /* Validate parameters */
+    if(!PageCount)
+    {
+        /* Invalid parameters, return error */
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    /* Raise runlevel and acquire system pages pool lock */
+    OldRunLevel = KeRaiseRunLevel(DISPATCH_LEVEL);
+    KeAcquireSpinLock(&MmpSystemVaLock);
+
+    /* Look for free pages, starting at the next-fit hint */
+    Index = RtlFindClearBits(&MmpSystemVaBitmap, PageCount, MmpSystemVaHint);
+    if(Index == MAXULONG_PTR && MmpSystemVaHint != 0)
+    {
+        /* Search the whole pool, as a free range could cross the hint */
+        Index = RtlFindClearBits(&MmpSystemVaBitmap, PageCount, 0);
+    }
+
+    /* Make sure free pages have been found */
+    if(Index == MAXULONG_PTR)
+    {
+        /* Not enough free pages, release lock and return error */
+        KeReleaseSpinLock(&MmpSystemVaLock);
+        KeLowerRunLevel(OldRunLevel);
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    /* Mark pages as used */
+    RtlSetBits(&MmpSystemVaBitmap, Index, PageCount);
+    MmpSystemVaHint = Index + PageCount;
+
+    /* Release system pages pool lock and lower runlevel */
+    KeReleaseSpinLock(&MmpSystemVaLock);
+    KeLowerRunLevel(OldRunLevel);
+
+    /* Get base address and make sure all page tables are present, so faults can be resolved without allocations */
+    BaseAddress = (PVOID)(MM_SYSTEM_VA_START + (Index << MM_PAGE_SHIFT));
+    Status = MmpMapPageTables(BaseAddress, PageCount);
+    if(Status != STATUS_SUCCESS)
+    {
+        /* Failed to map page tables, give pages back and return error */
+        KeRaiseRunLevel(DISPATCH_LEVEL);
+        KeAcquireSpinLock(&MmpSystemVaLock);
+        RtlClearBits(&MmpSystemVaBitmap, Index, PageCount);
+        KeReleaseSpinLock(&MmpSystemVaLock);
+        KeLowerRunLevel(OldRunLevel);
+        return Status;
+    }
+
+    /* Mark all pages as reserved demand-zero memory */
+    PointerPte = MmpGetPteAddress(BaseAddress);
+    for(Page = 0; Page < PageCount; Page++)
+    {
+        PointerPte[Page].Long = 0;
+        PointerPte[Page].Software.Protection = MM_DEMAND_ZERO_PROTECTION;
+    }
+
+    /* Return virtual address */
+    *VirtualAddress = BaseAddress;
+    return STATUS_SUCCESS;
+}
+
+/**
+ * Unmaps a kernel stack, frees its physical pages and gives its virtual address range back to the kernel stacks pool.
+ *
+ * @param BaseAddress
+ *        Supplies the lowest mapped address of the kernel stack, right above its guard pages.
+ *
+ * @param MappedPages
+ *        Supplies the number of pages backed by physical memory, starting at the base address.
+ *
+ * @param StackPages
+ *        Supplies the size of the kernel stack in pages, excluding guard pages.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmpFreeKernelStackPages(IN PVOID BaseAddress,
+                        IN PFN_NUMBER MappedPages,
+                        IN PFN_NUMBER StackPages)
+{
+    KRUNLEVEL OldRunLevel;
+    PMMPTE PointerPte;
+    PFN_NUMBER Page;
+    ULONG_PTR Index;
+
+    /* Check if any page is mapped */
+    if(MappedPages)
+    {
+        /* Invalidate all PTEs, leaving page frame numbers in place */
+        PointerPte = MmpGetPteAddress(BaseAddress);
+        for(Page = 0; Page < MappedPages; Page++)
+        {
+            PointerPte[Page].Hardware.Valid = 0;
+        }
+
+        /* Make sure no processor can access the stack anymore */
+        MmFlushTlbRange(BaseAddress, MappedPages);
+
+        /* Give physical pages back to the PFN database */
+        for(Page = 0; Page < MappedPages; Page++)
+        {
+            /* Free the page and clear the PTE */
+            MmFreePhysicalPage(PointerPte[Page].Hardware.PageFrameNumber);
+            PointerPte[Page].Long = 0;
+        }
+    }
+
+    /* Raise runlevel and acquire kernel stacks pool lock */
+    OldRunLevel = KeRaiseRunLevel(DISPATCH_LEVEL);
+    KeAcquireSpinLock(&MmpKernelStackVaLock);
+
+    /* Give virtual address range, including guard pages, back to the kernel stacks pool */
+    Index = (((ULONG_PTR)BaseAddress - MM_KERNEL_STACK_VA_START) >> MM_PAGE_SHIFT) - KERNEL_STACK_GUARD_PAGES;
+    RtlClearBits(&MmpKernelStackVaBitmap, Index, StackPages + KERNEL_STACK_GUARD_PAGES);
+
+    /* Release kernel stacks pool lock and lower runlevel */
+    KeReleaseSpinLock(&MmpKernelStackVaLock);
+    KeLowerRunLevel(OldRunLevel);
 }
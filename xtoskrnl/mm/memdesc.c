@@ -0,0 +1,327 @@
+/**
+ * PROJECT:         ExectOS
+ * COPYRIGHT:       See COPYING.md in the top level directory
+ * FILE:            xtoskrnl/mm/memdesc.c
+ * DESCRIPTION:     Physical memory descriptors management
+ * DEVELOPERS:      Rafal Kupiec <belliash@codingworkshop.eu.org>
+ */
+
+#include <xtos.h>
+
+
+/**
+ * Looks up the physical memory descriptor describing the given page.
+ *
+ * @param PageFrameNumber
+ *        Supplies the page frame number to look up.
+ *
+ * @return This routine returns a pointer to the memory descriptor, or NULL if the page is not described.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+PMMMEMORY_DESCRIPTOR
+MmpFindMemoryDescriptor(IN PFN_NUMBER PageFrameNumber)
+{
+    PMMMEMORY_DESCRIPTOR Descriptor;
+    ULONG Index;
+
+    /* Find the last descriptor starting at or below the page */
+    Index = MmpGetMemoryDescriptorIndex(PageFrameNumber);
+    if(Index == 0)
+    {
+        /* Page lies below all descriptors */
+        return NULL;
+    }
+
+    /* Check if the descriptor covers the page */
+    Descriptor = &MmpMemoryDescriptors[Index - 1];
+    if(PageFrameNumber >= (PFN_NUMBER)Descriptor->BasePage + Descriptor->PageCount)
+    {
+        /* Page lies in a hole between descriptors */
+        return NULL;
+    }
+
+    /* Return memory descriptor */
+    return Descriptor;
+}
+
+/**
+ * Finds the number of physical memory descriptors starting at or below the given page, using binary search.
+ *
+ * @param PageFrameNumber
+ *        Supplies the page frame number.
+ *
+ * @return This routine returns the index of the first descriptor starting above the given page.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+ULONG
+MmpGetMemoryDescriptorIndex(IN PFN_NUMBER PageFrameNumber)
+{
+    ULONG High, Low, Middle;
+
+    /* Search the whole array */
+    Low = 0;
+    High = MmpMemoryDescriptorCount;
+
+    /* Narrow down the range until it points to the first descriptor starting above the page */
+    while(Low < High)
+    {
+        Middle = Low + ((High - Low) / 2);
+        if(MmpMemoryDescriptors[Middle].BasePage <= PageFrameNumber)
+        {
+            /* Descriptor starts at or below the page, look in the upper half */
+            Low = Middle + 1;
+        }
+        else
+        {
+            /* Descriptor starts above the page, look in the lower half */
+            High = Middle;
+        }
+    }
+
+    /* Return index */
+    return Low;
+}
+
+/**
+ * Copies the memory descriptors array provided by the boot loader into a compact array sorted by the base page,
+ * with adjacent descriptors of the same memory type merged.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmpInitializeMemoryDescriptors(VOID)
+{
+    PLOADER_MEMORY_DESCRIPTOR LoaderDescriptor;
+    PMMMEMORY_DESCRIPTOR Descriptor;
+    ULONG Index, LoaderIndex;
+
+    /* Start with an empty array */
+    MmpMemoryDescriptorCount = 0;
+
+    /* Iterate through memory descriptors array provided by the boot loader */
+    for(LoaderIndex = 0; LoaderIndex < KeInitializationBlock->MemoryDescriptorCount; LoaderIndex++)
+    {
+        /* Get memory descriptor */
+        LoaderDescriptor = &KeInitializationBlock->MemoryDescriptors[LoaderIndex];
+
+        /* Skip empty descriptors */
+        if(!LoaderDescriptor->PageCount)
+        {
+            continue;
+        }
+
+        /* Insert descriptor, boot loader sorts the array already, so it gets appended without moving others */
+        Index = MmpGetMemoryDescriptorIndex(LoaderDescriptor->BasePage);
+        if(MmpInsertMemoryDescriptor(Index, LoaderDescriptor->BasePage, LoaderDescriptor->PageCount,
+                                     LoaderDescriptor->MemoryType) != STATUS_SUCCESS)
+        {
+            /* Memory map too fragmented, kernel panic */
+            DebugPrint(L"Too many memory descriptors provided by the boot loader!\n");
+            KePanic(0);
+        }
+    }
+
+    /* Merge adjacent descriptors of the same memory type */
+    Index = 1;
+    while(Index < MmpMemoryDescriptorCount)
+    {
+        /* Check if descriptor continues the previous one */
+        Descriptor = &MmpMemoryDescriptors[Index];
+        if(Descriptor[-1].MemoryType == Descriptor->MemoryType &&
+           Descriptor[-1].BasePage + Descriptor[-1].PageCount == Descriptor->BasePage)
+        {
+            /* Extend the previous descriptor and remove this one */
+            Descriptor[-1].PageCount += Descriptor->PageCount;
+            MmpRemoveMemoryDescriptor(Index);
+            continue;
+        }
+
+        /* Go to the next descriptor */
+        Index++;
+    }
+}
+
+/**
+ * Inserts a new physical memory descriptor at the given position in the array.
+ *
+ * @param Index
+ *        Supplies the position of the new descriptor. It has to keep the array sorted.
+ *
+ * @param BasePage
+ *        Supplies the first page described by the new descriptor.
+ *
+ * @param PageCount
+ *        Supplies the number of pages described by the new descriptor.
+ *
+ * @param MemoryType
+ *        Specifies the memory type of the new descriptor.
+ *
+ * @return This routine returns a status code.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+XTSTATUS
+MmpInsertMemoryDescriptor(IN ULONG Index,
+                          IN PFN_NUMBER BasePage,
+                          IN PFN_NUMBER PageCount,
+                          IN LOADER_MEMORY_TYPE MemoryType)
+{
+    /* Make sure there is room for another descriptor */
+    if(MmpMemoryDescriptorCount >= MM_MAXIMUM_MEMORY_DESCRIPTORS)
+    {
+        /* Array is full, return error */
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    /* Make room for the new descriptor */
+    RtlMoveMemory(&MmpMemoryDescriptors[Index + 1], &MmpMemoryDescriptors[Index],
+                  (MmpMemoryDescriptorCount - Index) * sizeof(MMMEMORY_DESCRIPTOR));
+    MmpMemoryDescriptorCount++;
+
+    /* Keep the biggest free descriptor pointing to the same memory */
+    if(MmFreeDescriptor && MmFreeDescriptor >= &MmpMemoryDescriptors[Index])
+    {
+        MmFreeDescriptor++;
+    }
+
+    /* Fill the new descriptor */
+    MmpMemoryDescriptors[Index].BasePage = (ULONG)BasePage;
+    MmpMemoryDescriptors[Index].PageCount = (ULONG)PageCount;
+    MmpMemoryDescriptors[Index].MemoryType = MemoryType;
+
+    /* Return success */
+    return STATUS_SUCCESS;
+}
+
+/**
+ * Removes the physical memory descriptor at the given position from the array.
+ *
+ * @param Index
+ *        Supplies the position of the descriptor to remove.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmpRemoveMemoryDescriptor(IN ULONG Index)
+{
+    /* Keep the biggest free descriptor pointing to the same memory */
+    if(MmFreeDescriptor && MmFreeDescriptor > &MmpMemoryDescriptors[Index])
+    {
+        MmFreeDescriptor--;
+    }
+
+    /* Close the gap */
+    MmpMemoryDescriptorCount--;
+    RtlMoveMemory(&MmpMemoryDescriptors[Index], &MmpMemoryDescriptors[Index + 1],
+                  (MmpMemoryDescriptorCount - Index) * sizeof(MMMEMORY_DESCRIPTOR));
+}
+
+/**
+ * Changes the memory type of a range of pages, that is described by a single physical memory descriptor. The
+ * descriptor gets split if needed, while the range gets merged with the preceding descriptor of the same type.
+ *
+ * @param BasePage
+ *        Supplies the first page of the range.
+ *
+ * @param PageCount
+ *        Supplies the number of pages in the range.
+ *
+ * @param MemoryType
+ *        Specifies the new memory type of the range.
+ *
+ * @return This routine returns a status code.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+XTSTATUS
+MmpSetMemoryDescriptorType(IN PFN_NUMBER BasePage,
+                           IN PFN_NUMBER PageCount,
+                           IN LOADER_MEMORY_TYPE MemoryType)
+{
+    PMMMEMORY_DESCRIPTOR Descriptor;
+    PFN_NUMBER HeadPages, TailPages;
+    ULONG Index;
+
+    /* Find descriptor containing the range */
+    Descriptor = MmpFindMemoryDescriptor(BasePage);
+    if(!Descriptor || !PageCount || BasePage + PageCount > (PFN_NUMBER)Descriptor->BasePage + Descriptor->PageCount)
+    {
+        /* Range not described by a single descriptor, return error */
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    /* Check if memory type changes at all */
+    if(Descriptor->MemoryType == MemoryType)
+    {
+        /* Nothing to do */
+        return STATUS_SUCCESS;
+    }
+
+    /* Calculate the number of pages left before and after the range */
+    Index = (ULONG)(Descriptor - MmpMemoryDescriptors);
+    HeadPages = BasePage - Descriptor->BasePage;
+    TailPages = ((PFN_NUMBER)Descriptor->BasePage + Descriptor->PageCount) - (BasePage + PageCount);
+
+    /* Check if range starts the descriptor and continues the preceding descriptor of the same type */
+    if(!HeadPages && Index > 0 && MmpMemoryDescriptors[Index - 1].MemoryType == MemoryType &&
+       MmpMemoryDescriptors[Index - 1].BasePage + MmpMemoryDescriptors[Index - 1].PageCount == BasePage)
+    {
+        /* Move the range to the preceding descriptor */
+        MmpMemoryDescriptors[Index - 1].PageCount += (ULONG)PageCount;
+        Descriptor->BasePage += (ULONG)PageCount;
+        Descriptor->PageCount -= (ULONG)PageCount;
+
+        /* Check if descriptor has been fully consumed */
+        if(!Descriptor->PageCount)
+        {
+            /* Remove empty descriptor */
+            MmpRemoveMemoryDescriptor(Index);
+        }
+
+        /* Return success */
+        return STATUS_SUCCESS;
+    }
+
+    /* Make sure there is room for all descriptors needed to describe the split */
+    if(MmpMemoryDescriptorCount + (HeadPages ? 1 : 0) + (TailPages ? 1 : 0) > MM_MAXIMUM_MEMORY_DESCRIPTORS)
+    {
+        /* Array is full, return error */
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    /* Check if any pages are left after the range */
+    if(TailPages)
+    {
+        /* Describe the remaining pages with a new descriptor */
+        MmpInsertMemoryDescriptor(Index + 1, BasePage + PageCount, TailPages, Descriptor->MemoryType);
+        Descriptor->PageCount -= (ULONG)TailPages;
+    }
+
+    /* Check if any pages are left before the range */
+    if(HeadPages)
+    {
+        /* Trim the descriptor and describe the range with a new one */
+        Descriptor->PageCount = (ULONG)HeadPages;
+        MmpInsertMemoryDescriptor(Index + 1, BasePage, PageCount, MemoryType);
+    }
+    else
+    {
+        /* Range covers the beginning of the descriptor, change its type */
+        Descriptor->MemoryType = MemoryType;
+    }
+
+    /* Return success */
+    return STATUS_SUCCESS;
+}
@@ -0,0 +1,388 @@
+/**
+ * PROJECT:         ExectOS
+ * COPYRIGHT:       See COPYING.md in the top level directory
+ * FILE:            xtoskrnl/mm/numa.c
+ * DESCRIPTION:     Non-Uniform Memory Access (NUMA) topology support
+ * DEVELOPERS:      Rafal Kupiec <belliash@codingworkshop.eu.org>
+ */
+
+#include <xtos.h>
+
+
+/**
+ * Builds the node fallback lists, ordering all nodes by their distance from each node.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmpBuildNodeFallbackOrder(VOID)
+{
+    ULONG Index, Node, Position;
+    UCHAR Candidate;
+
+    /* Build fallback list for each node */
+    for(Node = 0; Node < MmpNodeCount; Node++)
+    {
+        /* Insert all nodes using insertion sort, nearest nodes go first */
+        for(Index = 0; Index < MmpNodeCount; Index++)
+        {
+            /* Find position for the next node */
+            Candidate = (UCHAR)Index;
+            Position = Index;
+            while(Position > 0 &&
+                  MmpNodeDistance[Node][MmpNodeFallbackOrder[Node][Position - 1]] > MmpNodeDistance[Node][Candidate])
+            {
+                /* Move farther node one position up */
+                MmpNodeFallbackOrder[Node][Position] = MmpNodeFallbackOrder[Node][Position - 1];
+                Position--;
+            }
+
+            /* Store the node */
+            MmpNodeFallbackOrder[Node][Position] = Candidate;
+        }
+    }
+}
+
+/**
+ * Translates the ACPI proximity domain into the memory manager node number, assigning a new node if needed.
+ *
+ * @param ProximityDomain
+ *        Supplies the ACPI proximity domain.
+ *
+ * @return This routine returns the node number.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+ULONG
+MmpGetNodeFromProximityDomain(IN ULONG ProximityDomain)
+{
+    ULONG Node;
+
+    /* Look for already known proximity domain */
+    for(Node = 0; Node < MmpNodeCount; Node++)
+    {
+        if(MmpNodeProximityDomain[Node] == ProximityDomain)
+        {
+            /* Proximity domain found, return its node */
+            return Node;
+        }
+    }
+
+    /* Make sure there is room for a new node */
+    if(MmpNodeCount == MM_MAXIMUM_NUMA_NODES)
+    {
+        /* Too many nodes, treat memory as belonging to the first node */
+        DebugPrint(L"Too many NUMA nodes, ignoring proximity domain %lu\n", ProximityDomain);
+        return 0;
+    }
+
+    /* Assign a new node */
+    MmpNodeProximityDomain[MmpNodeCount] = ProximityDomain;
+    return MmpNodeCount++;
+}
+
+/**
+ * Returns the color of a page with the given color index, belonging to the given node.
+ *
+ * @param NodeNumber
+ *        Supplies the node number.
+ *
+ * @param Color
+ *        Supplies the color index. Only the bits describing the colors within a single node are used.
+ *
+ * @return This routine returns the page color.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+ULONG
+MmpGetNodeColor(IN ULONG NodeNumber,
+                IN ULONG Color)
+{
+    /* Each node owns a separate subset of all colors */
+    return (NodeNumber << MmpSecondaryColorNodeShift) | (Color & MmpSecondaryColorMask);
+}
+
+/**
+ * Returns the color of the given physical page.
+ *
+ * @param PageFrameNumber
+ *        Supplies the page frame number.
+ *
+ * @return This routine returns the page color.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+ULONG
+MmpGetPageColor(IN PFN_NUMBER PageFrameNumber)
+{
+    /* Combine page node with its cache color */
+    return MmpGetNodeColor(MmPfnDatabase[PageFrameNumber].u4.NodeNumber, (ULONG)PageFrameNumber);
+}
+
+/**
+ * Looks up the node the given physical page belongs to.
+ *
+ * @param PageFrameNumber
+ *        Supplies the page frame number.
+ *
+ * @return This routine returns the node number.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+ULONG
+MmpGetPhysicalPageNode(IN PFN_NUMBER PageFrameNumber)
+{
+    ULONG Index;
+
+    /* Look for memory range containing the page */
+    for(Index = 0; Index < MmpNumaMemoryRangeCount; Index++)
+    {
+        if(PageFrameNumber >= MmpNumaMemoryRanges[Index].BasePage &&
+           PageFrameNumber < MmpNumaMemoryRanges[Index].BasePage + MmpNumaMemoryRanges[Index].PageCount)
+        {
+            /* Memory range found, return its node */
+            return MmpNumaMemoryRanges[Index].NodeNumber;
+        }
+    }
+
+    /* Memory not described by SRAT, assume first node */
+    return 0;
+}
+
+/**
+ * Looks up the node the given processor belongs to.
+ *
+ * @param CpuNumber
+ *        Supplies the processor number.
+ *
+ * @return This routine returns the node number.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+ULONG
+MmpGetProcessorNode(IN ULONG CpuNumber)
+{
+    /* Make sure processor is known */
+    if(!HlpSystemInfo.CpuInfo || CpuNumber >= HlpSystemInfo.CpuCount)
+    {
+        /* Unknown processor, assume first node */
+        return 0;
+    }
+
+    /* Return processor node */
+    return HlpSystemInfo.CpuInfo[CpuNumber].NodeNumber;
+}
+
+/**
+ * Discovers NUMA topology described by ACPI SRAT and SLIT tables. Memory ranges and processors get tagged with
+ * their node numbers and colored page lists are split between the nodes.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmpInitializeNumaTopology(VOID)
+{
+    ULONG ColorsPerNode, Index, Node, NodeBits;
+    PKPROCESSOR_CONTROL_BLOCK Prcb;
+    PACPI_SLIT Slit;
+    PACPI_SRAT Srat;
+
+    /* Start with a single node, describing all memory and processors */
+    MmpNodeCount = 1;
+    MmpNodeProximityDomain[0] = 0;
+    MmpNumaMemoryRangeCount = 0;
+
+    /* Get System Resource Affinity Table (SRAT) */
+    if(HlGetAcpiTable(ACPI_SRAT_SIGNATURE, (PACPI_DESCRIPTION_HEADER*)&Srat) == STATUS_SUCCESS && Srat)
+    {
+        /* Describe nodes found in SRAT */
+        MmpNodeCount = 0;
+        MmpParseResourceAffinityTable(Srat);
+
+        /* Make sure at least one node has been found */
+        if(MmpNodeCount == 0)
+        {
+            /* SRAT is empty, fall back to a single node */
+            MmpNodeCount = 1;
+        }
+    }
+
+    /* Initialize default distances between nodes */
+    for(Node = 0; Node < MmpNodeCount; Node++)
+    {
+        for(Index = 0; Index < MmpNodeCount; Index++)
+        {
+            MmpNodeDistance[Node][Index] = (Node == Index) ? MM_NUMA_LOCAL_DISTANCE : MM_NUMA_REMOTE_DISTANCE;
+        }
+    }
+
+    /* Get System Locality Information Table (SLIT) */
+    if(MmpNodeCount > 1 &&
+       HlGetAcpiTable(ACPI_SLIT_SIGNATURE, (PACPI_DESCRIPTION_HEADER*)&Slit) == STATUS_SUCCESS && Slit)
+    {
+        /* Make sure SLIT is big enough to describe all localities */
+        if(sizeof(ACPI_SLIT) + Slit->LocalityCount * Slit->LocalityCount <= Slit->Header.Length)
+        {
+            /* Store distances between all nodes, SLIT is indexed by proximity domains */
+            for(Node = 0; Node < MmpNodeCount; Node++)
+            {
+                for(Index = 0; Index < MmpNodeCount; Index++)
+                {
+                    /* Check if both proximity domains are described in SLIT */
+                    if(MmpNodeProximityDomain[Node] < Slit->LocalityCount &&
+                       MmpNodeProximityDomain[Index] < Slit->LocalityCount)
+                    {
+                        /* Store distance */
+                        MmpNodeDistance[Node][Index] = Slit->Entries[MmpNodeProximityDomain[Node] *
+                                                                     Slit->LocalityCount +
+                                                                     MmpNodeProximityDomain[Index]];
+                    }
+                }
+            }
+        }
+    }
+
+    /* Order nodes by distance for allocation fallback */
+    MmpBuildNodeFallbackOrder();
+
+    /* Split available page colors between nodes */
+    NodeBits = 0;
+    while(((ULONG)1 << NodeBits) < MmpNodeCount)
+    {
+        NodeBits++;
+    }
+    ColorsPerNode = MM_DEFAULT_SECONDARY_COLORS >> NodeBits;
+    if(ColorsPerNode == 0)
+    {
+        /* More nodes than colors, give each node a single color */
+        ColorsPerNode = 1;
+    }
+    MmpSecondaryColorMask = ColorsPerNode - 1;
+    MmpSecondaryColorNodeShift = RtlCountTrailingZeroes32(ColorsPerNode);
+
+    /* Store node of the boot processor */
+    Prcb = KeGetCurrentProcessorControlBlock();
+    Prcb->NodeNumber = (UCHAR)MmpGetProcessorNode(Prcb->CpuNumber);
+
+    /* Print NUMA topology summary */
+    DebugPrint(L"Discovered %lu NUMA node(s), %lu colors per node\n", MmpNodeCount, ColorsPerNode);
+}
+
+/**
+ * Parses the System Resource Affinity Table (SRAT), describing memory ranges and processors of all nodes.
+ *
+ * @param Srat
+ *        Supplies a pointer to the SRAT.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmpParseResourceAffinityTable(IN PACPI_SRAT Srat)
+{
+    PACPI_SRAT_X2APIC_CPU_AFFINITY X2ApicAffinity;
+    PACPI_SRAT_MEMORY_AFFINITY MemoryAffinity;
+    PACPI_SRAT_CPU_AFFINITY CpuAffinity;
+    PACPI_SUBTABLE_HEADER Subtable;
+    ULONG ApicId, CpuNumber, Node;
+    ULONG_PTR SratTable;
+
+    /* Traverse all SRAT subtables */
+    SratTable = (ULONG_PTR)Srat->AffinityTables;
+    while(SratTable + sizeof(ACPI_SUBTABLE_HEADER) <= (ULONG_PTR)Srat + Srat->Header.Length)
+    {
+        /* Get subtable header */
+        Subtable = (PACPI_SUBTABLE_HEADER)SratTable;
+        if(Subtable->Length == 0)
+        {
+            /* Malformed subtable, stop parsing */
+            break;
+        }
+
+        /* Check if this is a memory affinity subtable */
+        if(Subtable->Type == ACPI_SRAT_TYPE_MEMORY_AFFINITY && Subtable->Length == sizeof(ACPI_SRAT_MEMORY_AFFINITY))
+        {
+            /* Get memory affinity subtable */
+            MemoryAffinity = (PACPI_SRAT_MEMORY_AFFINITY)Subtable;
+
+            /* Make sure memory range is enabled and there is room to store it */
+            if((MemoryAffinity->Flags & ACPI_SRAT_MEMORY_ENABLED) && MemoryAffinity->Length &&
+               MmpNumaMemoryRangeCount < MM_MAXIMUM_NUMA_RANGES)
+            {
+                /* Store memory range */
+                Node = MmpGetNodeFromProximityDomain(MemoryAffinity->ProximityDomain);
+                MmpNumaMemoryRanges[MmpNumaMemoryRangeCount].BasePage = MemoryAffinity->BaseAddress >> MM_PAGE_SHIFT;
+                MmpNumaMemoryRanges[MmpNumaMemoryRangeCount].PageCount = MemoryAffinity->Length >> MM_PAGE_SHIFT;
+                MmpNumaMemoryRanges[MmpNumaMemoryRangeCount].NodeNumber = Node;
+                MmpNumaMemoryRangeCount++;
+            }
+        }
+        else if((Subtable->Type == ACPI_SRAT_TYPE_CPU_AFFINITY &&
+                 Subtable->Length == sizeof(ACPI_SRAT_CPU_AFFINITY)) ||
+                (Subtable->Type == ACPI_SRAT_TYPE_X2APIC_CPU_AFFINITY &&
+                 Subtable->Length == sizeof(ACPI_SRAT_X2APIC_CPU_AFFINITY)))
+        {
+            /* Check processor affinity subtable type */
+            if(Subtable->Type == ACPI_SRAT_TYPE_CPU_AFFINITY)
+            {
+                /* Get local APIC affinity subtable */
+                CpuAffinity = (PACPI_SRAT_CPU_AFFINITY)Subtable;
+                if(!(CpuAffinity->Flags & ACPI_SRAT_CPU_ENABLED))
+                {
+                    /* Processor disabled, go to the next subtable */
+                    SratTable += Subtable->Length;
+                    continue;
+                }
+
+                /* Get APIC ID and node number */
+                ApicId = CpuAffinity->ApicId;
+                Node = MmpGetNodeFromProximityDomain(CpuAffinity->ProximityDomainLow |
+                                                     (CpuAffinity->ProximityDomainHigh[0] << 8) |
+                                                     (CpuAffinity->ProximityDomainHigh[1] << 16) |
+                                                     ((ULONG)CpuAffinity->ProximityDomainHigh[2] << 24));
+            }
+            else
+            {
+                /* Get local X2APIC affinity subtable */
+                X2ApicAffinity = (PACPI_SRAT_X2APIC_CPU_AFFINITY)Subtable;
+                if(!(X2ApicAffinity->Flags & ACPI_SRAT_CPU_ENABLED))
+                {
+                    /* Processor disabled, go to the next subtable */
+                    SratTable += Subtable->Length;
+                    continue;
+                }
+
+                /* Get APIC ID and node number */
+                ApicId = X2ApicAffinity->ApicId;
+                Node = MmpGetNodeFromProximityDomain(X2ApicAffinity->ProximityDomain);
+            }
+
+            /* Tag processor with its node */
+            for(CpuNumber = 0; CpuNumber < HlpSystemInfo.CpuCount; CpuNumber++)
+            {
+                if(HlpSystemInfo.CpuInfo[CpuNumber].ApicId == ApicId)
+                {
+                    /* Processor found, store its node */
+                    HlpSystemInfo.CpuInfo[CpuNumber].NodeNumber = (UCHAR)Node;
+                    break;
+                }
+            }
+        }
+
+        /* Go to the next subtable */
+        SratTable += Subtable->Length;
+    }
+}
@@ -10,7 +10,7 @@
 
 
 /**
- * Flushes current Translation Lookaside Buffer (TLB)
+ * Flushes current Translation Lookaside Buffer (TLB), including global entries.
  *
  * @return This routine does not return any value.
  *
@@ -20,20 +20,24 @@ XTAPI
 VOID
 MmFlushTlb(VOID)
 {
-    CPUID_REGISTERS CpuRegisters;
     BOOLEAN Interrupts;
+    ULONG FeatureBits;
     ULONG_PTR Cr4;
 
     /* Save interrupts state and disable them */
     Interrupts = ArInterruptsEnabled();
     ArClearInterruptFlag();
 
-    /* Get CPU features */
-    CpuRegisters.Leaf = CPUID_GET_CPU_FEATURES;
-    ArCpuId(&CpuRegisters);
+    /* Get TLB management features cached at boot */
+    FeatureBits = KeGetCurrentProcessorControlBlock()->CpuId.FeatureBits;
 
-    /* Check if Paging Global Extensions (PGE) is supported */
-    if(CpuRegisters.Edx & CPUID_FEATURES_EDX_PGE)
+    /* Check if INVPCID instruction is supported */
+    if(FeatureBits & KF_INVPCID)
+    {
+        /* Invalidate all TLB entries, including global ones */
+        ArInvalidatePcid(InvpcidAllContextsWithGlobals, 0, NULL);
+    }
+    else if(FeatureBits & KF_GLOBAL_PAGE)
     {
         /* Read CR4 */
         Cr4 = ArReadControlRegister(4);
@@ -60,3 +64,310 @@ MmFlushTlb(VOID)
         ArSetInterruptFlag();
     }
 }
+
+/**
+ * Invalidates all TLB entries queued in the batch, on all processors that might cache them.
+ *
+ * @param Batch
+ *        Supplies a pointer to the TLB flush batch. The batch is empty when this routine returns.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmFlushTlbBatch(IN OUT PMMTLB_FLUSH_BATCH Batch)
+{
+    KAFFINITY TargetProcessors;
+
+    /* Make sure there is anything to flush */
+    if(!Batch->FlushAll && !Batch->FlushCaches && !Batch->Count)
+    {
+        /* Nothing queued */
+        return;
+    }
+
+    /* Check if process mappings are going to be invalidated */
+    if(Batch->Process)
+    {
+        /* Processors not running the process get no IPI, they have to drop its PCID entries on next switch */
+        RtlAtomicExchangePointer((VOLATILE PVOID *)&Batch->Process->PcidStaleProcessors, (PVOID)MAXULONG_PTR);
+    }
+
+    /* Invalidate queued entries on the current processor */
+    MmpInvalidateTlbBatch(Batch);
+
+    /* Process mappings can be cached by processors running the process only, system mappings by all of them */
+    TargetProcessors = Batch->Process ? Batch->Process->ActiveProcessors : HlpActiveProcessors;
+    TargetProcessors &= ~((KAFFINITY)1 << KeGetCurrentProcessorNumber());
+
+    /* Check if any other processor needs to invalidate its TLB */
+    if(TargetProcessors)
+    {
+        /* Send TLB shootdown to other processors */
+        MmpSendTlbShootdown(Batch, TargetProcessors);
+    }
+
+    /* Empty the batch */
+    Batch->Count = 0;
+    Batch->FlushAll = FALSE;
+    Batch->FlushCaches = FALSE;
+}
+
+/**
+ * Invalidates TLB entries for the given range of system virtual addresses on all processors.
+ *
+ * @param VirtualAddress
+ *        Supplies the first virtual address to invalidate.
+ *
+ * @param PageCount
+ *        Supplies the number of pages to invalidate.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmFlushTlbRange(IN PVOID VirtualAddress,
+                IN PFN_NUMBER PageCount)
+{
+    MMTLB_FLUSH_BATCH Batch;
+
+    /* Queue the range and flush it */
+    MmInitializeTlbFlushBatch(&Batch, NULL);
+    MmQueueTlbFlush(&Batch, VirtualAddress, PageCount);
+    MmFlushTlbBatch(&Batch);
+}
+
+/**
+ * Initializes an empty TLB flush batch.
+ *
+ * @param Batch
+ *        Supplies a pointer to the TLB flush batch to initialize.
+ *
+ * @param Process
+ *        Supplies a pointer to the process owning the queued addresses, or NULL for system addresses.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmInitializeTlbFlushBatch(OUT PMMTLB_FLUSH_BATCH Batch,
+                          IN PKPROCESS Process)
+{
+    /* Initialize the batch */
+    Batch->Process = Process;
+    Batch->FlushAll = FALSE;
+    Batch->FlushCaches = FALSE;
+    Batch->Count = 0;
+}
+
+/**
+ * Queues a range of virtual addresses to be invalidated by the next MmFlushTlbBatch() call.
+ *
+ * @param Batch
+ *        Supplies a pointer to the TLB flush batch.
+ *
+ * @param VirtualAddress
+ *        Supplies the first virtual address to invalidate.
+ *
+ * @param PageCount
+ *        Supplies the number of pages to invalidate.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmQueueTlbFlush(IN OUT PMMTLB_FLUSH_BATCH Batch,
+                IN PVOID VirtualAddress,
+                IN PFN_NUMBER PageCount)
+{
+    ULONG_PTR Address;
+
+    /* Check if the whole TLB is going to be flushed anyway */
+    if(Batch->FlushAll)
+    {
+        /* Nothing to queue */
+        return;
+    }
+
+    /* Check if the range fits in the batch */
+    if(PageCount > MM_TLB_FLUSH_THRESHOLD - Batch->Count)
+    {
+        /* Too many pages to invalidate one by one, flush the whole TLB instead */
+        Batch->FlushAll = TRUE;
+        return;
+    }
+
+    /* Queue all pages in the range */
+    Address = (ULONG_PTR)PAGE_ALIGN(VirtualAddress);
+    while(PageCount--)
+    {
+        /* Queue the page and go to the next one */
+        Batch->VirtualAddress[Batch->Count++] = (PVOID)Address;
+        Address += MM_PAGE_SIZE;
+    }
+}
+
+/**
+ * Invalidates all TLB entries queued in the batch on the current processor.
+ *
+ * @param Batch
+ *        Supplies a pointer to the TLB flush batch.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmpInvalidateTlbBatch(IN PMMTLB_FLUSH_BATCH Batch)
+{
+    BOOLEAN TargetedInvalidation;
+    ULONG Index;
+
+    /* Process entries can be invalidated by PCID, even if another address space is loaded at the moment */
+    TargetedInvalidation = (Batch->Process && MmpPcidEnabled &&
+                            (KeGetCurrentProcessorControlBlock()->CpuId.FeatureBits & KF_INVPCID)) ? TRUE : FALSE;
+
+    /* Check if the whole TLB needs to be flushed */
+    if(Batch->FlushAll)
+    {
+        /* Process mappings are never global, so there is no need to flush global entries for them */
+        if(TargetedInvalidation)
+        {
+            /* Invalidate all entries tagged with the process PCID */
+            ArInvalidatePcid(InvpcidSingleContext, Batch->Process->Pcid, NULL);
+        }
+        else if(Batch->Process)
+        {
+            /* Flush non-global TLB entries */
+            ArFlushTlb();
+        }
+        else
+        {
+            /* Flush all TLB entries */
+            MmFlushTlb();
+        }
+    }
+    else
+    {
+        /* Invalidate all queued pages one by one */
+        for(Index = 0; Index < Batch->Count; Index++)
+        {
+            /* Check if targeted invalidation is possible */
+            if(TargetedInvalidation)
+            {
+                /* Invalidate TLB entry tagged with the process PCID */
+                ArInvalidatePcid(InvpcidIndividualAddress, Batch->Process->Pcid, Batch->VirtualAddress[Index]);
+            }
+            else
+            {
+                /* Invalidate TLB entry */
+                ArInvalidateTlbEntry(Batch->VirtualAddress[Index]);
+            }
+        }
+    }
+
+    /* Check if caches need to be written back, after TLB got invalidated so no stale translation can refill them */
+    if(Batch->FlushCaches)
+    {
+        /* Write back and invalidate processor caches */
+        ArWriteBackInvalidateCache();
+    }
+}
+
+/**
+ * Invalidates TLB entries requested by another processor. This routine is called from the IPI handler.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmpProcessTlbShootdown(VOID)
+{
+    KAFFINITY Processor, TargetProcessors;
+
+    /* Get current processor affinity */
+    Processor = (KAFFINITY)1 << KeGetCurrentProcessorNumber();
+
+    /* Check if this processor has been asked to invalidate its TLB */
+    if(!(MmpTlbShootdownTargets & Processor))
+    {
+        /* Nothing to do */
+        return;
+    }
+
+    /* Invalidate requested TLB entries */
+    MmpInvalidateTlbBatch(MmpTlbShootdownBatch);
+
+    /* Acknowledge the shootdown */
+    do
+    {
+        TargetProcessors = MmpTlbShootdownTargets;
+    }
+    while(RtlAtomicCompareExchangePointer((VOLATILE PVOID *)&MmpTlbShootdownTargets, (PVOID)TargetProcessors,
+                                          (PVOID)(TargetProcessors & ~Processor)) != (PVOID)TargetProcessors);
+}
+
+/**
+ * Sends a batched TLB shootdown to the given processors and waits until all of them acknowledge it.
+ *
+ * @param Batch
+ *        Supplies a pointer to the TLB flush batch to be processed by the other processors.
+ *
+ * @param TargetProcessors
+ *        Supplies a set of processors to send the TLB shootdown to.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmpSendTlbShootdown(IN PMMTLB_FLUSH_BATCH Batch,
+                    IN KAFFINITY TargetProcessors)
+{
+    KRUNLEVEL OldRunLevel;
+    ULONG CpuNumber;
+
+    /* Raise runlevel and acquire TLB shootdown lock, interrupts stay enabled so incoming shootdowns are served */
+    OldRunLevel = KeRaiseRunLevel(DISPATCH_LEVEL);
+    KeAcquireSpinLock(&MmpTlbShootdownLock);
+
+    /* Publish the batch */
+    MmpTlbShootdownBatch = Batch;
+    MmpTlbShootdownTargets = TargetProcessors;
+    ArMemoryBarrier();
+
+    /* Send IPI to all target processors */
+    for(CpuNumber = 0; CpuNumber < HlpSystemInfo.CpuCount; CpuNumber++)
+    {
+        /* Check if processor is a target */
+        if(TargetProcessors & ((KAFFINITY)1 << CpuNumber))
+        {
+            /* Send IPI to the processor */
+            HlpSendIpi(HlpSystemInfo.CpuInfo[CpuNumber].ApicId, APIC_VECTOR_IPI);
+        }
+    }
+
+    /* Wait until all target processors acknowledge the shootdown */
+    while(MmpTlbShootdownTargets)
+    {
+        /* Yield processor and keep waiting */
+        ArYieldProcessor();
+    }
+
+    /* Release TLB shootdown lock and lower runlevel */
+    MmpTlbShootdownBatch = NULL;
+    KeReleaseSpinLock(&MmpTlbShootdownLock);
+    KeLowerRunLevel(OldRunLevel);
+}
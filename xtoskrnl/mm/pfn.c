@@ -0,0 +1,957 @@
+/**
+ * PROJECT:         ExectOS
+ * COPYRIGHT:       See COPYING.md in the top level directory
+ * FILE:            xtoskrnl/mm/pfn.c
+ * DESCRIPTION:     Page Frame Number (PFN) database and physical page allocator
+ * DEVELOPERS:      Rafal Kupiec <belliash@codingworkshop.eu.org>
+ */
+
+#include <xtos.h>
+
+
+/**
+ * Allocates a single physical page from the PFN database.
+ *
+ * @param ZeroPage
+ *        Specifies whether the returned page has to be filled with zeroes.
+ *
+ * @param PageFrameNumber
+ *        Supplies a pointer to the variable that receives the page frame number of the allocated page.
+ *
+ * @return This routine returns a status code.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+XTSTATUS
+MmAllocatePhysicalPage(IN BOOLEAN ZeroPage,
+                       OUT PPFN_NUMBER PageFrameNumber)
+{
+    PKPROCESSOR_CONTROL_BLOCK Prcb;
+    PMMPAGE_MAGAZINE Magazine;
+    KRUNLEVEL OldRunLevel;
+    ULONG NodeNumber;
+    XTSTATUS Status;
+
+    /* Raise runlevel to DISPATCH level and get current processor control block */
+    OldRunLevel = KeRaiseRunLevel(DISPATCH_LEVEL);
+    Prcb = KeGetCurrentProcessorControlBlock();
+    Magazine = &Prcb->PageMagazine;
+
+    /* Check if the magazine is empty */
+    if(Magazine->Count == 0)
+    {
+        /* Refill the magazine from the global lists */
+        Magazine->Misses++;
+        KeAcquireSpinLock(&MmpPfnLock);
+        MmpRefillPageMagazine(Prcb);
+        KeReleaseSpinLock(&MmpPfnLock);
+    }
+    else
+    {
+        /* Page available on this processor */
+        Magazine->Hits++;
+    }
+
+    /* Check if there is any page in the magazine */
+    if(Magazine->Count != 0)
+    {
+        /* Take the most recently freed page, as it is likely still cached */
+        *PageFrameNumber = Magazine->Pages[--Magazine->Count];
+
+        /* Mark the page as in use */
+        MmPfnDatabase[*PageFrameNumber].u2.ShareCount = 1;
+        MmPfnDatabase[*PageFrameNumber].u3.e1.PageLocation = ActiveAndValid;
+        MmPfnDatabase[*PageFrameNumber].u3.e2.ReferenceCount = 1;
+
+        /* Lower runlevel */
+        KeLowerRunLevel(OldRunLevel);
+
+        /* Check if zeroed page was requested */
+        if(ZeroPage)
+        {
+            /* Zero the page, it is likely still cached, so cached stores are used */
+            Status = MmpZeroPhysicalPage(*PageFrameNumber, FALSE);
+            if(Status != STATUS_SUCCESS)
+            {
+                /* Failed to zero the page, give it back and return error */
+                MmFreePhysicalPage(*PageFrameNumber);
+                return Status;
+            }
+        }
+
+        /* Return success */
+        return STATUS_SUCCESS;
+    }
+
+    /* Get node of the current processor and lower runlevel */
+    NodeNumber = Prcb->NodeNumber;
+    KeLowerRunLevel(OldRunLevel);
+
+    /* Take a page from the colored lists, local to the current processor */
+    return MmAllocatePhysicalPageOnNode(NodeNumber, ZeroPage, PageFrameNumber);
+}
+
+/**
+ * Allocates a single physical page from the PFN database, preferring memory of the given NUMA node. Pages of other
+ * nodes are used, in the order of their distance, only if the given node is out of memory.
+ *
+ * @param NodeNumber
+ *        Supplies the preferred NUMA node number.
+ *
+ * @param ZeroPage
+ *        Specifies whether the returned page has to be filled with zeroes.
+ *
+ * @param PageFrameNumber
+ *        Supplies a pointer to the variable that receives the page frame number of the allocated page.
+ *
+ * @return This routine returns a status code.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+XTSTATUS
+MmAllocatePhysicalPageOnNode(IN ULONG NodeNumber,
+                             IN BOOLEAN ZeroPage,
+                             OUT PPFN_NUMBER PageFrameNumber)
+{
+    PKPROCESSOR_CONTROL_BLOCK Prcb;
+    KRUNLEVEL OldRunLevel;
+    MMPAGE_LIST PageList;
+    XTSTATUS Status;
+    ULONG Color;
+
+    /* Make sure the node exists */
+    if(NodeNumber >= MmpNodeCount)
+    {
+        /* Invalid node number, return error */
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    /* Raise runlevel to DISPATCH level and get current processor control block */
+    OldRunLevel = KeRaiseRunLevel(DISPATCH_LEVEL);
+    Prcb = KeGetCurrentProcessorControlBlock();
+
+    /* Get next page color of the node, so consecutive allocations spread across cache sets */
+    Color = MmpGetNodeColor(NodeNumber, Prcb->PageColor++);
+
+    /* Take a page from the colored lists */
+    KeAcquireSpinLock(&MmpPfnLock);
+    Status = MmpRemovePageByColor(Color, ZeroPage, PageFrameNumber, &PageList);
+    if(Status == STATUS_SUCCESS && ZeroPage && PageList != ZeroedPageList)
+    {
+        /* Idle loop zeroing did not keep up, count synchronous zeroing */
+        MmpSynchronousZeroCount++;
+    }
+    KeReleaseSpinLock(&MmpPfnLock);
+
+    /* Lower runlevel */
+    KeLowerRunLevel(OldRunLevel);
+
+    /* Check if page has been allocated */
+    if(Status != STATUS_SUCCESS)
+    {
+        /* Out of physical memory, return error */
+        return Status;
+    }
+
+    /* Check if zeroed page was requested, but page came from a different list */
+    if(ZeroPage && PageList != ZeroedPageList)
+    {
+        /* Zero the page synchronously */
+        Status = MmpZeroPhysicalPage(*PageFrameNumber, FALSE);
+        if(Status != STATUS_SUCCESS)
+        {
+            /* Failed to zero the page, give it back and return error */
+            MmFreePhysicalPage(*PageFrameNumber);
+            return Status;
+        }
+    }
+
+    /* Return success */
+    return STATUS_SUCCESS;
+}
+
+/**
+ * Returns a single physical page back to the PFN database.
+ *
+ * @param PageFrameNumber
+ *        Supplies the page frame number of the page to be freed.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmFreePhysicalPage(IN PFN_NUMBER PageFrameNumber)
+{
+    PKPROCESSOR_CONTROL_BLOCK Prcb;
+    PMMPAGE_MAGAZINE Magazine;
+    KRUNLEVEL OldRunLevel;
+    PMMPFN Pfn;
+
+    /* Raise runlevel and get current processor page magazine */
+    OldRunLevel = KeRaiseRunLevel(DISPATCH_LEVEL);
+    Prcb = KeGetCurrentProcessorControlBlock();
+    Magazine = &Prcb->PageMagazine;
+    Pfn = &MmPfnDatabase[PageFrameNumber];
+
+    /* Make sure the page is not already on one of the page lists or in a page magazine */
+    if(Pfn->u3.e1.PageLocation <= StandbyPageList)
+    {
+        /* Page already freed, ignore the request */
+        DebugPrint(L"Attempted to free page 0x%zX that is already free\n", PageFrameNumber);
+        KeLowerRunLevel(OldRunLevel);
+        return;
+    }
+
+    /* Check if the page belongs to another node */
+    if(Pfn->u4.NodeNumber != Prcb->NodeNumber)
+    {
+        /* Remote pages are not cached locally, return the page to the global lists of its node */
+        KeAcquireSpinLock(&MmpPfnLock);
+        MmpReleasePhysicalPage(PageFrameNumber);
+        KeReleaseSpinLock(&MmpPfnLock);
+        KeLowerRunLevel(OldRunLevel);
+
+        /* Request zeroing, if enough free pages are available */
+        MmpRequestPageZeroing();
+        return;
+    }
+
+    /* Check if the magazine is full */
+    if(Magazine->Count == MM_PAGE_MAGAZINE_SIZE)
+    {
+        /* Return half of the magazine to the global lists */
+        KeAcquireSpinLock(&MmpPfnLock);
+        MmpDrainPageMagazine(Magazine, MM_PAGE_MAGAZINE_SIZE / 2);
+        KeReleaseSpinLock(&MmpPfnLock);
+
+        /* Request zeroing, if enough free pages are available */
+        MmpRequestPageZeroing();
+    }
+
+    /* Mark the page as free, so freeing it again while cached gets detected */
+    Pfn->u3.e1.PageLocation = FreePageList;
+    Pfn->u3.e2.ReferenceCount = 0;
+
+    /* Cache the page on this processor */
+    Magazine->Pages[Magazine->Count++] = PageFrameNumber;
+
+    /* Lower runlevel */
+    KeLowerRunLevel(OldRunLevel);
+}
+
+/**
+ * Allocates physical pages for the memory manager before the PFN database gets initialized.
+ *
+ * @param PageCount
+ *        Supplies the number of pages to be allocated.
+ *
+ * @return This routine returns the page frame number of the first allocated page.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+PFN_NUMBER
+MmpAllocateBootstrapPages(IN PFN_NUMBER PageCount)
+{
+    PFN_NUMBER PageFrameNumber;
+
+    /* Make sure the free descriptor is big enough */
+    if(MmFreeDescriptor->PageCount < PageCount)
+    {
+        /* Not enough memory to bootstrap the memory manager, kernel panic */
+        DebugPrint(L"Insufficient memory to initialize the PFN database!\n");
+        KePanic(0);
+    }
+
+    /* Consume pages from the beginning of the free descriptor */
+    PageFrameNumber = MmFreeDescriptor->BasePage;
+    MmFreeDescriptor->BasePage += (ULONG)PageCount;
+    MmFreeDescriptor->PageCount -= (ULONG)PageCount;
+
+    /* Return page frame number */
+    return PageFrameNumber;
+}
+
+/**
+ * Allocates a physical page for internal memory manager structures, like page tables.
+ *
+ * @param PageFrameNumber
+ *        Supplies a pointer to the variable that receives the page frame number of the allocated page.
+ *
+ * @return This routine returns a status code.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+XTSTATUS
+MmpAllocateSystemPage(OUT PPFN_NUMBER PageFrameNumber)
+{
+    /* Check if PFN database is already initialized */
+    if(MmpPfnDatabaseInitialized)
+    {
+        /* Allocate page from the PFN database */
+        return MmAllocatePhysicalPage(FALSE, PageFrameNumber);
+    }
+
+    /* Take the page directly from the free descriptor */
+    *PageFrameNumber = MmpAllocateBootstrapPages(1);
+    return STATUS_SUCCESS;
+}
+
+/**
+ * Returns the oldest pages cached in the given page magazine to the global page lists. PFN database lock must be
+ * held by the caller.
+ *
+ * @param Magazine
+ *        Supplies a pointer to the page magazine to be drained.
+ *
+ * @param PageCount
+ *        Supplies the number of pages to be returned.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmpDrainPageMagazine(IN PMMPAGE_MAGAZINE Magazine,
+                     IN ULONG PageCount)
+{
+    ULONG Index;
+
+    /* Release the oldest pages, leaving the most recently freed ones in the magazine */
+    for(Index = 0; Index < PageCount; Index++)
+    {
+        MmpReleasePhysicalPage(Magazine->Pages[Index]);
+    }
+
+    /* Move remaining pages to the bottom of the magazine */
+    Magazine->Count -= PageCount;
+    RtlMoveMemory(Magazine->Pages, &Magazine->Pages[PageCount], Magazine->Count * sizeof(PFN_NUMBER));
+}
+
+/**
+ * Builds the PFN database from the memory descriptors provided by the boot loader.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmpInitializePfnDatabase(VOID)
+{
+    PFN_NUMBER BasePage, FreeBasePage, Page, PageCount;
+    PMMMEMORY_DESCRIPTOR Descriptor;
+    ULONG Color, Index, List;
+
+    /* Map memory backing the PFN database and initialize the buddy allocator */
+    MmpMapPfnDatabase();
+    MmpInitializeBuddyAllocator();
+
+    /* Initialize all colored page lists */
+    for(List = ZeroedPageList; List <= StandbyPageList; List++)
+    {
+        for(Color = 0; Color < MM_DEFAULT_SECONDARY_COLORS; Color++)
+        {
+            MmpFreePagesByColor[List][Color].Flink = MM_PFN_LIST_END;
+            MmpFreePagesByColor[List][Color].Blink = (PVOID)MM_PFN_LIST_END;
+            MmpFreePagesByColor[List][Color].Count = 0;
+        }
+
+        /* Reset list size */
+        MmpPageListCount[List] = 0;
+    }
+
+    /* Iterate through sorted memory descriptors */
+    for(Index = 0; Index < MmpMemoryDescriptorCount; Index++)
+    {
+        /* Get memory descriptor */
+        Descriptor = &MmpMemoryDescriptors[Index];
+
+        /* Skip memory that is invisible for the memory manager */
+        if(MmpVerifyMemoryTypeInvisible(Descriptor->MemoryType))
+        {
+            continue;
+        }
+
+        /* Check if this is the descriptor used to bootstrap the PFN database */
+        if(Descriptor == MmFreeDescriptor)
+        {
+            /* Describe the original range, pages consumed so far are in use */
+            BasePage = MmOldFreeDescriptor.BasePage;
+            PageCount = MmOldFreeDescriptor.PageCount;
+            FreeBasePage = MmFreeDescriptor->BasePage;
+        }
+        else
+        {
+            /* Use descriptor as is */
+            BasePage = Descriptor->BasePage;
+            PageCount = Descriptor->PageCount;
+            FreeBasePage = (Descriptor->MemoryType == LoaderFree) ? BasePage : BasePage + PageCount;
+        }
+
+        /* Never hand out the first physical page */
+        if(FreeBasePage == 0)
+        {
+            FreeBasePage = 1;
+        }
+
+        /* Limit free range to the descriptor */
+        if(FreeBasePage > BasePage + PageCount)
+        {
+            FreeBasePage = BasePage + PageCount;
+        }
+
+        /* Tag pages with the NUMA node they belong to, page database is zeroed so pages default to the first node */
+        if(MmpNodeCount > 1)
+        {
+            for(Page = BasePage; Page < BasePage + PageCount; Page++)
+            {
+                MmPfnDatabase[Page].u4.NodeNumber = MmpGetPhysicalPageNode(Page);
+            }
+        }
+
+        /* Mark pages in use */
+        for(Page = BasePage; Page < FreeBasePage; Page++)
+        {
+            MmPfnDatabase[Page].u3.e1.PageLocation = ActiveAndValid;
+            MmPfnDatabase[Page].u3.e2.ReferenceCount = 1;
+            MmPfnDatabase[Page].u2.ShareCount = 1;
+        }
+
+        /* Give the remaining pages to the buddy allocator */
+        if(FreeBasePage < BasePage + PageCount)
+        {
+            MmpFreeBuddyRange(FreeBasePage, BasePage + PageCount - FreeBasePage);
+        }
+    }
+
+    /* Mark PFN database as initialized */
+    MmpPfnDatabaseInitialized = TRUE;
+}
+
+/**
+ * Inserts a page into the given colored page list. PFN database lock must be held by the caller.
+ *
+ * @param PageFrameNumber
+ *        Supplies the page frame number of the page to be inserted.
+ *
+ * @param ListName
+ *        Specifies the list the page is inserted to. Only zeroed, free and standby lists are supported.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmpInsertPageInColorList(IN PFN_NUMBER PageFrameNumber,
+                         IN MMPAGE_LIST ListName)
+{
+    PMMCOLOR_TABLES ColorTable;
+    PMMPFN Pfn, TailPfn;
+
+    /* Get PFN entry and its color table */
+    Pfn = &MmPfnDatabase[PageFrameNumber];
+    ColorTable = &MmpFreePagesByColor[ListName][MmpGetPageColor(PageFrameNumber)];
+
+    /* Update page state */
+    Pfn->u3.e1.PageLocation = ListName;
+    Pfn->u3.e2.ReferenceCount = 0;
+    Pfn->PteAddress = NULL;
+
+    /* Check if page goes to the standby list */
+    if(ListName == StandbyPageList)
+    {
+        /* Standby pages are reused in the order they were released, so append at the tail */
+        Pfn->u1.Flink = MM_PFN_LIST_END;
+        if(ColorTable->Flink == MM_PFN_LIST_END)
+        {
+            /* List is empty */
+            Pfn->u2.Blink = MM_PFN_LIST_END;
+            ColorTable->Flink = PageFrameNumber;
+        }
+        else
+        {
+            /* Link after the current tail */
+            TailPfn = (PMMPFN)ColorTable->Blink;
+            Pfn->u2.Blink = (PFN_NUMBER)(TailPfn - MmPfnDatabase);
+            TailPfn->u1.Flink = PageFrameNumber;
+        }
+
+        /* Page becomes the new tail */
+        ColorTable->Blink = Pfn;
+    }
+    else
+    {
+        /* Recently freed pages are likely still cached, so insert them at the head */
+        Pfn->u2.Blink = MM_PFN_LIST_END;
+        Pfn->u1.Flink = ColorTable->Flink;
+        if(ColorTable->Flink == MM_PFN_LIST_END)
+        {
+            /* List is empty, page becomes the tail as well */
+            ColorTable->Blink = Pfn;
+        }
+        else
+        {
+            /* Link in front of the current head */
+            MmPfnDatabase[ColorTable->Flink].u2.Blink = PageFrameNumber;
+        }
+
+        /* Page becomes the new head */
+        ColorTable->Flink = PageFrameNumber;
+    }
+
+    /* Update counters */
+    ColorTable->Count++;
+    MmpPageListCount[ListName]++;
+    MmAvailablePages++;
+}
+
+/**
+ * Maps a range of kernel virtual memory with zeroed pages taken directly from the free descriptor. This is used to
+ * back memory manager structures before the PFN database gets initialized.
+ *
+ * @param VirtualAddress
+ *        Supplies the page aligned virtual address to be mapped.
+ *
+ * @param PageCount
+ *        Supplies the number of pages to be mapped.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmpMapBootstrapMemory(IN PVOID VirtualAddress,
+                      IN PFN_NUMBER PageCount)
+{
+    ULONG_PTR Address, EndAddress;
+    PMMPTE PointerPte;
+
+    /* Make sure all page tables are present */
+    if(MmpMapPageTables(VirtualAddress, PageCount) != STATUS_SUCCESS)
+    {
+        /* Failed to map page tables, kernel panic */
+        DebugPrint(L"Failed to map memory manager structures!\n");
+        KePanic(0);
+    }
+
+    /* Back the range with physical pages */
+    Address = (ULONG_PTR)VirtualAddress;
+    EndAddress = Address + (PageCount << MM_PAGE_SHIFT);
+    while(Address < EndAddress)
+    {
+        /* Check if this part is not mapped yet (ranges can share pages) */
+        PointerPte = MmpGetPteAddress((PVOID)Address);
+        if(!PointerPte->Hardware.Valid)
+        {
+            /* Map new page and zero it */
+            PointerPte->Long = 0;
+            PointerPte->Hardware.PageFrameNumber = MmpAllocateBootstrapPages(1);
+            PointerPte->Hardware.Valid = 1;
+            PointerPte->Hardware.Writable = 1;
+            MmZeroPages((PVOID)Address, MM_PAGE_SIZE);
+        }
+
+        /* Go to the next page */
+        Address += MM_PAGE_SIZE;
+    }
+}
+
+/**
+ * Maps the memory backing the PFN database. Only parts describing physical memory known to the memory manager
+ * are backed by physical pages.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmpMapPfnDatabase(VOID)
+{
+    PMMMEMORY_DESCRIPTOR Descriptor;
+    ULONG_PTR Address, EndAddress;
+    PFN_NUMBER BasePage, PageCount;
+    ULONG Index;
+
+    /* Iterate through sorted memory descriptors */
+    for(Index = 0; Index < MmpMemoryDescriptorCount; Index++)
+    {
+        /* Get memory descriptor */
+        Descriptor = &MmpMemoryDescriptors[Index];
+
+        /* Skip memory that is invisible for the memory manager */
+        if(MmpVerifyMemoryTypeInvisible(Descriptor->MemoryType))
+        {
+            continue;
+        }
+
+        /* Use the original range of the free descriptor, as it shrinks while pages are consumed */
+        if(Descriptor == MmFreeDescriptor)
+        {
+            BasePage = MmOldFreeDescriptor.BasePage;
+            PageCount = MmOldFreeDescriptor.PageCount;
+        }
+        else
+        {
+            BasePage = Descriptor->BasePage;
+            PageCount = Descriptor->PageCount;
+        }
+
+        /* Calculate the PFN database range describing this descriptor */
+        Address = (ULONG_PTR)PAGE_ALIGN(&MmPfnDatabase[BasePage]);
+        EndAddress = ROUND_UP((ULONG_PTR)&MmPfnDatabase[BasePage + PageCount], MM_PAGE_SIZE);
+
+        /* Back the range with physical pages */
+        MmpMapBootstrapMemory((PVOID)Address, (EndAddress - Address) >> MM_PAGE_SHIFT);
+    }
+}
+
+/**
+ * Refills the page magazine of the given processor with a batch of pages taken from the global page lists. Pages
+ * are taken in consecutive colors of the processor's node, so allocations served from the magazine are local and
+ * still spread across cache sets. PFN database lock must be held by the caller.
+ *
+ * @param Prcb
+ *        Supplies a pointer to the processor control block owning the magazine.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmpRefillPageMagazine(IN PKPROCESSOR_CONTROL_BLOCK Prcb)
+{
+    PMMPAGE_MAGAZINE Magazine;
+    PFN_NUMBER PageFrameNumber;
+    MMPAGE_LIST PageList;
+    ULONG Color;
+
+    /* Get processor page magazine */
+    Magazine = &Prcb->PageMagazine;
+
+    /* Fill half of the magazine, leaving room for pages freed on this processor */
+    while(Magazine->Count < MM_PAGE_MAGAZINE_SIZE / 2)
+    {
+        /* Take a page of the next color */
+        Color = MmpGetNodeColor(Prcb->NodeNumber, Prcb->PageColor++);
+        if(MmpRemovePageByColor(Color, FALSE, &PageFrameNumber, &PageList) != STATUS_SUCCESS)
+        {
+            /* Out of physical memory */
+            break;
+        }
+
+        /* Mark the page as free and put it into the magazine */
+        MmPfnDatabase[PageFrameNumber].u3.e1.PageLocation = FreePageList;
+        MmPfnDatabase[PageFrameNumber].u3.e2.ReferenceCount = 0;
+        Magazine->Pages[Magazine->Count++] = PageFrameNumber;
+    }
+}
+
+/**
+ * Returns a single physical page to the colored free lists or, if they hold enough pages already, to the buddy
+ * allocator. PFN database lock must be held by the caller.
+ *
+ * @param PageFrameNumber
+ *        Supplies the page frame number of the page to be released.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmpReleasePhysicalPage(IN PFN_NUMBER PageFrameNumber)
+{
+    /* Check if colored lists hold enough pages already */
+    if(MmpPageListCount[FreePageList] >= MM_MAXIMUM_COLORED_FREE_PAGES)
+    {
+        /* Return the page to the buddy allocator */
+        MmpFreeBuddyRange(PageFrameNumber, 1);
+    }
+    else
+    {
+        /* Insert the page into the free list */
+        MmpInsertPageInColorList(PageFrameNumber, FreePageList);
+    }
+}
+
+/**
+ * Removes a page of the given color from the page lists. PFN database lock must be held by the caller.
+ *
+ * @param Color
+ *        Specifies the preferred page color, which also determines the preferred NUMA node. Pages of other colors
+ *        of the same node are used only if there is no page of this color, while pages of other nodes are used
+ *        only if the node is out of memory.
+ *
+ * @param ZeroPage
+ *        Specifies whether zeroed pages should be preferred.
+ *
+ * @param PageFrameNumber
+ *        Supplies a pointer to the variable that receives the page frame number of the removed page.
+ *
+ * @param PageList
+ *        Supplies a pointer to the variable that receives the list the page was taken from.
+ *
+ * @return This routine returns a status code.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+XTSTATUS
+MmpRemovePageByColor(IN ULONG Color,
+                     IN BOOLEAN ZeroPage,
+                     OUT PPFN_NUMBER PageFrameNumber,
+                     OUT PMMPAGE_LIST PageList)
+{
+    ULONG Index, Node, NodeColor, NodeNumber;
+    MMPAGE_LIST ListOrder[3];
+
+    /* Prefer zeroed pages only when asked for them, so they are not wasted on callers overwriting pages anyway */
+    ListOrder[0] = ZeroPage ? ZeroedPageList : FreePageList;
+    ListOrder[1] = ZeroPage ? FreePageList : ZeroedPageList;
+    ListOrder[2] = StandbyPageList;
+
+    /* Get node the requested color belongs to */
+    NodeNumber = Color >> MmpSecondaryColorNodeShift;
+
+    /* Try all nodes, nearest first */
+    for(Node = 0; Node < MmpNodeCount; Node++)
+    {
+        /* Get requested color on this node */
+        NodeColor = MmpGetNodeColor(MmpNodeFallbackOrder[NodeNumber][Node], Color);
+
+        /* Try requested color first */
+        if(MmpRemovePageFromColorTables(NodeColor, ListOrder, PageFrameNumber, PageList) == STATUS_SUCCESS)
+        {
+            /* Page found */
+            return STATUS_SUCCESS;
+        }
+
+        /* Refill colored lists from the buddy allocator of this node and try requested color again */
+        if(MmpRefillColorLists(MmpNodeFallbackOrder[NodeNumber][Node]) == STATUS_SUCCESS &&
+           MmpRemovePageFromColorTables(NodeColor, ListOrder, PageFrameNumber, PageList) == STATUS_SUCCESS)
+        {
+            /* Page found */
+            return STATUS_SUCCESS;
+        }
+
+        /* Fall back to the neighbouring colors of this node */
+        for(Index = 1; Index <= MmpSecondaryColorMask; Index++)
+        {
+            /* Try next color */
+            if(MmpRemovePageFromColorTables(MmpGetNodeColor(MmpNodeFallbackOrder[NodeNumber][Node], Color + Index),
+                                            ListOrder, PageFrameNumber, PageList) == STATUS_SUCCESS)
+            {
+                /* Page found */
+                return STATUS_SUCCESS;
+            }
+        }
+    }
+
+    /* No free pages left */
+    *PageFrameNumber = 0;
+    return STATUS_INSUFFICIENT_RESOURCES;
+}
+
+/**
+ * Unlinks a page from the colored page list it is currently on and marks it as in use. PFN database lock must be
+ * held by the caller.
+ *
+ * @param PageFrameNumber
+ *        Supplies the page frame number of the page to be removed.
+ *
+ * @return This routine does not return any value.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmpRemovePageFromColorList(IN PFN_NUMBER PageFrameNumber)
+{
+    PMMCOLOR_TABLES ColorTable;
+    PFN_NUMBER Flink, Blink;
+    MMPAGE_LIST ListName;
+    PMMPFN Pfn;
+
+    /* Get PFN entry, its list and color table */
+    Pfn = &MmPfnDatabase[PageFrameNumber];
+    ListName = Pfn->u3.e1.PageLocation;
+    ColorTable = &MmpFreePagesByColor[ListName][MmpGetPageColor(PageFrameNumber)];
+    Flink = Pfn->u1.Flink;
+    Blink = Pfn->u2.Blink;
+
+    /* Update forward link of the previous page */
+    if(Blink == MM_PFN_LIST_END)
+    {
+        /* Page was the list head */
+        ColorTable->Flink = Flink;
+    }
+    else
+    {
+        /* Link previous page with the next one */
+        MmPfnDatabase[Blink].u1.Flink = Flink;
+    }
+
+    /* Update backward link of the next page */
+    if(Flink == MM_PFN_LIST_END)
+    {
+        /* Page was the list tail */
+        ColorTable->Blink = (Blink == MM_PFN_LIST_END) ? (PVOID)MM_PFN_LIST_END : &MmPfnDatabase[Blink];
+    }
+    else
+    {
+        /* Link next page with the previous one */
+        MmPfnDatabase[Flink].u2.Blink = Blink;
+    }
+
+    /* Update counters */
+    ColorTable->Count--;
+    MmpPageListCount[ListName]--;
+    MmAvailablePages--;
+
+    /* Mark the page as in use */
+    Pfn->u1.Flink = 0;
+    Pfn->u2.ShareCount = 1;
+    Pfn->u3.e1.PageLocation = ActiveAndValid;
+    Pfn->u3.e2.ReferenceCount = 1;
+}
+
+/**
+ * Removes the first page of the given color from the colored page lists, checking the lists in the given order.
+ * PFN database lock must be held by the caller.
+ *
+ * @param Color
+ *        Specifies the page color.
+ *
+ * @param ListOrder
+ *        Supplies an array of three page lists, in the order they should be checked.
+ *
+ * @param PageFrameNumber
+ *        Supplies a pointer to the variable that receives the page frame number of the removed page.
+ *
+ * @param PageList
+ *        Supplies a pointer to the variable that receives the list the page was taken from.
+ *
+ * @return This routine returns a status code.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+XTSTATUS
+MmpRemovePageFromColorTables(IN ULONG Color,
+                             IN PMMPAGE_LIST ListOrder,
+                             OUT PPFN_NUMBER PageFrameNumber,
+                             OUT PMMPAGE_LIST PageList)
+{
+    PMMCOLOR_TABLES ColorTable;
+    ULONG List;
+
+    /* Try all lists for this color */
+    for(List = 0; List < 3; List++)
+    {
+        /* Check if there is any page on this list */
+        ColorTable = &MmpFreePagesByColor[ListOrder[List]][Color];
+        if(ColorTable->Flink != MM_PFN_LIST_END)
+        {
+            /* Remove the first page from the list */
+            *PageFrameNumber = ColorTable->Flink;
+            *PageList = ListOrder[List];
+            MmpRemovePageFromColorList(*PageFrameNumber);
+
+            /* Return success */
+            return STATUS_SUCCESS;
+        }
+    }
+
+    /* No pages of this color */
+    return STATUS_NOT_FOUND;
+}
+
+/**
+ * Fills the given physical page with zeroes. The page is mapped at the current processor's zeroing address, that is
+ * never used by other processors, so only the local TLB entry needs to be invalidated and no IPI is ever sent.
+ *
+ * @param PageFrameNumber
+ *        Supplies the page frame number of the page to be zeroed.
+ *
+ * @param NonTemporal
+ *        Specifies whether the page should be zeroed without polluting the caches.
+ *
+ * @return This routine returns a status code.
+ *
+ * @note This routine must not be called above DISPATCH level, as the zeroing address cannot be shared.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+XTSTATUS
+MmpZeroPhysicalPage(IN PFN_NUMBER PageFrameNumber,
+                    IN BOOLEAN NonTemporal)
+{
+    PHYSICAL_ADDRESS PhysicalAddress;
+    PKPROCESSOR_CONTROL_BLOCK Prcb;
+    KRUNLEVEL OldRunLevel;
+    PMMPTE PointerPte;
+    XTSTATUS Status;
+
+    /* Raise runlevel to DISPATCH level, so the thread cannot be moved to another processor */
+    OldRunLevel = KeRaiseRunLevel(DISPATCH_LEVEL);
+    Prcb = KeGetCurrentProcessorControlBlock();
+
+    /* Check if processor has its own zeroing address already */
+    if(!Prcb->ZeroingAddress)
+    {
+        /* Reserve zeroing address in the hardware layer memory pool, mapping the page straight away */
+        PhysicalAddress.QuadPart = (ULONGLONG)PageFrameNumber << MM_PAGE_SHIFT;
+        Status = MmMapHardwareMemory(PhysicalAddress, 1, MmCached, FALSE, &Prcb->ZeroingAddress);
+        if(Status != STATUS_SUCCESS)
+        {
+            /* Failed to reserve zeroing address, lower runlevel and return error */
+            KeLowerRunLevel(OldRunLevel);
+            return Status;
+        }
+
+        /* Drop any translation left in the local TLB by the previous user of the address */
+        ArInvalidateTlbEntry(Prcb->ZeroingAddress);
+        PointerPte = MmpGetPteAddress(Prcb->ZeroingAddress);
+    }
+    else
+    {
+        /* Map the page, not present entries are never cached in TLB so no flush is needed */
+        PointerPte = MmpGetPteAddress(Prcb->ZeroingAddress);
+        PointerPte->Long = 0;
+        PointerPte->Hardware.PageFrameNumber = PageFrameNumber;
+        PointerPte->Hardware.Valid = 1;
+        PointerPte->Hardware.Writable = 1;
+    }
+
+    /* Zero the page */
+    if(NonTemporal)
+    {
+        /* Zero the page without polluting the caches */
+        MmZeroPagesNonTemporal(Prcb->ZeroingAddress, MM_PAGE_SIZE);
+    }
+    else
+    {
+        /* Zero the page, leaving it in caches for the caller */
+        MmZeroPages(Prcb->ZeroingAddress, MM_PAGE_SIZE);
+    }
+
+    /* Unmap the page, address is used by this processor only, so invalidating local TLB entry is enough */
+    PointerPte->Long = 0;
+    ArInvalidateTlbEntry(Prcb->ZeroingAddress);
+
+    /* Lower runlevel and return success */
+    KeLowerRunLevel(OldRunLevel);
+    return STATUS_SUCCESS;
+}
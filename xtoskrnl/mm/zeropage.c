@@ -0,0 +1,142 @@
+/**
+ * PROJECT:         ExectOS
+ * COPYRIGHT:       See COPYING.md in the top level directory
+ * FILE:            xtoskrnl/mm/zeropage.c
+ * DESCRIPTION:     Background zeroing of free physical pages
+ * DEVELOPERS:      Rafal Kupiec <belliash@codingworkshop.eu.org>
+ */
+
+#include <xtos.h>
+
+
+/**
+ * Zeroes a batch of free pages, if zeroing has been requested. It is called by the idle loop, so pages get zeroed
+ * only when processor has nothing else to do and demand-zero allocations rarely have to do it synchronously.
+ *
+ * @return This routine returns TRUE if any pages have been zeroed, or FALSE if there is nothing to do.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+BOOLEAN
+MmZeroPagesOnIdle(VOID)
+{
+    /* Consume zeroing request, so a request made while zeroing is never lost */
+    if(!RtlAtomicExchange32((PLONG)&MmpZeroPageRequest, FALSE))
+    {
+        /* Nothing to do */
+        return FALSE;
+    }
+
+    /* Zero a batch of pages */
+    if(!MmpZeroFreePages())
+    {
+        /* Zeroed page target reached or no more free pages */
+        return FALSE;
+    }
+
+    /* Batch zeroed, keep going on the next idle iteration */
+    RtlAtomicExchange32((PLONG)&MmpZeroPageRequest, TRUE);
+    return TRUE;
+}
+
+/**
+ * Requests zeroing of free pages in the idle loop, once enough free pages are available.
+ *
+ * @return This routine does not return any value.
+ *
+ * @note This routine should be called after releasing the PFN database lock. Page list counters are read without
+ *       the lock, as they are used as a hint only.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+VOID
+MmpRequestPageZeroing(VOID)
+{
+    /* Check if enough free pages are available to be zeroed */
+    if(MmpPageListCount[FreePageList] >= MM_ZERO_PAGE_THRESHOLD &&
+       MmpPageListCount[ZeroedPageList] < MM_ZEROED_PAGES_TARGET && !MmpZeroPageRequest)
+    {
+        /* Request zeroing, avoid bouncing the cache line between processors if requested already */
+        RtlAtomicExchange32((PLONG)&MmpZeroPageRequest, TRUE);
+    }
+}
+
+/**
+ * Zeroes a batch of pages taken from the free lists and moves them to the zeroed lists.
+ *
+ * @return This routine returns the number of pages zeroed.
+ *
+ * @since XT 1.0
+ */
+XTAPI
+ULONG
+MmpZeroFreePages(VOID)
+{
+    PFN_NUMBER Pages[MM_ZERO_PAGE_BATCH];
+    BOOLEAN Zeroed[MM_ZERO_PAGE_BATCH];
+    KRUNLEVEL OldRunLevel;
+    ULONG Color, Index, PageCount;
+
+    /* Raise runlevel and acquire PFN database lock */
+    OldRunLevel = KeRaiseRunLevel(DISPATCH_LEVEL);
+    KeAcquireSpinLock(&MmpPfnLock);
+
+    /* Check if enough zeroed pages are available already */
+    if(MmpPageListCount[ZeroedPageList] >= MM_ZEROED_PAGES_TARGET)
+    {
+        /* Nothing to do */
+        KeReleaseSpinLock(&MmpPfnLock);
+        KeLowerRunLevel(OldRunLevel);
+        return 0;
+    }
+
+    /* Make sure there are free pages to be zeroed */
+    if(MmpPageListCount[FreePageList] == 0)
+    {
+        /* Take more pages from the buddy allocator */
+        MmpRefillColorLists(KeGetCurrentProcessorControlBlock()->NodeNumber);
+    }
+
+    /* Take a batch of free pages, one of each color */
+    PageCount = 0;
+    for(Color = 0; Color < MM_DEFAULT_SECONDARY_COLORS && PageCount < MM_ZERO_PAGE_BATCH; Color++)
+    {
+        /* Check if there is a free page of this color */
+        if(MmpFreePagesByColor[FreePageList][Color].Flink != MM_PFN_LIST_END)
+        {
+            /* Remove the page from the free list */
+            Pages[PageCount] = MmpFreePagesByColor[FreePageList][Color].Flink;
+            MmpRemovePageFromColorList(Pages[PageCount]);
+            PageCount++;
+        }
+    }
+
+    /* Release PFN database lock and lower runlevel */
+    KeReleaseSpinLock(&MmpPfnLock);
+    KeLowerRunLevel(OldRunLevel);
+
+    /* Zero all pages in the batch without polluting the caches, pages that failed to map go back to the free list */
+    for(Index = 0; Index < PageCount; Index++)
+    {
+        Zeroed[Index] = (MmpZeroPhysicalPage(Pages[Index], TRUE) == STATUS_SUCCESS) ? TRUE : FALSE;
+    }
+
+    /* Raise runlevel and acquire PFN database lock */
+    OldRunLevel = KeRaiseRunLevel(DISPATCH_LEVEL);
+    KeAcquireSpinLock(&MmpPfnLock);
+
+    /* Give the pages back, zeroed pages go to the zeroed list */
+    for(Index = 0; Index < PageCount; Index++)
+    {
+        MmpInsertPageInColorList(Pages[Index], Zeroed[Index] ? ZeroedPageList : FreePageList);
+    }
+
+    /* Release PFN database lock and lower runlevel */
+    KeReleaseSpinLock(&MmpPfnLock);
+    KeLowerRunLevel(OldRunLevel);
+
+    /* Return number of pages processed */
+    return PageCount;
+}
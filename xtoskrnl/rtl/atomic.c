@@ -720,8 +720,8 @@ RtlAtomicPopEntrySingleList(IN PSINGLE_LIST_HEADER Header)
 
         /* Compare and exchange */
         FirstEntry = (PVOID)RtlAtomicCompareExchange64((PLONG_PTR)ListHead,
-                                                       (LONG_PTR)FirstEntry->Next,
-                                                       (LONG_PTR)FirstEntry);
+                                                       (LONG_PTR)FirstEntry,
+                                                       (LONG_PTR)FirstEntry->Next);
     } while(FirstEntry != NextEntry);
 
     /* Return removed element */
@@ -762,8 +762,8 @@ RtlAtomicPushEntrySingleList(IN PSINGLE_LIST_HEADER Header,
 
         /* Compare and exchange */
         FirstEntry = (PVOID)RtlAtomicCompareExchange64((PLONG_PTR)ListHead,
-                                                       (LONG_PTR)ListEntry,
-                                                       (LONG_PTR)FirstEntry);
+                                                       (LONG_PTR)FirstEntry,
+                                                       (LONG_PTR)ListEntry);
     } while(FirstEntry != NextEntry);
 
     /* Return original first element */
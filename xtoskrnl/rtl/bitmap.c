@@ -53,7 +53,7 @@ RtlClearBit(IN PRTL_BITMAP BitMap,
     }
 
     /* Clear specified bit */
-    BitMap->Buffer[Bit / BITS_PER_LONG] &= ~(1 << (Bit & (BITS_PER_LONG - 1)));
+    BitMap->Buffer[Bit / BITS_PER_LONG] &= ~((ULONG_PTR)1 << (Bit & (BITS_PER_LONG - 1)));
 }
 
 /**
@@ -317,7 +317,7 @@ RtlSetBit(IN PRTL_BITMAP BitMap,
     }
 
     /* Set specified bit */
-    BitMap->Buffer[Bit / BITS_PER_LONG] |= 1 << (Bit & (BITS_PER_LONG - 1));
+    BitMap->Buffer[Bit / BITS_PER_LONG] |= (ULONG_PTR)1 << (Bit & (BITS_PER_LONG - 1));
 }
 
 /**
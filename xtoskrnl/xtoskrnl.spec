@@ -1,7 +1,15 @@
 # XTOS kernel exports
 @ fastcall ExAcquireRundownProtection(ptr)
+@ stdcall ExAllocateFromCache(ptr ptr)
+@ stdcall ExAllocatePoolWithTag(long long ptr)
 @ fastcall ExCompleteRundownProtection(ptr)
+@ stdcall ExCreateObjectCache(wstr long long ptr ptr ptr ptr)
+@ stdcall ExDestroyObjectCache(ptr)
+@ stdcall ExFreePool(ptr)
+@ stdcall ExFreePoolWithTag(ptr long)
+@ stdcall ExFreeToCache(ptr ptr)
 @ fastcall ExInitializeRundownProtection(ptr)
+@ stdcall ExReclaimObjectCaches()
 @ fastcall ExReInitializeRundownProtection(ptr)
 @ fastcall ExReleaseRundownProtection(ptr)
 @ fastcall ExWaitForRundownProtectionRelease(ptr)
@@ -11,16 +19,21 @@
 @ cdecl HlIoPortOutByte(ptr long)
 @ cdecl HlIoPortOutLong(ptr long)
 @ cdecl HlIoPortOutShort(ptr long)
+@ fastcall KeAcquireInStackQueuedSpinLock(ptr ptr)
 @ fastcall KeAcquireQueuedSpinLock(long)
 @ fastcall KeAcquireSpinLock(ptr)
+@ fastcall KeAcquireSpinLockExclusive(ptr)
+@ fastcall KeAcquireSpinLockShared(ptr)
 @ stdcall KeAcquireSystemResource(long ptr)
 @ stdcall KeCancelTimer(ptr)
+@ stdcall KeDumpLockStatistics()
 @ fastcall KeGetCurrentRunLevel()
 @ stdcall KeGetTimerState(ptr)
 @ stdcall KeGetSystemResource(long ptr)
 @ stdcall KeInitializeApc(ptr ptr long ptr ptr ptr long ptr)
 @ stdcall KeInitializeDpc(ptr ptr ptr)
 @ stdcall KeInitializeSemaphore(ptr long long)
+@ stdcall KeInitializeSharedSpinLock(ptr)
 @ stdcall KeInitializeSpinLock(ptr)
 @ stdcall KeInitializeThreadedDpc(ptr ptr ptr)
 @ stdcall KeInitializeTimer(ptr long)
@@ -28,13 +41,19 @@
 @ fastcall KeRaiseRunLevel(long)
 @ stdcall KeReadSemaphoreState(ptr)
 @ stdcall KeReleaseSemaphore(ptr long long long)
+@ fastcall KeReleaseInStackQueuedSpinLock(ptr)
 @ fastcall KeReleaseQueuedSpinLock(long)
 @ fastcall KeReleaseSpinLock(ptr)
+@ fastcall KeReleaseSpinLockExclusive(ptr)
+@ fastcall KeReleaseSpinLockShared(ptr)
 @ stdcall KeReleaseSystemResource(ptr)
 @ stdcall KeSetTargetProcessorDpc(ptr long)
 @ stdcall KeSetTimer(ptr long long long ptr)
 @ stdcall KeSignalCallDpcDone(ptr)
 @ stdcall KeSignalCallDpcSynchronize(ptr)
+@ fastcall KeTryConvertSharedSpinLockExclusive(ptr)
+@ stdcall MmFreeSystemPages(ptr long)
+@ stdcall MmReserveSystemPages(long ptr)
 @ stdcall RtlClearAllBits(ptr)
 @ stdcall RtlClearBit(ptr long)
 @ stdcall RtlClearBits(ptr long long)